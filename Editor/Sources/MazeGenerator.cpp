@@ -1,6 +1,7 @@
 #include "MazeGenerator.h"
 #include "MeshGraph.h"
 #include "MeshSetOperation.h"
+#include "TubeSweeper.h"
 #include "JSON/JsonValue.h"
 
 //------------------------------- MazeGenerator -------------------------------
@@ -175,6 +176,9 @@ bool MazeGenerator::GenerateMazeMeshes(std::list<MeshNinja::ConvexPolygonMesh*>&
 
 	std::set<MeshNinja::MeshGraph::VertexPair<false>> nodePairSet;
 
+	// Unless the tunnels are to be unioned with everything else, which needs them apart, they all go into one mesh.
+	MeshNinja::TubeSweeper tubeSweeper;
+
 	for (const Node* nodeA : this->nodeArray)
 	{
 		for (const Node* nodeB : nodeA->connectionArray)
@@ -184,45 +188,53 @@ bool MazeGenerator::GenerateMazeMeshes(std::list<MeshNinja::ConvexPolygonMesh*>&
 			{
 				nodePairSet.insert(nodePair);
 
-				MeshNinja::ConvexPolygonMesh* mesh = new MeshNinja::ConvexPolygonMesh();
-				meshList.push_back(mesh);
-
 				MeshNinja::Vector3 vector = nodeB->location - nodeA->location;
 				vector.Normalize();
 
 				MeshNinja::Vector3 pointA = nodeA->location + vector * radius / 2.0;
 				MeshNinja::Vector3 pointB = nodeB->location - vector * radius / 2.0;
 
-				if (!this->GenerateTunnelMesh(mesh, pointA, pointB, this->RandomInt(4, 8), radius / 3.0))
+				int sides = this->RandomInt(4, 8);
+
+				if (unionize)
+				{
+					MeshNinja::ConvexPolygonMesh* mesh = new MeshNinja::ConvexPolygonMesh();
+					meshList.push_back(mesh);
+
+					if (!this->GenerateTunnelMesh(mesh, pointA, pointB, sides, radius / 3.0))
+						return false;
+				}
+				else if (!tubeSweeper.AddPath(std::vector<MeshNinja::Vector3>{ pointA, pointB }, radius / 3.0, sides))
 					return false;
 			}
 		}
 	}
+
+	if (tubeSweeper.GetPathCount() > 0)
+	{
+		MeshNinja::ConvexPolygonMesh* mesh = new MeshNinja::ConvexPolygonMesh();
+		meshList.push_back(mesh);
+
+		if (!tubeSweeper.GenerateMesh(*mesh))
+			return false;
+	}
 	
 	if (unionize)
 	{
-		std::vector<MeshNinja::ConvexPolygon> nodePolygonArray;
-		std::vector<MeshNinja::ConvexPolygon> tunnelPolygonArray;
-		int i = 0;
-		for (MeshNinja::ConvexPolygonMesh* mesh : meshList)
-		{
-			if (i++ < (signed)this->nodeArray.size())
-				mesh->ToConvexPolygonArray(nodePolygonArray, true);
-			else
-				mesh->ToConvexPolygonArray(tunnelPolygonArray, true);
-			delete mesh;
-		}
-
-		meshList.clear();
-
-		MeshNinja::ConvexPolygonMesh nodesMesh(nodePolygonArray);
-		MeshNinja::ConvexPolygonMesh tunnelsMesh(tunnelPolygonArray);
+		std::vector<const MeshNinja::ConvexPolygonMesh*> meshArray(meshList.begin(), meshList.end());
 
 		MeshNinja::MeshUnion meshUnion;
 
 		MeshNinja::ConvexPolygonMesh* mazeMesh = new MeshNinja::ConvexPolygonMesh();
 		
-		if (!meshUnion.Perform(nodesMesh, tunnelsMesh, *mazeMesh))
+		bool unionized = meshUnion.PerformMany(meshArray, *mazeMesh);
+
+		for (MeshNinja::ConvexPolygonMesh* mesh : meshList)
+			delete mesh;
+
+		meshList.clear();
+
+		if (!unionized)
 		{
 			delete mazeMesh;
 			return false;
@@ -237,49 +249,12 @@ bool MazeGenerator::GenerateMazeMeshes(std::list<MeshNinja::ConvexPolygonMesh*>&
 
 bool MazeGenerator::GenerateTunnelMesh(MeshNinja::ConvexPolygonMesh* mesh, const MeshNinja::Vector3& pointA, const MeshNinja::Vector3& pointB, int sides, double radius) const
 {
-	MeshNinja::Vector3 zAxis = pointB - pointA;
-	zAxis.Normalize();
-	MeshNinja::Vector3 yAxis;
-	yAxis.MakeOrthogonalTo(zAxis);
-	yAxis.Normalize();
-	MeshNinja::Vector3 xAxis = yAxis.Cross(zAxis);
+	MeshNinja::TubeSweeper tubeSweeper;
 
-	std::vector<MeshNinja::Vector3> vertexArray[2];
-
-	for (int i = 0; i < sides; i++)
-	{
-		double angle = -2.0 * MESH_NINJA_PI * (double(i) / double(sides));
-		MeshNinja::Vector3 vector = (xAxis * ::cos(angle) + yAxis * ::sin(angle)) * radius;
-		vertexArray[0].push_back(pointA + vector);
-		vertexArray[1].push_back(pointB + vector);
-	}
-
-	std::vector<MeshNinja::ConvexPolygon> polygonArray;
-	for (int i = 0; i < sides; i++)
-	{
-		int j = (i + 1) % sides;
-		MeshNinja::ConvexPolygon polygon;
-		polygon.vertexArray->push_back(vertexArray[0][i]);
-		polygon.vertexArray->push_back(vertexArray[1][i]);
-		polygon.vertexArray->push_back(vertexArray[1][j]);
-		polygon.vertexArray->push_back(vertexArray[0][j]);
-		polygonArray.push_back(polygon);
-	}
-
-	for (int i = 0; i < 2; i++)
-	{
-		MeshNinja::ConvexPolygon cap;
-		for (int j = 0; j < sides; j++)
-		{
-			int k = (i == 0) ? j : (sides - 1 - j);
-			cap.vertexArray->push_back(vertexArray[i][k]);
-		}
-
-		polygonArray.push_back(cap);
-	}
+	if (!tubeSweeper.AddPath(std::vector<MeshNinja::Vector3>{ pointA, pointB }, radius, sides))
+		return false;
 
-	mesh->FromConvexPolygonArray(polygonArray);
-	return true;
+	return tubeSweeper.GenerateMesh(*mesh);
 }
 
 bool MazeGenerator::WriteJsonNavigationFile(const std::string& filePath) const
@@ -111,13 +111,11 @@ void Mesh::IssueColor(const MeshNinja::Vector3& givenColor) const
 	{
 		this->renderMeshDirty = false;
 		
-		MeshNinja::ConvexPolygonMesh tessellatedMesh(this->mesh);
-		tessellatedMesh.TessellateFaces();
-
 		MeshNinja::RenderMesh::Options options;
 		options.normalType = MeshNinja::RenderMesh::Options::NormalType::FACET_BASED;
+		options.triangulate = true;
 
-		this->renderMesh.FromConvexPolygonMesh(tessellatedMesh, options);
+		this->renderMesh.FromConvexPolygonMesh(this->mesh, options);
 		this->renderMesh.MakeRainbowColors();
 
 		this->meshGraph.Generate(this->mesh);
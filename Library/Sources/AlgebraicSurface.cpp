@@ -1,5 +1,6 @@
 #include "AlgebraicSurface.h"
 #include "Ray.h"
+#include "AxisAlignedBoundingBox.h"
 
 using namespace MeshNinja;
 
@@ -13,9 +14,20 @@ AlgebraicSurface::AlgebraicSurface()
 {
 }
 
+// Surfaces that can give their gradient exactly should, but central differences are good to second order.
+// The step is scaled with the point so that it isn't lost in the rounding of points far from the origin.
 /*virtual*/ Vector3 AlgebraicSurface::EvaluateGradient(const Vector3& point) const
 {
-	return Vector3(0.0, 0.0, 0.0);	// TODO: Approximate gradient here using central differencing?
+	double delta = 1e-6 * MESH_NINJA_MAX(1.0, MESH_NINJA_MAX(::fabs(point.x), MESH_NINJA_MAX(::fabs(point.y), ::fabs(point.z))));
+
+	Vector3 dx(delta, 0.0, 0.0);
+	Vector3 dy(0.0, delta, 0.0);
+	Vector3 dz(0.0, 0.0, delta);
+
+	return Vector3(
+		(this->Evaluate(point + dx) - this->Evaluate(point - dx)) / (2.0 * delta),
+		(this->Evaluate(point + dy) - this->Evaluate(point - dy)) / (2.0 * delta),
+		(this->Evaluate(point + dz) - this->Evaluate(point - dz)) / (2.0 * delta));
 }
 
 /*virtual*/ double AlgebraicSurface::EvaluateDirectionalDerivative(const Vector3& point, const Vector3& unitDirection) const
@@ -28,6 +40,152 @@ AlgebraicSurface::AlgebraicSurface()
 	return (this->Evaluate(point + unitDirection * delta) - this->Evaluate(point)) / delta;
 }
 
+/*virtual*/ void AlgebraicSurface::EvaluateBatch(const double* x, const double* y, const double* z, double* value, int count) const
+{
+	for (int k = 0; k < count; k++)
+		value[k] = this->Evaluate(Vector3(x[k], y[k], z[k]));
+}
+
+/*virtual*/ void AlgebraicSurface::EvaluateGradientBatch(const double* x, const double* y, const double* z, double* gradientX, double* gradientY, double* gradientZ, int count) const
+{
+	for (int k = 0; k < count; k++)
+	{
+		Vector3 gradient = this->EvaluateGradient(Vector3(x[k], y[k], z[k]));
+		gradientX[k] = gradient.x;
+		gradientY[k] = gradient.y;
+		gradientZ[k] = gradient.z;
+	}
+}
+
+/*virtual*/ double AlgebraicSurface::GetLipschitzBound() const
+{
+	return 0.0;
+}
+
+/*virtual*/ double AlgebraicSurface::CalcLipschitzBound(const AxisAlignedBoundingBox& /*box*/) const
+{
+	return this->GetLipschitzBound();
+}
+
+/*virtual*/ bool AlgebraicSurface::CastRay(const Ray& ray, double& alpha, double eps /*= MESH_NINJA_EPS*/, int maxIterations /*= 100*/, double stepSize /*= 1.0*/, bool forwardOrBackward /*= false*/) const
+{
+	if (maxIterations <= 0)
+		maxIterations = 100;
+
+	if (stepSize <= 0.0)
+		stepSize = 1.0;
+
+	bool hitForward = this->MarchRay(ray, alpha, eps, maxIterations, stepSize);
+	if (!forwardOrBackward || (hitForward && alpha == 0.0))
+		return hitForward;
+
+	double backwardAlpha = 0.0;
+	if (!this->MarchRay(Ray(ray.origin, -ray.direction), backwardAlpha, eps, maxIterations, stepSize))
+		return hitForward;
+
+	if (!hitForward || backwardAlpha < alpha)
+		alpha = -backwardAlpha;
+
+	return true;
+}
+
+// We step along the ray until the function changes sign, and then home in on the root between the last two steps.
+// With a Lipschitz bound, each step is as far as the surface could possibly be from where we are, so that this is
+// sphere tracing, and no root can be stepped over.  Without a bound that holds everywhere, we ask for one over the
+// box around the next step, and then step no further than that box.  Without either, a part of the surface thinner
+// than the step size can be stepped over.  Distances along the ray are measured in units of its direction.
+bool AlgebraicSurface::MarchRay(const Ray& ray, double& alpha, double eps, int maxIterations, double stepSize) const
+{
+	double length = ray.direction.Length();
+	if (length == 0.0)
+		return false;
+
+	double globalLipschitzBound = this->GetLipschitzBound() * length;
+	double minStep = eps / length;
+	stepSize /= length;
+
+	double alphaA = 0.0;
+	double valueA = this->Evaluate(ray.origin);
+
+	for (int i = 0; i < maxIterations; i++)
+	{
+		if (::fabs(valueA) < eps)
+		{
+			alpha = alphaA;
+			return true;
+		}
+
+		double step = stepSize;
+		if (globalLipschitzBound > 0.0)
+			step = MESH_NINJA_MAX(::fabs(valueA) / globalLipschitzBound, minStep);
+		else
+		{
+			AxisAlignedBoundingBox box(ray.Lerp(alphaA));
+			box.ExpandToIncludePoint(ray.Lerp(alphaA + stepSize));
+
+			double lipschitzBound = this->CalcLipschitzBound(box) * length;
+			if (lipschitzBound > 0.0)
+				step = MESH_NINJA_MIN(MESH_NINJA_MAX(::fabs(valueA) / lipschitzBound, minStep), stepSize);
+		}
+
+		double alphaB = alphaA + step;
+		double valueB = this->Evaluate(ray.Lerp(alphaB));
+
+		// Steps grow as we get further from a surface, so a ray heading away from it would go on until it overflowed.
+		if (::isnan(valueB) || ::isinf(valueB))
+			return false;
+
+		if (MESH_NINJA_SIGN(valueA) != MESH_NINJA_SIGN(valueB))
+			return this->RefineRoot(ray, alphaA, valueA, alphaB, valueB, alpha, eps);
+
+		alphaA = alphaB;
+		valueA = valueB;
+	}
+
+	return false;
+}
+
+// Newton's method is used while it stays within the bracket around the root, and we bisect the bracket when it doesn't,
+// so that this always converges, and usually does so in a few steps.
+bool AlgebraicSurface::RefineRoot(const Ray& ray, double alphaA, double valueA, double alphaB, double valueB, double& alpha, double eps) const
+{
+	Vector3 unitDirection = ray.direction.Normalized();
+	double length = ray.direction.Length();
+
+	alpha = alphaA - valueA * (alphaB - alphaA) / (valueB - valueA);
+
+	for (int i = 0; i < 64; i++)
+	{
+		Vector3 point = ray.Lerp(alpha);
+		double value = this->Evaluate(point);
+		if (::fabs(value) < eps)
+			return true;
+
+		if (MESH_NINJA_SIGN(value) == MESH_NINJA_SIGN(valueA))
+		{
+			alphaA = alpha;
+			valueA = value;
+		}
+		else
+		{
+			alphaB = alpha;
+			valueB = value;
+		}
+
+		if (alphaB - alphaA < 1e-12 * MESH_NINJA_MAX(1.0, ::fabs(alphaB)))
+			return true;
+
+		double derivative = this->EvaluateDirectionalDerivative(point, unitDirection) * length;
+		double nextAlpha = (derivative != 0.0) ? alpha - value / derivative : alphaA;
+		if (!(alphaA < nextAlpha && nextAlpha < alphaB))
+			nextAlpha = (alphaA + alphaB) / 2.0;
+
+		alpha = nextAlpha;
+	}
+
+	return true;
+}
+
 //--------------------------------- QuadraticSurface ---------------------------------
 
 QuadraticSurface::QuadraticSurface()
@@ -81,6 +239,129 @@ QuadraticSurface::QuadraticSurface()
 		2.0 * this->c * z + this->e * y + this->f * x + this->i);
 }
 
+// The coefficients are copied out first so that the compiler knows they can't change as the results are written,
+// and what's left is a loop of straight-line arithmetic, which it can vectorize.
+/*virtual*/ void QuadraticSurface::EvaluateBatch(const double* x, const double* y, const double* z, double* value, int count) const
+{
+	const double A = this->a, B = this->b, C = this->c, D = this->d, E = this->e;
+	const double F = this->f, G = this->g, H = this->h, I = this->i, J = this->j;
+
+	for (int k = 0; k < count; k++)
+	{
+		double px = x[k];
+		double py = y[k];
+		double pz = z[k];
+
+		value[k] =
+			px * (A * px + D * py + F * pz + G) +
+			py * (B * py + E * pz + H) +
+			pz * (C * pz + I) +
+			J;
+	}
+}
+
+/*virtual*/ void QuadraticSurface::EvaluateGradientBatch(const double* x, const double* y, const double* z, double* gradientX, double* gradientY, double* gradientZ, int count) const
+{
+	const double A = 2.0 * this->a, B = 2.0 * this->b, C = 2.0 * this->c, D = this->d, E = this->e;
+	const double F = this->f, G = this->g, H = this->h, I = this->i;
+
+	for (int k = 0; k < count; k++)
+	{
+		double px = x[k];
+		double py = y[k];
+		double pz = z[k];
+
+		gradientX[k] = A * px + D * py + F * pz + G;
+		gradientY[k] = B * py + D * px + E * pz + H;
+		gradientZ[k] = C * pz + E * py + F * px + I;
+	}
+}
+
+// The gradient is only the same everywhere if there's no quadratic part, in which case the surface is a plane.
+/*virtual*/ double QuadraticSurface::GetLipschitzBound() const
+{
+	if (this->a != 0.0 || this->b != 0.0 || this->c != 0.0 || this->d != 0.0 || this->e != 0.0 || this->f != 0.0)
+		return 0.0;
+
+	return Vector3(this->g, this->h, this->i).Length();
+}
+
+// The gradient is linear, so its length is a convex function, and so is largest at one of the corners of the box.
+/*virtual*/ double QuadraticSurface::CalcLipschitzBound(const AxisAlignedBoundingBox& box) const
+{
+	double largestLength = 0.0;
+
+	for (int k = 0; k < 8; k++)
+	{
+		Vector3 corner(
+			(k & 1) ? box.max.x : box.min.x,
+			(k & 2) ? box.max.y : box.min.y,
+			(k & 4) ? box.max.z : box.min.z);
+
+		largestLength = MESH_NINJA_MAX(largestLength, this->EvaluateGradient(corner).Length());
+	}
+
+	return largestLength;
+}
+
+// Along the ray, the function is a quadratic in alpha, whose coefficients come from the function, its gradient,
+// and its quadratic part, all evaluated once.  The roots are found in a way that doesn't lose precision to cancellation.
+/*virtual*/ bool QuadraticSurface::CastRay(const Ray& ray, double& alpha, double eps /*= MESH_NINJA_EPS*/, int /*maxIterations*/ /*= 100*/, double /*stepSize*/ /*= 1.0*/, bool forwardOrBackward /*= false*/) const
+{
+	const Vector3& u = ray.direction;
+
+	double A =
+		this->a * u.x * u.x + this->b * u.y * u.y + this->c * u.z * u.z +
+		this->d * u.x * u.y + this->e * u.y * u.z + this->f * u.x * u.z;
+	double B = this->EvaluateGradient(ray.origin).Dot(u);
+	double C = this->Evaluate(ray.origin);
+
+	if (::fabs(C) < eps)
+	{
+		alpha = 0.0;
+		return true;
+	}
+
+	double rootArray[2];
+	int numRoots = 0;
+
+	double scale = MESH_NINJA_MAX(::fabs(A), MESH_NINJA_MAX(::fabs(B), ::fabs(C)));
+	if (::fabs(A) <= 1e-12 * scale)
+	{
+		if (B == 0.0)
+			return false;
+
+		rootArray[numRoots++] = -C / B;
+	}
+	else
+	{
+		double discriminant = B * B - 4.0 * A * C;
+		if (discriminant < 0.0)
+			return false;
+
+		double q = -0.5 * (B + MESH_NINJA_SIGN(B) * ::sqrt(discriminant));
+		rootArray[numRoots++] = q / A;
+		if (q != 0.0)
+			rootArray[numRoots++] = C / q;
+	}
+
+	bool found = false;
+	for (int k = 0; k < numRoots; k++)
+	{
+		double root = rootArray[k];
+		if (root < 0.0 && !forwardOrBackward)
+			continue;
+
+		if (!found || ::fabs(root) < ::fabs(alpha))
+		{
+			alpha = root;
+			found = true;
+		}
+	}
+
+	return found;
+}
+
 void QuadraticSurface::MakeEllipsoid(double A, double B, double C)
 {
 	this->a = 1.0 / (A * A);
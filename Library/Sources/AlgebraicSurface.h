@@ -5,6 +5,9 @@
 
 namespace MeshNinja
 {
+	class Ray;
+	class AxisAlignedBoundingBox;
+
 	class MESH_NINJA_API AlgebraicSurface
 	{
 	public:
@@ -15,6 +18,29 @@ namespace MeshNinja
 		virtual Vector3 EvaluateGradient(const Vector3& point) const;
 		virtual double EvaluateDirectionalDerivative(const Vector3& point, const Vector3& unitDirection) const;
 		virtual double ApproximateDirectionalDerivative(const Vector3& point, const Vector3& unitDirection, double delta) const;
+
+		// These evaluate the function or its gradient at many points with one call, the points being given by separate
+		// arrays of their coordinates.  By default they just evaluate one point at a time, but surfaces that can do better
+		// should, since anything evaluating a surface a great deal will use these.
+		virtual void EvaluateBatch(const double* x, const double* y, const double* z, double* value, int count) const;
+		virtual void EvaluateGradientBatch(const double* x, const double* y, const double* z, double* gradientX, double* gradientY, double* gradientZ, int count) const;
+
+		// If the function changes by no more than this per unit of distance anywhere, rays can step
+		// by the value of the function over this without ever stepping over the surface.  Zero means
+		// there's no such bound known, and rays then take steps of a fixed size.
+		virtual double GetLipschitzBound() const;
+
+		// This is like the above, but only need hold within the given box, which makes a bound possible for more surfaces.
+		virtual double CalcLipschitzBound(const AxisAlignedBoundingBox& box) const;
+
+		// This finds the root of the function along the ray nearest its origin.  Only roots in front of the ray are
+		// found unless told otherwise.  A step size or iteration count of zero means the surface can choose these.
+		virtual bool CastRay(const Ray& ray, double& alpha, double eps = MESH_NINJA_EPS, int maxIterations = 100, double stepSize = 1.0, bool forwardOrBackward = false) const;
+
+	protected:
+
+		bool MarchRay(const Ray& ray, double& alpha, double eps, int maxIterations, double stepSize) const;
+		bool RefineRoot(const Ray& ray, double alphaA, double valueA, double alphaB, double valueB, double& alpha, double eps) const;
 	};
 
 	class MESH_NINJA_API QuadraticSurface : public AlgebraicSurface
@@ -25,6 +51,11 @@ namespace MeshNinja
 
 		virtual double Evaluate(const Vector3& point) const override;
 		virtual Vector3 EvaluateGradient(const Vector3& point) const override;
+		virtual void EvaluateBatch(const double* x, const double* y, const double* z, double* value, int count) const override;
+		virtual void EvaluateGradientBatch(const double* x, const double* y, const double* z, double* gradientX, double* gradientY, double* gradientZ, int count) const override;
+		virtual double GetLipschitzBound() const override;
+		virtual double CalcLipschitzBound(const AxisAlignedBoundingBox& box) const override;
+		virtual bool CastRay(const Ray& ray, double& alpha, double eps = MESH_NINJA_EPS, int maxIterations = 100, double stepSize = 1.0, bool forwardOrBackward = false) const override;
 
 		void MakeEllipsoid(double A, double B, double C);
 		void MakeEllipticCone(double A, double B, double C);
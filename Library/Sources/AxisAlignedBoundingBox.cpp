@@ -118,10 +118,26 @@ void AxisAlignedBoundingBox::ExpandToIncludePoint(const Vector3& point)
 	this->max.z = MESH_NINJA_MAX(this->max.z, point.z);
 }
 
+double AxisAlignedBoundingBox::SquaredDistanceTo(const Vector3& point) const
+{
+	double dx = MESH_NINJA_MAX(MESH_NINJA_MAX(this->min.x - point.x, point.x - this->max.x), 0.0);
+	double dy = MESH_NINJA_MAX(MESH_NINJA_MAX(this->min.y - point.y, point.y - this->max.y), 0.0);
+	double dz = MESH_NINJA_MAX(MESH_NINJA_MAX(this->min.z - point.z, point.z - this->max.z), 0.0);
+
+	return dx * dx + dy * dy + dz * dz;
+}
+
 bool AxisAlignedBoundingBox::Intersect(const AxisAlignedBoundingBox& aabbA, const AxisAlignedBoundingBox& aabbB)
 {
-	// TODO: Write this.
-	return false;
+	this->min.x = MESH_NINJA_MAX(aabbA.min.x, aabbB.min.x);
+	this->min.y = MESH_NINJA_MAX(aabbA.min.y, aabbB.min.y);
+	this->min.z = MESH_NINJA_MAX(aabbA.min.z, aabbB.min.z);
+
+	this->max.x = MESH_NINJA_MIN(aabbA.max.x, aabbB.max.x);
+	this->max.y = MESH_NINJA_MIN(aabbA.max.y, aabbB.max.y);
+	this->max.z = MESH_NINJA_MIN(aabbA.max.z, aabbB.max.z);
+
+	return this->IsValid();
 }
 
 bool AxisAlignedBoundingBox::Merge(const AxisAlignedBoundingBox& aabbA, const AxisAlignedBoundingBox& aabbB)
@@ -30,6 +30,9 @@ namespace MeshNinja
 
 		void ExpandToIncludePoint(const Vector3& point);
 
+		// This is zero for points inside the box.
+		double SquaredDistanceTo(const Vector3& point) const;
+
 		bool Intersect(const AxisAlignedBoundingBox& aabbA, const AxisAlignedBoundingBox& aabbB);
 		bool Merge(const AxisAlignedBoundingBox& aabbA, const AxisAlignedBoundingBox& aabbB);
 		bool OverlapsWith(const AxisAlignedBoundingBox& aabb) const;
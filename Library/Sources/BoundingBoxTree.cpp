@@ -1,5 +1,6 @@
 #include "BoundingBoxTree.h"
 #include "Ray.h"
+#include "TaskScheduler.h"
 
 using namespace MeshNinja;
 
@@ -29,7 +30,7 @@ bool BoundingBoxTree::Insert(Object* object)
 	return this->rootNode->Insert(object);
 }
 
-void BoundingBoxTree::Rebuild(const std::vector<Object*>& objectArray)
+void BoundingBoxTree::Rebuild(const std::vector<Object*>& objectArray, int threadCount /*= 0*/)
 {
 	this->Clear();
 
@@ -43,63 +44,75 @@ void BoundingBoxTree::Rebuild(const std::vector<Object*>& objectArray)
 
 	this->rootNode = new Node(aabb);
 
-	for (Object* object : objectArray)
-	{
-		bool inserted = this->Insert(object);
-		assert(inserted);
-	}
+	if (threadCount <= 0)
+		threadCount = TaskScheduler::Get()->GetThreadCount();
+
+	this->rootNode->Build(objectArray, threadCount);
+}
+
+void BoundingBoxTree::ForOverlappingObjects(const AxisAlignedBoundingBox& aabb, std::function<bool(Object*)> callback) const
+{
+	TraversalStack stack;
+	this->ForOverlappingObjects(aabb, callback, stack);
 }
 
-void BoundingBoxTree::ForOverlappingObjects(const AxisAlignedBoundingBox& aabb, std::function<bool(Object*)> callback)
+void BoundingBoxTree::ForOverlappingObjects(const AxisAlignedBoundingBox& aabb, std::function<bool(Object*)> callback, TraversalStack& stack) const
 {
 	if (!this->rootNode)
 		return;
 
-	std::list<Node*> nodeQueue;
+	std::vector<const Node*>& nodeQueue = *stack.nodeArray;
+	nodeQueue.clear();
 	nodeQueue.push_back(this->rootNode);
-	while (nodeQueue.size() > 0)
+
+	for (int i = 0; i < (signed)nodeQueue.size(); i++)
 	{
-		std::list<Node*>::iterator iter = nodeQueue.begin();
-		Node* node = *iter;
-		nodeQueue.erase(iter);
+		const Node* node = nodeQueue[i];
 
 		if (node->aabb.OverlapsWith(aabb))
 		{
-			for (Object* object : node->objectArray)
+			for (int j = 0; j < (signed)node->objectArray.size(); j++)
 			{
-				if (aabb.OverlapsWith(object->GetBoundingBox()))
+				if (aabb.OverlapsWith(node->objectBoxArray[j]))
 				{
-					if (!callback(object))
+					if (!callback(node->objectArray[j]))
 						return;
 				}
 			}
 
-			for (Node* childNode : node->childArray)
+			for (const Node* childNode : node->childArray)
 				nodeQueue.push_back(childNode);
 		}
 	}
 }
 
-void BoundingBoxTree::ForHitObjects(const Ray& ray, std::function<bool(Object*, double)> callback)
+void BoundingBoxTree::ForHitObjects(const Ray& ray, std::function<bool(Object*, double)> callback) const
+{
+	TraversalStack stack;
+	this->ForHitObjects(ray, callback, stack);
+}
+
+void BoundingBoxTree::ForHitObjects(const Ray& ray, std::function<bool(Object*, double)> callback, TraversalStack& stack) const
 {
 	if (!this->rootNode)
 		return;
 
-	std::list<Node*> nodeQueue;
+	std::vector<const Node*>& nodeQueue = *stack.nodeArray;
+	nodeQueue.clear();
 	nodeQueue.push_back(this->rootNode);
-	while (nodeQueue.size() > 0)
+
+	for (int i = 0; i < (signed)nodeQueue.size(); i++)
 	{
-		std::list<Node*>::iterator iter = nodeQueue.begin();
-		Node* node = *iter;
-		nodeQueue.erase(iter);
+		const Node* node = nodeQueue[i];
 
 		double alpha = 0.0;
 		if (ray.CastAgainst(node->aabb, alpha))
 		{
-			for (Object* object : node->objectArray)
+			for (int j = 0; j < (signed)node->objectArray.size(); j++)
 			{
-				if (ray.CastAgainst(object->GetBoundingBox(), alpha))
+				if (ray.CastAgainst(node->objectBoxArray[j], alpha))
 				{
+					Object* object = node->objectArray[j];
 					if (object->IsHitByRay(ray, alpha))
 					{
 						if (!callback(object, alpha))
@@ -108,13 +121,19 @@ void BoundingBoxTree::ForHitObjects(const Ray& ray, std::function<bool(Object*,
 				}
 			}
 
-			for (Node* childNode : node->childArray)
+			for (const Node* childNode : node->childArray)
 				nodeQueue.push_back(childNode);
 		}
 	}
 }
 
-BoundingBoxTree::Object* BoundingBoxTree::FindClosestHit(const Ray& ray, double* beta /*= nullptr*/)
+BoundingBoxTree::Object* BoundingBoxTree::FindClosestHit(const Ray& ray, double* beta /*= nullptr*/) const
+{
+	TraversalStack stack;
+	return this->FindClosestHit(ray, stack, beta);
+}
+
+BoundingBoxTree::Object* BoundingBoxTree::FindClosestHit(const Ray& ray, TraversalStack& stack, double* beta /*= nullptr*/) const
 {
 	BoundingBoxTree::Object* foundObject = nullptr;
 	double smallestAlpha = DBL_MAX;
@@ -127,7 +146,7 @@ BoundingBoxTree::Object* BoundingBoxTree::FindClosestHit(const Ray& ray, double*
 				foundObject = object;
 			}
 			return true;
-		});
+		}, stack);
 
 	if (beta)
 		*beta = smallestAlpha;
@@ -135,6 +154,72 @@ BoundingBoxTree::Object* BoundingBoxTree::FindClosestHit(const Ray& ray, double*
 	return foundObject;
 }
 
+BoundingBoxTree::Object* BoundingBoxTree::FindClosestObject(const Vector3& point, std::function<double(Object*)> distanceFunc, double* distance /*= nullptr*/, double maxDistance /*= DBL_MAX*/) const
+{
+	TraversalStack stack;
+	return this->FindClosestObject(point, distanceFunc, stack, distance, maxDistance);
+}
+
+// Once the nearest node left to visit is further away than the closest object found, nothing left can be closer.
+BoundingBoxTree::Object* BoundingBoxTree::FindClosestObject(const Vector3& point, std::function<double(Object*)> distanceFunc, TraversalStack& stack, double* distance /*= nullptr*/, double maxDistance /*= DBL_MAX*/) const
+{
+	Object* foundObject = nullptr;
+	double smallestDistance = maxDistance;
+	double smallestSquaredDistance = (maxDistance == DBL_MAX) ? DBL_MAX : maxDistance * maxDistance;
+
+	std::vector<std::pair<double, const Node*>>& nodeHeap = *stack.nodeHeap;
+	nodeHeap.clear();
+
+	auto nodeOrder = [](const std::pair<double, const Node*>& entryA, const std::pair<double, const Node*>& entryB) -> bool
+	{
+		return entryA.first > entryB.first;
+	};
+
+	if (this->rootNode)
+		nodeHeap.push_back(std::pair<double, const Node*>(this->rootNode->aabb.SquaredDistanceTo(point), this->rootNode));
+
+	while (nodeHeap.size() > 0)
+	{
+		std::pop_heap(nodeHeap.begin(), nodeHeap.end(), nodeOrder);
+		std::pair<double, const Node*> entry = nodeHeap.back();
+		nodeHeap.pop_back();
+
+		if (entry.first > smallestSquaredDistance)
+			break;
+
+		const Node* node = entry.second;
+
+		for (int i = 0; i < (signed)node->objectArray.size(); i++)
+		{
+			if (node->objectBoxArray[i].SquaredDistanceTo(point) <= smallestSquaredDistance)
+			{
+				double objectDistance = distanceFunc(node->objectArray[i]);
+				if (objectDistance < smallestDistance || (!foundObject && objectDistance <= smallestDistance))
+				{
+					smallestDistance = objectDistance;
+					smallestSquaredDistance = objectDistance * objectDistance;
+					foundObject = node->objectArray[i];
+				}
+			}
+		}
+
+		for (const Node* childNode : node->childArray)
+		{
+			double squaredDistance = childNode->aabb.SquaredDistanceTo(point);
+			if (squaredDistance <= smallestSquaredDistance)
+			{
+				nodeHeap.push_back(std::pair<double, const Node*>(squaredDistance, childNode));
+				std::push_heap(nodeHeap.begin(), nodeHeap.end(), nodeOrder);
+			}
+		}
+	}
+
+	if (distance)
+		*distance = foundObject ? smallestDistance : DBL_MAX;
+
+	return foundObject;
+}
+
 bool BoundingBoxTree::GetBoundingBox(AxisAlignedBoundingBox& box) const
 {
 	if (!this->rootNode)
@@ -167,6 +252,42 @@ BoundingBoxTree::Object::Object()
 {
 }
 
+//------------------------------ BoundingBoxTree::IndexedObject ------------------------------
+
+BoundingBoxTree::IndexedObject::IndexedObject(int index, const AxisAlignedBoundingBox& box)
+{
+	this->index = index;
+	this->box = box;
+}
+
+/*virtual*/ BoundingBoxTree::IndexedObject::~IndexedObject()
+{
+}
+
+/*virtual*/ AxisAlignedBoundingBox BoundingBoxTree::IndexedObject::GetBoundingBox() const
+{
+	return this->box;
+}
+
+/*virtual*/ bool BoundingBoxTree::IndexedObject::IsHitByRay(const Ray& /*ray*/, double& /*alpha*/) const
+{
+	return false;
+}
+
+//------------------------------ BoundingBoxTree::TraversalStack ------------------------------
+
+BoundingBoxTree::TraversalStack::TraversalStack()
+{
+	this->nodeArray = new std::vector<const Node*>();
+	this->nodeHeap = new std::vector<std::pair<double, const Node*>>();
+}
+
+/*virtual*/ BoundingBoxTree::TraversalStack::~TraversalStack()
+{
+	delete this->nodeArray;
+	delete this->nodeHeap;
+}
+
 //------------------------------ BoundingBoxTree::Node ------------------------------
 	
 BoundingBoxTree::Node::Node(const AxisAlignedBoundingBox& aabb)
@@ -200,10 +321,66 @@ bool BoundingBoxTree::Node::Insert(Object* object)
 		if (childNode->Insert(object))
 			return true;
 
-	this->objectArray.push_back(object);
+	this->AddObject(object, object->GetBoundingBox());
 	return true;
 }
 
+void BoundingBoxTree::Node::AddObject(Object* object, const AxisAlignedBoundingBox& objectBox)
+{
+	this->objectArray.push_back(object);
+	this->objectBoxArray.push_back(objectBox);
+}
+
+// This makes the same tree as inserting the given objects one at a time would, but with each node sorting out all
+// of its objects at once, the subtrees don't have anything to do with one another and can be built in parallel.
+void BoundingBoxTree::Node::Build(const std::vector<Object*>& objectArray, int threadCount)
+{
+	if (objectArray.size() == 0)
+		return;
+
+	AxisAlignedBoundingBox aabbA, aabbB;
+	this->aabb.SplitReasonably(aabbA, aabbB);
+
+	Node* nodeA = new Node(aabbA);
+	Node* nodeB = new Node(aabbB);
+
+	this->childArray.push_back(nodeA);
+	this->childArray.push_back(nodeB);
+
+	std::vector<Object*> objectArrayA, objectArrayB;
+
+	for (Object* object : objectArray)
+	{
+		AxisAlignedBoundingBox objectBox = object->GetBoundingBox();
+
+		if (aabbA.ContainsBox(objectBox))
+			objectArrayA.push_back(object);
+		else if (aabbB.ContainsBox(objectBox))
+			objectArrayB.push_back(object);
+		else
+			this->AddObject(object, objectBox);
+	}
+
+	// Small subtrees aren't worth the trouble of a task.
+	int minObjectsPerTask = 512;
+
+	if (threadCount > 1 && (signed)objectArrayA.size() >= minObjectsPerTask && (signed)objectArrayB.size() >= minObjectsPerTask)
+	{
+		TaskScheduler::TaskGroup taskGroup;
+		taskGroup.Run([nodeA, &objectArrayA, threadCount]()
+			{
+				nodeA->Build(objectArrayA, threadCount / 2);
+			});
+		nodeB->Build(objectArrayB, threadCount - threadCount / 2);
+		taskGroup.Wait();
+	}
+	else
+	{
+		nodeA->Build(objectArrayA, threadCount);
+		nodeB->Build(objectArrayB, threadCount);
+	}
+}
+
 int BoundingBoxTree::Node::Count() const
 {
 	int count = this->objectArray.size();
@@ -19,11 +19,26 @@ namespace MeshNinja
 		bool IsEmpty() const;
 		int Size() const;
 		bool Insert(Object* object);
-		void Rebuild(const std::vector<Object*>& objectArray);
-		void ForOverlappingObjects(const AxisAlignedBoundingBox& aabb, std::function<bool(Object*)> callback);
-		void ForHitObjects(const Ray& ray, std::function<bool(Object*, double)> callback);
+		void Rebuild(const std::vector<Object*>& objectArray, int threadCount = 0);
+		void ForOverlappingObjects(const AxisAlignedBoundingBox& aabb, std::function<bool(Object*)> callback) const;
+		void ForHitObjects(const Ray& ray, std::function<bool(Object*, double)> callback) const;
 		bool GetBoundingBox(AxisAlignedBoundingBox& box) const;
-		Object* FindClosestHit(const Ray& ray, double* beta = nullptr);
+		Object* FindClosestHit(const Ray& ray, double* beta = nullptr) const;
+
+		// The given function measures the distance from the given point to an object, and this finds the object for which
+		// that's smallest, not measuring those whose boxes are further away than the best found so far, nor those whose
+		// boxes are further away than the given maximum.  The function mustn't give less than the distance to the box.
+		Object* FindClosestObject(const Vector3& point, std::function<double(Object*)> distanceFunc, double* distance = nullptr, double maxDistance = DBL_MAX) const;
+
+		// The queries don't change the tree, nor call anything on the objects but IsHitByRay, so one tree can be queried
+		// from any number of threads at once, so long as nobody changes it while they do.  A query needs somewhere to keep
+		// the nodes it has yet to visit, and those given a stack of their own don't allocate once it has grown to size.
+		class TraversalStack;
+
+		void ForOverlappingObjects(const AxisAlignedBoundingBox& aabb, std::function<bool(Object*)> callback, TraversalStack& stack) const;
+		void ForHitObjects(const Ray& ray, std::function<bool(Object*, double)> callback, TraversalStack& stack) const;
+		Object* FindClosestHit(const Ray& ray, TraversalStack& stack, double* beta = nullptr) const;
+		Object* FindClosestObject(const Vector3& point, std::function<double(Object*)> distanceFunc, TraversalStack& stack, double* distance = nullptr, double maxDistance = DBL_MAX) const;
 
 		class MESH_NINJA_API Object
 		{
@@ -35,6 +50,20 @@ namespace MeshNinja
 			virtual bool IsHitByRay(const Ray& ray, double& alpha) const = 0;
 		};
 
+		// This is for things kept in some array elsewhere, which only need to be found by their boxes.
+		class MESH_NINJA_API IndexedObject : public Object
+		{
+		public:
+			IndexedObject(int index, const AxisAlignedBoundingBox& box);
+			virtual ~IndexedObject();
+
+			virtual AxisAlignedBoundingBox GetBoundingBox() const override;
+			virtual bool IsHitByRay(const Ray& ray, double& alpha) const override;
+
+			int index;
+			AxisAlignedBoundingBox box;
+		};
+
 		template<typename T>
 		class TemplateObject : public Object
 		{
@@ -65,13 +94,32 @@ namespace MeshNinja
 			virtual ~Node();
 
 			bool Insert(Object* object);
+			void Build(const std::vector<Object*>& objectArray, int threadCount);
+			void AddObject(Object* object, const AxisAlignedBoundingBox& objectBox);
 			int Count() const;
 
+			// The boxes of the objects are kept here as they were when the objects were added, so an object
+			// mustn't change its box while it's in the tree.
 			std::vector<Object*> objectArray;
+			std::vector<AxisAlignedBoundingBox> objectBoxArray;
 			std::vector<Node*> childArray;
 			AxisAlignedBoundingBox aabb;
 		};
 
 		Node* rootNode;
+
+	public:
+
+		// Nodes are visited breadth-first, so the queue can grow to the number of nodes visited.  Closest-object
+		// queries visit them nearest-first instead, keeping a heap of them by the squared distance to their boxes.
+		class MESH_NINJA_API TraversalStack
+		{
+		public:
+			TraversalStack();
+			virtual ~TraversalStack();
+
+			std::vector<const Node*>* nodeArray;
+			std::vector<std::pair<double, const Node*>>* nodeHeap;
+		};
 	};
 }
\ No newline at end of file
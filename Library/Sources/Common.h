@@ -37,13 +37,17 @@
 #include <list>
 #include <map>
 #include <set>
+#include <unordered_map>
+#include <unordered_set>
 #include <string>
 #include <format>
 #include <fstream>
 #include <sstream>
 #include <math.h>
+#include <float.h>
 #include <assert.h>
 #include <functional>
+#include <algorithm>
 #include <filesystem>
 
 // TODO: Make PCH?
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "Ray.h"
 #include "LineSegment.h"
 #include "AxisAlignedBoundingBox.h"
+#include "Math/Predicates.h"
 
 using namespace MeshNinja;
 
@@ -209,13 +210,18 @@ bool ConvexPolygon::IntersectWithLineSegment(const Vector3& pointA, const Vector
 }
 
 bool ConvexPolygon::ContainsPoint(const Vector3& point, bool* isInteriorPoint /*= nullptr*/, double eps /*= MESH_NINJA_EPS*/) const
+{
+	Plane plane;
+	this->CalcPlane(plane, eps);
+	return this->ContainsPoint(point, plane, isInteriorPoint, eps);
+}
+
+bool ConvexPolygon::ContainsPoint(const Vector3& point, const Plane& plane, bool* isInteriorPoint /*= nullptr*/, double eps /*= MESH_NINJA_EPS*/) const
 {
 	if (isInteriorPoint)
 		*isInteriorPoint = false;
 
 	// Is the given point in the same plane of the polygon?
-	Plane plane;
-	this->CalcPlane(plane, eps);
 	if (plane.WhichSide(point, eps) != Plane::Side::NEITHER)
 		return false;
 
@@ -224,12 +230,13 @@ bool ConvexPolygon::ContainsPoint(const Vector3& point, bool* isInteriorPoint /*
 		return true;
 
 	// Is the given point in the interior of the polygon?
+	bool adaptive = Predicates::GetMode() == Predicates::Mode::ADAPTIVE;
 	for (int i = 0; i < (signed)this->vertexArray->size(); i++)
 	{
 		int j = (i + 1) % this->vertexArray->size();
 		const Vector3& vertexA = (*this->vertexArray)[i];
 		const Vector3& vertexB = (*this->vertexArray)[j];
-		double dot = (vertexA - point).Cross(vertexB - point).Dot(plane.normal);
+		double dot = adaptive ? Predicates::Orient2D(point, vertexA, vertexB, plane.normal) : (vertexA - point).Cross(vertexB - point).Dot(plane.normal);
 		if (dot < 0.0)
 			return false;
 	}
@@ -259,6 +266,57 @@ bool ConvexPolygon::Intersect(const ConvexPolygon& polygonA, const ConvexPolygon
 {
 	this->Clear();
 
+	// Most pairs of polygons we're given either aren't near each other's planes at all, or cut cleanly through
+	// one another.  Knowing just the two planes, we can settle both of these cases far more cheaply than the
+	// general approach below.  Note that, like the general approach, we use the default tolerance everywhere
+	// but in deciding whether two intersection points are the same.
+	Plane planeA, planeB;
+	if (polygonA.CalcPlane(planeA) && polygonB.CalcPlane(planeB))
+	{
+		const ConvexPolygon* polygonArray[2] = { &polygonA, &polygonB };
+		const Plane* otherPlaneArray[2] = { &planeB, &planeA };
+		std::vector<Plane::Side> sideArray[2];
+		bool straddling = true;
+
+		for (int i = 0; i < 2; i++)
+		{
+			const ConvexPolygon* polygon = polygonArray[i];
+			const Plane* otherPlane = otherPlaneArray[i];
+
+			double smallestDistance = DBL_MAX;
+			double largestDistance = -DBL_MAX;
+			bool hasFrontVertex = false, hasBackVertex = false;
+
+			for (const Vector3& vertex : *polygon->vertexArray)
+			{
+				double distance = otherPlane->SignedDistanceToPoint(vertex);
+				smallestDistance = MESH_NINJA_MIN(smallestDistance, distance);
+				largestDistance = MESH_NINJA_MAX(largestDistance, distance);
+
+				Plane::Side side = otherPlane->WhichSide(vertex);
+				hasFrontVertex |= (side == Plane::Side::FRONT);
+				hasBackVertex |= (side == Plane::Side::BACK);
+				if (side == Plane::Side::NEITHER)
+					straddling = false;
+
+				sideArray[i].push_back(side);
+			}
+
+			// If one polygon is entirely on one side of the other's plane, with room to spare for all the
+			// tolerances used below, then they can't touch.
+			if (smallestDistance > 2.0 * MESH_NINJA_EPS || largestDistance < -2.0 * MESH_NINJA_EPS)
+				return false;
+
+			if (!hasFrontVertex || !hasBackVertex)
+				straddling = false;
+		}
+
+		if (straddling && this->IntersectStraddling(polygonA, planeA, sideArray[0], polygonB, planeB, sideArray[1], eps))
+			return this->vertexArray->size() > 0;
+
+		this->Clear();
+	}
+
 	const ConvexPolygon* polygonArray[2] = { &polygonA, &polygonB };
 	bool samePolygon = true;
 
@@ -281,7 +339,7 @@ bool ConvexPolygon::Intersect(const ConvexPolygon& polygonA, const ConvexPolygon
 	if (samePolygon)
 	{
 		// Polygons A and B must be the same polygon.
-		*this = polygonA;
+		*this->vertexArray = *polygonA.vertexArray;
 		return true;
 	}
 
@@ -345,6 +403,123 @@ bool ConvexPolygon::Intersect(const ConvexPolygon& polygonA, const ConvexPolygon
 	return this->vertexArray->size() > 0;
 }
 
+// Here each polygon has vertices strictly in front of and strictly behind the other's plane, so each crosses
+// the other's plane along exactly two of its edges, and the intersection of the two polygons is whatever part
+// of the line between one polygon's crossing points is inside the other.  For triangles, this is the test of
+// Moller's "A Fast Triangle-Triangle Intersection Test."  We find the same crossing points that the general
+// approach would, in the same order, but decide whether each is inside the other polygon by comparing it against
+// that polygon's edges directly.  Only points within a few tolerances of an edge get the full containment test.
+// We return false if the polygons turn out not to be convex enough for this, leaving the general approach to it.
+bool ConvexPolygon::IntersectStraddling(const ConvexPolygon& polygonA, const Plane& planeA, const std::vector<Plane::Side>& sideArrayA,
+										const ConvexPolygon& polygonB, const Plane& planeB, const std::vector<Plane::Side>& sideArrayB, double eps)
+{
+	const ConvexPolygon* polygonArray[2] = { &polygonA, &polygonB };
+	const Plane* planeArray[2] = { &planeA, &planeB };
+	const std::vector<Plane::Side>* sideArrayArray[2] = { &sideArrayA, &sideArrayB };
+
+	Vector3 crossingPointArray[2][2];
+	Vector3 crossingEdgeEndArray[2][2];
+
+	for (int i = 0; i < 2; i++)
+	{
+		const ConvexPolygon* polygon = polygonArray[i];
+		const Plane* otherPlane = planeArray[1 - i];
+		const std::vector<Plane::Side>& sideArray = *sideArrayArray[i];
+
+		int numCrossings = 0;
+		for (int j = 0; j < (signed)polygon->vertexArray->size(); j++)
+		{
+			int k = (j + 1) % polygon->vertexArray->size();
+			if (sideArray[j] == sideArray[k])
+				continue;
+
+			if (numCrossings == 2)
+				return false;
+
+			const Vector3& vertexA = (*polygon->vertexArray)[j];
+			const Vector3& vertexB = (*polygon->vertexArray)[k];
+
+			Ray ray(vertexA, vertexB - vertexA);
+			double alpha = 0.0;
+			if (!ray.CastAgainst(*otherPlane, alpha) || alpha > 1.0)
+				return false;
+
+			crossingPointArray[i][numCrossings] = ray.Lerp(alpha);
+			crossingEdgeEndArray[i][numCrossings] = vertexB;
+			numCrossings++;
+		}
+
+		if (numCrossings != 2)
+			return false;
+	}
+
+	std::vector<Vector3> hitPointArray;
+
+	for (int i = 0; i < 2; i++)
+	{
+		const ConvexPolygon* otherPolygon = polygonArray[1 - i];
+		const Plane* otherPlane = planeArray[1 - i];
+
+		for (int j = 0; j < 2; j++)
+		{
+			const Vector3& crossingPoint = crossingPointArray[i][j];
+
+			// As in the general approach, a hit at the far end of an edge is left for the next edge to find.
+			if (crossingPoint.IsEqualTo(crossingEdgeEndArray[i][j]))
+				continue;
+
+			bool contained = true;
+			bool ambiguous = false;
+
+			int m = (int)otherPolygon->vertexArray->size();
+			for (int k = 0; k < m; k++)
+			{
+				const Vector3& vertexA = (*otherPolygon->vertexArray)[k];
+				const Vector3& vertexB = (*otherPolygon->vertexArray)[(k + 1) % m];
+
+				Vector3 edgeNormal = (vertexB - vertexA).Cross(otherPlane->normal);
+				double length = edgeNormal.Length();
+				if (length == 0.0)
+					continue;
+
+				double distance = (crossingPoint - vertexA).Dot(edgeNormal) / length;
+				if (distance > 2.0 * MESH_NINJA_EPS)
+				{
+					contained = false;
+					ambiguous = false;
+					break;
+				}
+				else if (distance > -MESH_NINJA_EPS)
+					ambiguous = true;
+			}
+
+			if (ambiguous)
+				contained = otherPolygon->ContainsPoint(crossingPoint, *otherPlane);
+
+			if (contained)
+				hitPointArray.push_back(crossingPoint);
+		}
+	}
+
+	for (const Vector3& hitPoint : hitPointArray)
+	{
+		bool pointFound = false;
+		for (const Vector3& vertex : *this->vertexArray)
+		{
+			if ((vertex - hitPoint).Length() < eps)
+			{
+				pointFound = true;
+				break;
+			}
+		}
+
+		if (!pointFound)
+			this->vertexArray->push_back(hitPoint);
+	}
+
+	return true;
+}
+
 bool ConvexPolygon::SplitAgainst(const Plane& cuttingPlane, ConvexPolygon& polygonA, ConvexPolygon& polygonB, double eps /*= MESH_NINJA_EPS*/) const
 {
 	polygonA.Clear();
@@ -2,6 +2,7 @@
 
 #include "Common.h"
 #include "Math/Vector3.h"
+#include "Plane.h"
 
 namespace MeshNinja
 {
@@ -31,10 +32,16 @@ namespace MeshNinja
 		bool Intersect(const ConvexPolygon& polygonA, const ConvexPolygon& polygonB, double eps = MESH_NINJA_EPS);
 		bool IntersectWithLineSegment(const Vector3& pointA, const Vector3& pointB, Vector3& intersectionPoint, double eps = MESH_NINJA_EPS) const;
 		bool ContainsPoint(const Vector3& point, bool* isInteriorPoint = nullptr, double eps = MESH_NINJA_EPS) const;
+		bool ContainsPoint(const Vector3& point, const Plane& plane, bool* isInteriorPoint = nullptr, double eps = MESH_NINJA_EPS) const;
 		bool ContainsPointOnBoundary(const Vector3& point, double eps = MESH_NINJA_EPS) const;
 		bool SplitAgainst(const Plane& cuttingPlane, ConvexPolygon& polygonA, ConvexPolygon& polygonB, double eps = MESH_NINJA_EPS) const;
 		void MakeReverseOf(const ConvexPolygon& polygon);
 
 		std::vector<Vector3>* vertexArray;
+
+	protected:
+
+		bool IntersectStraddling(const ConvexPolygon& polygonA, const Plane& planeA, const std::vector<Plane::Side>& sideArrayA,
+								const ConvexPolygon& polygonB, const Plane& planeB, const std::vector<Plane::Side>& sideArrayB, double eps);
 	};
 }
\ No newline at end of file
@@ -2,6 +2,11 @@
 #include "LineSegment.h"
 #include "Plane.h"
 #include "SpaceCurve.h"
+#include "MeshSlicer.h"
+#include "MeshCache.h"
+#include "FacetTriangulator.h"
+#include "TaskScheduler.h"
+#include "SpatialHash.h"
 
 using namespace MeshNinja;
 
@@ -9,47 +14,33 @@ using namespace MeshNinja;
 
 ConvexPolygonMesh::ConvexPolygonMesh()
 {
-	this->facetArray = new std::vector<Facet>();
-	this->vertexArray = new std::vector<Vector3>();
 }
 
 ConvexPolygonMesh::ConvexPolygonMesh(const ConvexPolygonMesh& mesh)
 {
-	this->facetArray = new std::vector<Facet>();
-	this->vertexArray = new std::vector<Vector3>();
-
 	this->Copy(mesh);
 }
 
 ConvexPolygonMesh::ConvexPolygonMesh(const std::vector<ConvexPolygon>& polygonArray)
 {
-	this->facetArray = new std::vector<Facet>();
-	this->vertexArray = new std::vector<Vector3>();
-
 	this->FromConvexPolygonArray(polygonArray);
 }
 
 /*virtual*/ ConvexPolygonMesh::~ConvexPolygonMesh()
 {
-	delete this->facetArray;
-	delete this->vertexArray;
 }
 
 void ConvexPolygonMesh::Clear()
 {
-	this->facetArray->clear();
-	this->vertexArray->clear();
+	this->facetArray.Clear();
+	this->vertexArray.Clear();
 }
 
+// The arrays are shared with the given mesh until one or the other of us changes them.
 void ConvexPolygonMesh::Copy(const ConvexPolygonMesh& mesh)
 {
-	this->Clear();
-
-	for (const Vector3& vertex : *mesh.vertexArray)
-		this->vertexArray->push_back(vertex);
-
-	for (const Facet& facet : *mesh.facetArray)
-		this->facetArray->push_back(facet);
+	this->facetArray = mesh.facetArray;
+	this->vertexArray = mesh.vertexArray;
 }
 
 bool ConvexPolygonMesh::AllFacetsValid(double eps /*= MESH_NINJA_EPS*/) const
@@ -100,15 +91,115 @@ void ConvexPolygonMesh::ApplyTransform(const Transform& transform)
 
 void ConvexPolygonMesh::Compress(double eps /*= MESH_NINJA_EPS*/)
 {
-	std::vector<ConvexPolygon> polygonArray;
-	this->ToConvexPolygonArray(polygonArray);
-	for (ConvexPolygon& polygon : polygonArray)
-		polygon.Compress(eps);
-
-	this->FromConvexPolygonArray(polygonArray);
+	this->Compact(nullptr, eps);
 	this->UntessellateFaces(eps);
 }
 
+// This cleans up the mesh where it stands, in time linear in its size.  Vertices within the given distance of one
+// another are welded together, each facet then loses any corner repeated or in line with its neighbors, facets left
+// with fewer than three corners are dropped, and vertices no longer used by any facet are deleted.  The remap array,
+// if given, gets the new index of each old vertex, or -1 for those deleted, so that anything kept alongside the
+// vertices can be brought into line with them.
+void ConvexPolygonMesh::Compact(std::vector<int>* remapArray /*= nullptr*/, double eps /*= MESH_NINJA_EPS*/)
+{
+	int numVertices = (int)this->vertexArray->size();
+
+	SpatialHash vertexHash(eps);
+	std::vector<int> weldArray(numVertices);
+	for (int i = 0; i < numVertices; i++)
+		weldArray[i] = vertexHash.WeldPoint((*this->vertexArray)[i], eps);
+
+	// This is the same test for a corner being in line with its neighbors that ConvexPolygon::Compress uses.
+	auto inLine = [&vertexHash, eps](int i, int j, int k) -> bool
+	{
+		double triangleArea = (vertexHash[j] - vertexHash[i]).Cross(vertexHash[k] - vertexHash[i]).Length() / 2.0;
+		return triangleArea < eps;
+	};
+
+	std::vector<int> newIndexArray(vertexHash.Size(), -1);
+	std::vector<Facet>& facetArray = *this->facetArray;
+	int numFacets = 0;
+
+	for (int i = 0; i < (signed)facetArray.size(); i++)
+	{
+		// Corners are pushed onto the front of the array as we go, taking the last one off again whenever
+		// it turns out to be a repeat of, or in line with, those before it.
+		std::vector<int>& polygon = *facetArray[i].vertexArray;
+		int first = 0, end = 0;
+
+		for (int j = 0; j < (signed)polygon.size(); j++)
+		{
+			polygon[end++] = weldArray[polygon[j]];
+
+			while (true)
+			{
+				if (end >= 2 && polygon[end - 2] == polygon[end - 1])
+					end--;
+				else if (end >= 3 && inLine(polygon[end - 3], polygon[end - 2], polygon[end - 1]))
+				{
+					polygon[end - 2] = polygon[end - 1];
+					end--;
+				}
+				else
+					break;
+			}
+		}
+
+		// Only the corners where the polygon wraps around are left to check.
+		while (end - first >= 2)
+		{
+			if (polygon[end - 1] == polygon[first])
+				end--;
+			else if (end - first >= 3 && inLine(polygon[end - 2], polygon[end - 1], polygon[first]))
+				end--;
+			else if (end - first >= 3 && inLine(polygon[end - 1], polygon[first], polygon[first + 1]))
+				first++;
+			else
+				break;
+		}
+
+		if (end - first < 3)
+			continue;
+
+		polygon.erase(polygon.begin() + end, polygon.end());
+		polygon.erase(polygon.begin(), polygon.begin() + first);
+
+		for (int j : polygon)
+			newIndexArray[j] = 0;	// This just marks the vertex as used for now.
+
+		if (numFacets != i)
+			facetArray[numFacets].vertexArray.Swap(facetArray[i].vertexArray);
+
+		numFacets++;
+	}
+
+	facetArray.resize(numFacets);
+
+	// The welded vertices used by what's left are numbered in the order they were first seen.
+	std::vector<Vector3>& vertexArray = *this->vertexArray;
+	vertexArray.clear();
+
+	for (int i = 0; i < (signed)newIndexArray.size(); i++)
+	{
+		if (newIndexArray[i] >= 0)
+		{
+			newIndexArray[i] = (int)vertexArray.size();
+			vertexArray.push_back(vertexHash[i]);
+		}
+	}
+
+	for (Facet& facet : facetArray)
+		for (int& j : *facet.vertexArray)
+			j = newIndexArray[j];
+
+	if (remapArray)
+	{
+		remapArray->resize(numVertices);
+		for (int i = 0; i < numVertices; i++)
+			(*remapArray)[i] = newIndexArray[weldArray[i]];
+	}
+}
+
 void ConvexPolygonMesh::UntessellateFaces(double eps /*= MESH_NINJA_EPS*/)
 {
 	std::list<Facet> facetQueue;
@@ -142,29 +233,28 @@ void ConvexPolygonMesh::UntessellateFaces(double eps /*= MESH_NINJA_EPS*/)
 	}
 }
 
-void ConvexPolygonMesh::TessellateFaces(double eps /*= MESH_NINJA_EPS*/)
+// The triangles of all the facets are found at once, and each facet is then replaced by its own in parallel.
+// Triangles of no more than the given area are left out, since they add nothing to the surface.
+void ConvexPolygonMesh::TessellateFaces(double eps /*= MESH_NINJA_EPS*/, int threadCount /*= 0*/)
 {
-	std::list<Facet> facetQueue;
-	for (Facet& facet : *this->facetArray)
-		facetQueue.push_back(facet);
+	FacetTriangulator triangulator;
+	std::vector<uint32_t> indexArray;
+	triangulator.Triangulate(*this, indexArray, nullptr, threadCount);
 
-	this->facetArray->clear();
+	FacetTriangulator::RemoveSmallTriangles(*this->vertexArray, indexArray, nullptr, eps);
 
-	while (facetQueue.size() > 0)
-	{
-		std::list<Facet>::iterator iter = facetQueue.begin();
-		Facet facet = *iter;
-		facetQueue.erase(iter);
+	int numTriangles = (int)indexArray.size() / 3;
 
-		Facet facetA, facetB;
-		if (!facet.Split(facetA, facetB, this))
-			this->facetArray->push_back(facet);
-		else
+	this->facetArray.Clear();
+	this->facetArray->resize(numTriangles);
+
+	std::vector<Facet>& facetArray = *this->facetArray;
+
+	TaskScheduler::ParallelFor(0, numTriangles, 1024, [&facetArray, &indexArray](int start, int stop)
 		{
-			facetQueue.push_back(facetA);
-			facetQueue.push_back(facetB);
-		}
-	}
+			for (int i = start; i < stop; i++)
+				facetArray[i].vertexArray->assign(&indexArray[3 * i], &indexArray[3 * i] + 3);
+		}, threadCount);
 }
 
 void ConvexPolygonMesh::NormalizeEdges(double eps /*= MESH_NINJA_EPS*/)
@@ -375,6 +465,19 @@ bool ConvexPolygonMesh::GeneratePolyhedron(Polyhedron polyhedron, double eps /*=
 	return this->GenerateConvexHull(pointArray);
 }
 
+bool ConvexPolygonMesh::GenerateConvexHull(const std::vector<Vector3>& pointArray, MeshCache& cache, double eps /*= MESH_NINJA_EPS*/)
+{
+	uint64_t key = MeshCache::Hash(pointArray, MeshCache::Hash(&eps, sizeof(eps), MeshCache::Hash("hull")));
+	if (cache.LoadMesh(key, *this))
+		return true;
+
+	if (!this->GenerateConvexHull(pointArray, eps))
+		return false;
+
+	cache.StoreMesh(key, *this);
+	return true;
+}
+
 // Interestingly, this algorithm is also a proof that any polyhedron is the sum of tetrahedrons.
 bool ConvexPolygonMesh::GenerateConvexHull(const std::vector<Vector3>& pointArray, double eps /*= MESH_NINJA_EPS*/)
 {
@@ -579,6 +682,16 @@ bool ConvexPolygonMesh::AddRedundantVertex(const Vector3& vertex, double eps /*=
 	return addVertex;
 }
 
+// Like splitting a polygon, meshA gets what's in front of the plane and meshB what's behind it.
+// With capping, each half is closed off where it was cut, so that a closed mesh splits into closed meshes.
+bool ConvexPolygonMesh::SplitAgainst(const Plane& cuttingPlane, ConvexPolygonMesh& meshA, ConvexPolygonMesh& meshB, bool cap /*= true*/, double eps /*= MESH_NINJA_EPS*/) const
+{
+	MeshSlicer slicer;
+	slicer.capContours = cap;
+	slicer.eps = eps;
+	return slicer.Split(*this, cuttingPlane, meshA, meshB);
+}
+
 bool ConvexPolygonMesh::GenerateSphere(double radius, int segments, int slices)
 {
 	if (segments < 3 || slices < 3)
@@ -924,19 +1037,19 @@ void ConvexPolygonMesh::Triangle::MakePlane(Plane& plane, const std::vector<Vect
 
 ConvexPolygonMesh::Facet::Facet()
 {
-	this->vertexArray = new std::vector<int>();
 }
 
-ConvexPolygonMesh::Facet::Facet(const Facet& facet)
+ConvexPolygonMesh::Facet::Facet(const Facet& facet) : vertexArray(facet.vertexArray)
 {
-	this->vertexArray = new std::vector<int>();
-	for (int i : *facet.vertexArray)
-		this->vertexArray->push_back(i);
 }
 
 /*virtual*/ ConvexPolygonMesh::Facet::~Facet()
 {
-	delete this->vertexArray;
+}
+
+void ConvexPolygonMesh::Facet::operator=(const Facet& facet)
+{
+	this->vertexArray = facet.vertexArray;
 }
 
 void ConvexPolygonMesh::Facet::MakePolygon(ConvexPolygon& polygon, const ConvexPolygonMesh* mesh) const
@@ -4,9 +4,12 @@
 #include "Math/Vector3.h"
 #include "Math/Transform.h"
 #include "ConvexPolygon.h"
+#include "SharedBuffer.h"
 
 namespace MeshNinja
 {
+	class MeshCache;
+
 	// Each face is assumed to be a convex polygon.  If this is not the case, then
 	// we simply leave the results of all algorithms as undefined.
 	class MESH_NINJA_API ConvexPolygonMesh
@@ -34,12 +37,14 @@ namespace MeshNinja
 		bool IsConvex(double eps = MESH_NINJA_EPS) const;
 		bool IsConcave(double eps = MESH_NINJA_EPS) const;
 		void Compress(double eps = MESH_NINJA_EPS);
+		void Compact(std::vector<int>* remapArray = nullptr, double eps = MESH_NINJA_EPS);
 		void NormalizeEdges(double eps = MESH_NINJA_EPS);
 		void UntessellateFaces(double eps = MESH_NINJA_EPS);
-		void TessellateFaces(double eps = MESH_NINJA_EPS);
+		void TessellateFaces(double eps = MESH_NINJA_EPS, int threadCount = 0);
 		void ToConvexPolygonArray(std::vector<ConvexPolygon>& convexPolygonArray, bool concatinate = true) const;
 		void FromConvexPolygonArray(const std::vector<ConvexPolygon>& convexPolygonArray);
 		bool GenerateConvexHull(const std::vector<Vector3>& pointArray, double eps = MESH_NINJA_EPS);
+		bool GenerateConvexHull(const std::vector<Vector3>& pointArray, MeshCache& cache, double eps = MESH_NINJA_EPS);
 		bool GeneratePolyhedron(Polyhedron polyhedron, double eps = MESH_NINJA_EPS);
 		bool GenerateSphere(double radius, int segments, int slices);
 		bool GenerateCylinder(double length, double radius, int segments, int slices);
@@ -53,6 +58,7 @@ namespace MeshNinja
 		void ReverseAllPolygons();
 		void CenterAndScale(double radius);
 		bool AddRedundantVertex(const Vector3& vertex, double eps = MESH_NINJA_EPS);
+		bool SplitAgainst(const Plane& cuttingPlane, ConvexPolygonMesh& meshA, ConvexPolygonMesh& meshB, bool cap = true, double eps = MESH_NINJA_EPS) const;
 
 		struct MESH_NINJA_API Triangle
 		{
@@ -70,6 +76,8 @@ namespace MeshNinja
 			Facet(const Facet& facet);
 			virtual ~Facet();
 
+			void operator=(const Facet& facet);
+
 			struct AngleStats
 			{
 				double smallestInteriorAngle;
@@ -88,10 +96,10 @@ namespace MeshNinja
 				return (*this->vertexArray)[i];
 			}
 
-			std::vector<int>* vertexArray;
+			SharedBuffer<int> vertexArray;
 		};
 
-		std::vector<Facet>* facetArray;
-		std::vector<Vector3>* vertexArray;
+		SharedBuffer<Facet> facetArray;
+		SharedBuffer<Vector3> vertexArray;
 	};
 }
\ No newline at end of file
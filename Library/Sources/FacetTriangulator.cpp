@@ -0,0 +1,192 @@
+#include "FacetTriangulator.h"
+#include "ConvexPolygonMesh.h"
+#include "TaskScheduler.h"
+
+using namespace MeshNinja;
+
+FacetTriangulator::FacetTriangulator()
+{
+	this->method = Method::MIN_ANGLE;
+	this->maxMinAngleSides = 32;
+}
+
+/*virtual*/ FacetTriangulator::~FacetTriangulator()
+{
+}
+
+bool FacetTriangulator::Triangulate(const ConvexPolygonMesh& mesh, std::vector<uint32_t>& indexArray, std::vector<int>* triangleOffsetArray /*= nullptr*/, int threadCount /*= 0*/) const
+{
+	std::vector<int> localTriangleOffsetArray;
+	if (!triangleOffsetArray)
+		triangleOffsetArray = &localTriangleOffsetArray;
+
+	std::vector<int>& offsetArray = *triangleOffsetArray;
+
+	int numFacets = (int)mesh.facetArray->size();
+	offsetArray.resize(numFacets + 1);
+	offsetArray[0] = 0;
+
+	for (int i = 0; i < numFacets; i++)
+	{
+		int numSides = (int)(*mesh.facetArray)[i].vertexArray->size();
+		offsetArray[i + 1] = offsetArray[i] + MESH_NINJA_MAX(numSides - 2, 0);
+	}
+
+	indexArray.resize(3 * offsetArray[numFacets]);
+
+	TaskScheduler::ParallelFor(0, numFacets, 256, [this, &mesh, &indexArray, &offsetArray](int start, int stop)
+		{
+			Workspace workspace;
+
+			for (int i = start; i < stop; i++)
+			{
+				const std::vector<int>& polygon = *(*mesh.facetArray)[i].vertexArray;
+				if (polygon.size() >= 3)
+					this->TriangulateFacet(polygon, *mesh.vertexArray, &indexArray[3 * offsetArray[i]], workspace);
+			}
+		}, threadCount);
+
+	return indexArray.size() > 0;
+}
+
+// The triangles are moved down over those taken out, so the triangles of each facet stay together and in order.
+/*static*/ void FacetTriangulator::RemoveSmallTriangles(const std::vector<Vector3>& pointArray, std::vector<uint32_t>& indexArray, std::vector<int>* triangleOffsetArray /*= nullptr*/, double eps /*= MESH_NINJA_EPS*/)
+{
+	std::vector<int> localTriangleOffsetArray{ 0, (int)indexArray.size() / 3 };
+	std::vector<int>& offsetArray = triangleOffsetArray ? *triangleOffsetArray : localTriangleOffsetArray;
+
+	int numKept = 0;
+
+	for (int i = 0; i + 1 < (signed)offsetArray.size(); i++)
+	{
+		int start = offsetArray[i];
+		int stop = offsetArray[i + 1];
+		offsetArray[i] = numKept;
+
+		for (int j = start; j < stop; j++)
+		{
+			const Vector3& pointA = pointArray[indexArray[3 * j]];
+			const Vector3& pointB = pointArray[indexArray[3 * j + 1]];
+			const Vector3& pointC = pointArray[indexArray[3 * j + 2]];
+
+			double area = (pointB - pointA).Cross(pointC - pointA).Length() / 2.0;
+			if (area <= eps)
+				continue;
+
+			for (int k = 0; k < 3; k++)
+				indexArray[3 * numKept + k] = indexArray[3 * j + k];
+
+			numKept++;
+		}
+	}
+
+	offsetArray.back() = numKept;
+	indexArray.resize(3 * numKept);
+}
+
+// For the smallest angle, each diagonal (i, j) of the facet, taken with the sides from i to j, cuts off a smaller
+// convex polygon.  The best triangulation of that is the triangle (i, k, j), for some corner k between them, along
+// with the best triangulations of the polygons cut off by (i, k) and (k, j), so these are found for all diagonals,
+// shortest first, and the triangles are then read back from the choices of k, starting with the whole facet.
+void FacetTriangulator::TriangulateFacet(const std::vector<int>& polygon, const std::vector<Vector3>& pointArray, uint32_t* triangle, Workspace& workspace) const
+{
+	int n = (int)polygon.size();
+
+	if (this->method == Method::FAN || n == 3 || n > this->maxMinAngleSides)
+	{
+		for (int k = 1; k < n - 1; k++)
+		{
+			*triangle++ = uint32_t(polygon[0]);
+			*triangle++ = uint32_t(polygon[k]);
+			*triangle++ = uint32_t(polygon[k + 1]);
+		}
+
+		return;
+	}
+
+	std::vector<double>& qualityTable = workspace.qualityTable;
+	std::vector<int>& choiceTable = workspace.choiceTable;
+	std::vector<int>& spanStack = workspace.spanStack;
+
+	qualityTable.resize(n * n);
+	choiceTable.resize(n * n);
+
+	for (int i = 0; i < n - 1; i++)
+		qualityTable[i * n + i + 1] = DBL_MAX;
+
+	for (int span = 2; span < n; span++)
+	{
+		for (int i = 0; i + span < n; i++)
+		{
+			int j = i + span;
+			const Vector3& pointI = pointArray[polygon[i]];
+			const Vector3& pointJ = pointArray[polygon[j]];
+
+			double bestQuality = -1.0;
+			int bestK = i + 1;
+
+			for (int k = i + 1; k < j; k++)
+			{
+				double quality = MESH_NINJA_MIN(qualityTable[i * n + k], qualityTable[k * n + j]);
+				if (quality <= bestQuality)
+					continue;
+
+				quality = MESH_NINJA_MIN(quality, CalcTriangleQuality(pointI, pointArray[polygon[k]], pointJ));
+				if (quality > bestQuality)
+				{
+					bestQuality = quality;
+					bestK = k;
+				}
+			}
+
+			qualityTable[i * n + j] = bestQuality;
+			choiceTable[i * n + j] = bestK;
+		}
+	}
+
+	spanStack.clear();
+	spanStack.push_back(0);
+	spanStack.push_back(n - 1);
+
+	while (spanStack.size() > 0)
+	{
+		int j = spanStack.back();
+		spanStack.pop_back();
+		int i = spanStack.back();
+		spanStack.pop_back();
+
+		int k = choiceTable[i * n + j];
+
+		*triangle++ = uint32_t(polygon[i]);
+		*triangle++ = uint32_t(polygon[k]);
+		*triangle++ = uint32_t(polygon[j]);
+
+		if (k - i >= 2)
+		{
+			spanStack.push_back(i);
+			spanStack.push_back(k);
+		}
+
+		if (j - k >= 2)
+		{
+			spanStack.push_back(k);
+			spanStack.push_back(j);
+		}
+	}
+}
+
+// The smallest angle of a triangle is opposite its shortest side, and is never more than sixty degrees, so its sine,
+// which is twice the area over the product of the other two sides, orders triangles the same way the angle does.
+/*static*/ double FacetTriangulator::CalcTriangleQuality(const Vector3& pointA, const Vector3& pointB, const Vector3& pointC)
+{
+	double lengthA = (pointC - pointB).Length();
+	double lengthB = (pointA - pointC).Length();
+	double lengthC = (pointB - pointA).Length();
+
+	double shortestLength = MESH_NINJA_MIN(lengthA, MESH_NINJA_MIN(lengthB, lengthC));
+	if (shortestLength <= 0.0)
+		return 0.0;
+
+	double doubleArea = (pointB - pointA).Cross(pointC - pointA).Length();
+	return doubleArea * shortestLength / (lengthA * lengthB * lengthC);
+}
\ No newline at end of file
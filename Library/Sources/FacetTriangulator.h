@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Common.h"
+#include "Math/Vector3.h"
+#include <stdint.h>
+
+namespace MeshNinja
+{
+	class ConvexPolygonMesh;
+
+	// This cuts every facet of a mesh into triangles, all at once, writing them into a single flat array of vertex
+	// indices, three to a triangle.  A convex facet of N sides always gives N - 2 triangles, so where each facet's
+	// triangles go is known from a running sum of the facet sizes before any of them are made, and the facets are
+	// then done in parallel, each straight into its own part of the array.  Facets of fewer than three sides give
+	// no triangles.  The triangles of a facet are wound the same way it is.
+	class MESH_NINJA_API FacetTriangulator
+	{
+	public:
+		FacetTriangulator();
+		virtual ~FacetTriangulator();
+
+		enum class Method
+		{
+			FAN,
+			MIN_ANGLE
+		};
+
+		// If a triangle offset array is given, it gets the number of the first triangle of each facet, along with
+		// the total number of triangles at the end, so the triangles of facet i run up to, but not including, those
+		// of facet i + 1.
+		bool Triangulate(const ConvexPolygonMesh& mesh, std::vector<uint32_t>& indexArray, std::vector<int>* triangleOffsetArray = nullptr, int threadCount = 0) const;
+
+		// Triangles of no more than the given area are taken out of the index array, and the triangle offsets, if
+		// given, are moved to match.
+		static void RemoveSmallTriangles(const std::vector<Vector3>& pointArray, std::vector<uint32_t>& indexArray, std::vector<int>* triangleOffsetArray = nullptr, double eps = MESH_NINJA_EPS);
+
+		// A fan just joins the first corner of a facet to all the others.  Otherwise, the triangles are chosen
+		// to make their smallest angle as large as possible, which takes time in proportion to the cube of the
+		// number of sides, so facets with more sides than the given maximum are fanned regardless.
+		Method method;
+		int maxMinAngleSides;
+
+	protected:
+
+		// This is the scratch space for finding the triangles of a facet, kept from one facet to the next.
+		// Entry (i, j) of each table is for the part of the facet cut off by the diagonal from corner i to j.
+		struct Workspace
+		{
+			std::vector<double> qualityTable;
+			std::vector<int> choiceTable;
+			std::vector<int> spanStack;
+		};
+
+		void TriangulateFacet(const std::vector<int>& polygon, const std::vector<Vector3>& pointArray, uint32_t* triangle, Workspace& workspace) const;
+
+		static double CalcTriangleQuality(const Vector3& pointA, const Vector3& pointB, const Vector3& pointC);
+	};
+}
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "ObjFileFormat.h"
 #include "../ConvexPolygonMesh.h"
+#include "../TaskScheduler.h"
 
 using namespace MeshNinja;
 
@@ -35,6 +36,8 @@ void ObjFileFormat::TokenizeLine(const std::string& line, char delimeter, std::v
 			tokenArray.push_back(token);
 }
 
+// The file is cut into chunks at line breaks and the chunks are parsed in parallel.  A face can refer to any vertex
+// before it, so we first count the vertices in each chunk, and each chunk then knows how many come before it.
 /*virtual*/ bool ObjFileFormat::LoadMesh(const std::string& filePath, ConvexPolygonMesh& mesh, int meshNumber /*= 0*/)
 {
 	// TODO: Obey the given mesh number.
@@ -45,19 +48,87 @@ void ObjFileFormat::TokenizeLine(const std::string& line, char delimeter, std::v
 	if (!fileStream.is_open())
 		return false;
 
-	std::string line;
-	while (std::getline(fileStream, line))
+	std::string text((std::istreambuf_iterator<char>(fileStream)), std::istreambuf_iterator<char>());
+	fileStream.close();
+
+	int minBytesPerChunk = 256 * 1024;
+	int numChunks = MESH_NINJA_MAX(1, MESH_NINJA_MIN(4 * TaskScheduler::Get()->GetThreadCount(), (int)(text.size() / minBytesPerChunk)));
+
+	std::vector<size_t> chunkStartArray;
+	chunkStartArray.push_back(0);
+	for (int i = 1; i < numChunks; i++)
 	{
-		std::vector<std::string> tokenArray;
-		this->TokenizeLine(line, ' ', tokenArray, true);
-		this->ProcessLine(tokenArray, mesh);
+		size_t start = text.find('\n', text.size() * i / numChunks);
+		if (start == std::string::npos)
+			break;
+
+		if (start + 1 > chunkStartArray.back())
+			chunkStartArray.push_back(start + 1);
+	}
+
+	chunkStartArray.push_back(text.size());
+	numChunks = (int)chunkStartArray.size() - 1;
+
+	std::vector<int> vertexOffsetArray(numChunks + 1, 0);
+
+	TaskScheduler::ParallelFor(0, numChunks, 1, [&text, &chunkStartArray, &vertexOffsetArray](int start, int stop)
+		{
+			for (int i = start; i < stop; i++)
+			{
+				bool lineStart = true;
+				for (size_t j = chunkStartArray[i]; j < chunkStartArray[i + 1]; j++)
+				{
+					char ch = text[j];
+					if (ch == '\n')
+						lineStart = true;
+					else if (lineStart && ch != ' ')
+					{
+						if (ch == 'v' && (j + 1 == text.size() || text[j + 1] == ' ' || text[j + 1] == '\n'))
+							vertexOffsetArray[i + 1]++;
+
+						lineStart = false;
+					}
+				}
+			}
+		});
+
+	for (int i = 0; i < numChunks; i++)
+		vertexOffsetArray[i + 1] += vertexOffsetArray[i];
+
+	std::vector<ConvexPolygonMesh> chunkMeshArray(numChunks);
+
+	TaskScheduler::ParallelFor(0, numChunks, 1, [this, &text, &chunkStartArray, &vertexOffsetArray, &chunkMeshArray](int start, int stop)
+		{
+			for (int i = start; i < stop; i++)
+			{
+				std::stringstream stringStream(text.substr(chunkStartArray[i], chunkStartArray[i + 1] - chunkStartArray[i]));
+				std::string line;
+				while (std::getline(stringStream, line))
+				{
+					std::vector<std::string> tokenArray;
+					this->TokenizeLine(line, ' ', tokenArray, true);
+					this->ProcessLine(tokenArray, chunkMeshArray[i], vertexOffsetArray[i]);
+				}
+			}
+		});
+
+	mesh.vertexArray->reserve(vertexOffsetArray[numChunks]);
+
+	for (const ConvexPolygonMesh& chunkMesh : chunkMeshArray)
+	{
+		for (const Vector3& vertex : *chunkMesh.vertexArray)
+			mesh.vertexArray->push_back(vertex);
+
+		for (const ConvexPolygonMesh::Facet& facet : *chunkMesh.facetArray)
+			mesh.facetArray->push_back(facet);
 	}
 
-	fileStream.close();
 	return true;
 }
 
-void ObjFileFormat::ProcessLine(const std::vector<std::string>& tokenArray, ConvexPolygonMesh& mesh)
+// The vertices of the given mesh are those of the file after the given number of them, so the faces it's given
+// refer to vertices by where they are in the file, not in the given mesh.
+void ObjFileFormat::ProcessLine(const std::vector<std::string>& tokenArray, ConvexPolygonMesh& mesh, int vertexOffset)
 {
 	if (tokenArray.size() == 0 || tokenArray[0] == "#")
 		return;
@@ -75,6 +146,7 @@ void ObjFileFormat::ProcessLine(const std::vector<std::string>& tokenArray, Conv
 	else if (tokenArray[0] == "f" && tokenArray.size() > 1)
 	{
 		ConvexPolygonMesh::Facet facet;
+		int numVertices = vertexOffset + (int)mesh.vertexArray->size();
 
 		for (const std::string& token : tokenArray)
 		{
@@ -89,12 +161,12 @@ void ObjFileFormat::ProcessLine(const std::vector<std::string>& tokenArray, Conv
 			if (i > 0)
 				i--;
 			else if (i < 0)
-				i = int(mesh.vertexArray->size()) - 1;
+				i = numVertices - 1;
 
 			if (i < 0)
 				i = 0;
-			else if (i >= (signed)mesh.vertexArray->size())
-				i = (int)mesh.vertexArray->size() - 1;
+			else if (i >= numVertices)
+				i = numVertices - 1;
 
 			facet.vertexArray->push_back(i);
 		}
@@ -21,6 +21,6 @@ namespace MeshNinja
 	protected:
 
 		void TokenizeLine(const std::string& line, char delimeter, std::vector<std::string>& tokenArray, bool stripEmptyTokens);
-		void ProcessLine(const std::vector<std::string>& tokenArray, ConvexPolygonMesh& mesh);
+		void ProcessLine(const std::vector<std::string>& tokenArray, ConvexPolygonMesh& mesh, int vertexOffset);
 	};
 }
\ No newline at end of file
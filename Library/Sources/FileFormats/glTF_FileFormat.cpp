@@ -32,6 +32,13 @@ glTF_FileFormat::glTF_FileFormat()
 	return false;
 }
 
+/*virtual*/ void glTF_FileFormat::GetSavedFilePaths(const std::string& filePath, std::vector<std::string>& filePathArray) const
+{
+	filePathArray.clear();
+	filePathArray.push_back(filePath);
+	filePathArray.push_back(std::filesystem::path(filePath).replace_extension(".bin").string());
+}
+
 /*virtual*/ bool glTF_FileFormat::SaveRenderMesh(const std::string& filePath, const RenderMesh& mesh)
 {
 	bool success = false;
@@ -39,6 +39,8 @@ namespace MeshNinja
 		virtual bool LoadRenderMesh(const std::string& filePath, RenderMesh& mesh, int meshNumber = 0) override;
 		virtual bool SaveRenderMesh(const std::string& filePath, const RenderMesh& mesh) override;
 
+		virtual void GetSavedFilePaths(const std::string& filePath, std::vector<std::string>& filePathArray) const override;
+
 	private:
 
 		bool WriteIndexBuffer(const RenderMesh& mesh, std::ofstream& binFileStream, JsonArray* jsonBufferViewsArray, JsonArray* jsonAccessorsArray, JsonObject* jsonPrim);
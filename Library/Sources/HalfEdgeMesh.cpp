@@ -0,0 +1,732 @@
+#include "HalfEdgeMesh.h"
+#include "ConvexPolygonMesh.h"
+#include "MeshGraph.h"
+
+using namespace MeshNinja;
+
+HalfEdgeMesh::HalfEdgeMesh()
+{
+	this->vertexArray = new std::vector<Vertex>();
+	this->halfEdgeArray = new std::vector<HalfEdge>();
+	this->facetArray = new std::vector<Facet>();
+	this->freeVertexArray = new std::vector<int>();
+	this->freeHalfEdgeArray = new std::vector<int>();
+	this->freeFacetArray = new std::vector<int>();
+}
+
+/*virtual*/ HalfEdgeMesh::~HalfEdgeMesh()
+{
+	delete this->vertexArray;
+	delete this->halfEdgeArray;
+	delete this->facetArray;
+	delete this->freeVertexArray;
+	delete this->freeHalfEdgeArray;
+	delete this->freeFacetArray;
+}
+
+void HalfEdgeMesh::Clear()
+{
+	this->vertexArray->clear();
+	this->halfEdgeArray->clear();
+	this->facetArray->clear();
+	this->freeVertexArray->clear();
+	this->freeHalfEdgeArray->clear();
+	this->freeFacetArray->clear();
+}
+
+// Each directed edge of each facet becomes a half-edge, found again by a hash of its ends when its twin is looked for.
+// A directed edge found twice means two facets wound against one another, or more than two facets on an edge.
+// Directed edges without twins go around holes, and their twins are made here, and linked one to the next around
+// each hole, which only works if no vertex is on more than one stretch of border.
+bool HalfEdgeMesh::FromConvexPolygonMesh(const ConvexPolygonMesh& mesh)
+{
+	this->Clear();
+
+	this->vertexArray->reserve(mesh.vertexArray->size());
+	for (const Vector3& point : *mesh.vertexArray)
+		this->NewVertex(point);
+
+	std::unordered_map<uint64_t, int> halfEdgeMap;
+
+	for (const ConvexPolygonMesh::Facet& facet : *mesh.facetArray)
+	{
+		int numVertices = (int)facet.vertexArray->size();
+		if (numVertices < 3)
+			continue;
+
+		int i = this->NewFacet();
+		int firstHalfEdge = (int)this->halfEdgeArray->size();
+		(*this->facetArray)[i].halfEdge = firstHalfEdge;
+
+		for (int j = 0; j < numVertices; j++)
+		{
+			MeshGraph::VertexPair<true> pair{ facet[j], facet[(j + 1) % numVertices] };
+			if (pair.i == pair.j || halfEdgeMap.find(pair.CalcKey()) != halfEdgeMap.end())
+			{
+				this->Clear();
+				return false;
+			}
+
+			int k = this->NewHalfEdge();
+			halfEdgeMap.insert(std::pair<uint64_t, int>(pair.CalcKey(), k));
+
+			HalfEdge& halfEdge = (*this->halfEdgeArray)[k];
+			halfEdge.vertex = pair.i;
+			halfEdge.facet = i;
+		}
+
+		for (int j = 0; j < numVertices; j++)
+			this->LinkHalfEdges(firstHalfEdge + j, firstHalfEdge + (j + 1) % numVertices);
+	}
+
+	int numFacetHalfEdges = (int)this->halfEdgeArray->size();
+	std::vector<int> borderHalfEdgeArray(this->vertexArray->size(), -1);
+
+	for (int i = 0; i < numFacetHalfEdges; i++)
+	{
+		int vertexA = (*this->halfEdgeArray)[i].vertex;
+		int vertexB = this->GetDestination(i);
+
+		auto iter = halfEdgeMap.find(MeshGraph::VertexPair<true>{ vertexB, vertexA }.CalcKey());
+		if (iter != halfEdgeMap.end())
+		{
+			(*this->halfEdgeArray)[i].twin = iter->second;
+			continue;
+		}
+
+		if (borderHalfEdgeArray[vertexB] >= 0)
+		{
+			this->Clear();
+			return false;
+		}
+
+		int j = this->NewHalfEdge();
+		HalfEdge& borderHalfEdge = (*this->halfEdgeArray)[j];
+		borderHalfEdge.vertex = vertexB;
+		borderHalfEdge.facet = -1;
+		borderHalfEdge.twin = i;
+		(*this->halfEdgeArray)[i].twin = j;
+		borderHalfEdgeArray[vertexB] = j;
+	}
+
+	// Each of these ends where its twin starts, and the next one around the hole starts there.
+	for (int i = numFacetHalfEdges; i < (signed)this->halfEdgeArray->size(); i++)
+	{
+		int j = borderHalfEdgeArray[(*this->halfEdgeArray)[(*this->halfEdgeArray)[i].twin].vertex];
+		if (j < 0)
+		{
+			this->Clear();
+			return false;
+		}
+
+		this->LinkHalfEdges(i, j);
+	}
+
+	// A vertex where two fans of facets meet at just a point has half-edges that can't all be reached by going around it.
+	std::vector<int> outgoingCountArray(this->vertexArray->size(), 0);
+	for (int i = 0; i < (signed)this->halfEdgeArray->size(); i++)
+	{
+		int j = (*this->halfEdgeArray)[i].vertex;
+		outgoingCountArray[j]++;
+		if ((*this->vertexArray)[j].halfEdge < 0)
+			(*this->vertexArray)[j].halfEdge = i;
+	}
+
+	for (int i = 0; i < (signed)this->vertexArray->size(); i++)
+	{
+		if (this->CountVertexValence(i) != outgoingCountArray[i])
+		{
+			this->Clear();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void HalfEdgeMesh::ToConvexPolygonMesh(ConvexPolygonMesh& mesh) const
+{
+	mesh.Clear();
+
+	std::vector<int> indexArray(this->vertexArray->size(), -1);
+	for (int i = 0; i < (signed)this->vertexArray->size(); i++)
+	{
+		const Vertex& vertex = (*this->vertexArray)[i];
+		if (!vertex.deleted)
+		{
+			indexArray[i] = (int)mesh.vertexArray->size();
+			mesh.vertexArray->push_back(vertex.point);
+		}
+	}
+
+	for (int i = 0; i < (signed)this->facetArray->size(); i++)
+	{
+		if ((*this->facetArray)[i].deleted)
+			continue;
+
+		ConvexPolygonMesh::Facet facet;
+		this->ForFacetHalfEdges(i, [this, &facet, &indexArray](int j) -> bool
+			{
+				facet.vertexArray->push_back(indexArray[(*this->halfEdgeArray)[j].vertex]);
+				return true;
+			});
+
+		mesh.facetArray->push_back(facet);
+	}
+}
+
+int HalfEdgeMesh::GetDestination(int halfEdge) const
+{
+	return (*this->halfEdgeArray)[(*this->halfEdgeArray)[halfEdge].next].vertex;
+}
+
+int HalfEdgeMesh::FindHalfEdge(int vertexA, int vertexB) const
+{
+	int foundHalfEdge = -1;
+
+	this->ForVertexHalfEdges(vertexA, [this, vertexB, &foundHalfEdge](int i) -> bool
+		{
+			if (this->GetDestination(i) != vertexB)
+				return true;
+
+			foundHalfEdge = i;
+			return false;
+		});
+
+	return foundHalfEdge;
+}
+
+bool HalfEdgeMesh::IsBoundaryVertex(int vertex) const
+{
+	bool boundary = false;
+
+	this->ForVertexHalfEdges(vertex, [this, &boundary](int i) -> bool
+		{
+			boundary = ((*this->halfEdgeArray)[i].facet < 0);
+			return !boundary;
+		});
+
+	return boundary;
+}
+
+bool HalfEdgeMesh::IsBoundaryEdge(int halfEdge) const
+{
+	const HalfEdge& halfEdgeA = (*this->halfEdgeArray)[halfEdge];
+	const HalfEdge& halfEdgeB = (*this->halfEdgeArray)[halfEdgeA.twin];
+
+	return halfEdgeA.facet < 0 || halfEdgeB.facet < 0;
+}
+
+int HalfEdgeMesh::CountVertexValence(int vertex) const
+{
+	int count = 0;
+
+	this->ForVertexHalfEdges(vertex, [&count](int) -> bool
+		{
+			count++;
+			return true;
+		});
+
+	return count;
+}
+
+int HalfEdgeMesh::CountFacetSides(int facet) const
+{
+	int count = 0;
+
+	this->ForFacetHalfEdges(facet, [&count](int) -> bool
+		{
+			count++;
+			return true;
+		});
+
+	return count;
+}
+
+// The half-edge before one starting at the vertex ends there, so its twin is the next one starting there.
+void HalfEdgeMesh::ForVertexHalfEdges(int vertex, std::function<bool(int)> halfEdgeFunc) const
+{
+	int firstHalfEdge = (*this->vertexArray)[vertex].halfEdge;
+	if (firstHalfEdge < 0)
+		return;
+
+	int i = firstHalfEdge;
+	do
+	{
+		if (!halfEdgeFunc(i))
+			break;
+
+		i = (*this->halfEdgeArray)[(*this->halfEdgeArray)[i].prev].twin;
+	} while (i != firstHalfEdge);
+}
+
+void HalfEdgeMesh::ForFacetHalfEdges(int facet, std::function<bool(int)> halfEdgeFunc) const
+{
+	int firstHalfEdge = (*this->facetArray)[facet].halfEdge;
+
+	int i = firstHalfEdge;
+	do
+	{
+		if (!halfEdgeFunc(i))
+			break;
+
+		i = (*this->halfEdgeArray)[i].next;
+	} while (i != firstHalfEdge);
+}
+
+// Triangles ABC and BAD, on either side of the edge from A to B, become ADC and DBC.
+bool HalfEdgeMesh::FlipEdge(int halfEdge)
+{
+	if (!this->IsUsableHalfEdge(halfEdge))
+		return false;
+
+	int h = halfEdge;
+	int t = (*this->halfEdgeArray)[h].twin;
+
+	int facetA = (*this->halfEdgeArray)[h].facet;
+	int facetB = (*this->halfEdgeArray)[t].facet;
+
+	if (facetA < 0 || facetB < 0 || this->CountFacetSides(facetA) != 3 || this->CountFacetSides(facetB) != 3)
+		return false;
+
+	int h1 = (*this->halfEdgeArray)[h].next;
+	int h2 = (*this->halfEdgeArray)[h].prev;
+	int t1 = (*this->halfEdgeArray)[t].next;
+	int t2 = (*this->halfEdgeArray)[t].prev;
+
+	int vertexA = (*this->halfEdgeArray)[h].vertex;
+	int vertexB = (*this->halfEdgeArray)[t].vertex;
+	int vertexC = (*this->halfEdgeArray)[h2].vertex;
+	int vertexD = (*this->halfEdgeArray)[t2].vertex;
+
+	if (vertexC == vertexD || this->FindHalfEdge(vertexC, vertexD) >= 0)
+		return false;
+
+	(*this->halfEdgeArray)[h].vertex = vertexD;
+	(*this->halfEdgeArray)[t].vertex = vertexC;
+
+	this->LinkHalfEdges(t1, h);
+	this->LinkHalfEdges(h, h2);
+	this->LinkHalfEdges(h2, t1);
+	this->LinkHalfEdges(t2, h1);
+	this->LinkHalfEdges(h1, t);
+	this->LinkHalfEdges(t, t2);
+
+	(*this->halfEdgeArray)[t1].facet = facetA;
+	(*this->halfEdgeArray)[h1].facet = facetB;
+	(*this->facetArray)[facetA].halfEdge = h;
+	(*this->facetArray)[facetB].halfEdge = t;
+
+	if ((*this->vertexArray)[vertexA].halfEdge == h)
+		(*this->vertexArray)[vertexA].halfEdge = t1;
+
+	if ((*this->vertexArray)[vertexB].halfEdge == t)
+		(*this->vertexArray)[vertexB].halfEdge = h1;
+
+	return true;
+}
+
+int HalfEdgeMesh::SplitEdge(int halfEdge, const Vector3& point)
+{
+	if (!this->IsUsableHalfEdge(halfEdge))
+		return -1;
+
+	int h = halfEdge;
+	int t = (*this->halfEdgeArray)[h].twin;
+
+	int vertex = this->NewVertex(point);
+	int h2 = this->NewHalfEdge();
+	int t2 = this->NewHalfEdge();
+
+	HalfEdge& halfEdgeA = (*this->halfEdgeArray)[h2];
+	halfEdgeA.vertex = vertex;
+	halfEdgeA.facet = (*this->halfEdgeArray)[h].facet;
+	halfEdgeA.twin = t;
+
+	HalfEdge& halfEdgeB = (*this->halfEdgeArray)[t2];
+	halfEdgeB.vertex = vertex;
+	halfEdgeB.facet = (*this->halfEdgeArray)[t].facet;
+	halfEdgeB.twin = h;
+
+	this->LinkHalfEdges(h2, (*this->halfEdgeArray)[h].next);
+	this->LinkHalfEdges(h, h2);
+	this->LinkHalfEdges(t2, (*this->halfEdgeArray)[t].next);
+	this->LinkHalfEdges(t, t2);
+
+	(*this->halfEdgeArray)[h].twin = t2;
+	(*this->halfEdgeArray)[t].twin = h2;
+	(*this->vertexArray)[vertex].halfEdge = h2;
+
+	return vertex;
+}
+
+int HalfEdgeMesh::SplitFacet(int halfEdgeA, int halfEdgeB)
+{
+	if (!this->IsUsableHalfEdge(halfEdgeA) || !this->IsUsableHalfEdge(halfEdgeB))
+		return -1;
+
+	int facet = (*this->halfEdgeArray)[halfEdgeA].facet;
+	if (facet < 0 || halfEdgeA == halfEdgeB || (*this->halfEdgeArray)[halfEdgeB].facet != facet)
+		return -1;
+
+	if ((*this->halfEdgeArray)[halfEdgeA].next == halfEdgeB || (*this->halfEdgeArray)[halfEdgeB].next == halfEdgeA)
+		return -1;
+
+	int vertexA = (*this->halfEdgeArray)[halfEdgeA].vertex;
+	int vertexB = (*this->halfEdgeArray)[halfEdgeB].vertex;
+	if (vertexA == vertexB || this->FindHalfEdge(vertexA, vertexB) >= 0)
+		return -1;
+
+	int prevA = (*this->halfEdgeArray)[halfEdgeA].prev;
+	int prevB = (*this->halfEdgeArray)[halfEdgeB].prev;
+
+	int newFacet = this->NewFacet();
+	int x = this->NewHalfEdge();
+	int y = this->NewHalfEdge();
+
+	HalfEdge& halfEdgeX = (*this->halfEdgeArray)[x];
+	halfEdgeX.vertex = vertexA;
+	halfEdgeX.twin = y;
+	halfEdgeX.facet = newFacet;
+
+	HalfEdge& halfEdgeY = (*this->halfEdgeArray)[y];
+	halfEdgeY.vertex = vertexB;
+	halfEdgeY.twin = x;
+	halfEdgeY.facet = facet;
+
+	this->LinkHalfEdges(prevB, y);
+	this->LinkHalfEdges(y, halfEdgeA);
+	this->LinkHalfEdges(prevA, x);
+	this->LinkHalfEdges(x, halfEdgeB);
+
+	(*this->facetArray)[facet].halfEdge = halfEdgeA;
+	(*this->facetArray)[newFacet].halfEdge = halfEdgeB;
+
+	this->ForFacetHalfEdges(newFacet, [this, newFacet](int i) -> bool
+		{
+			(*this->halfEdgeArray)[i].facet = newFacet;
+			return true;
+		});
+
+	return newFacet;
+}
+
+// The ends of the edge may have no neighbors in common other than the far corners of the triangles on the edge,
+// since any other would end up joined to the merged vertex by two edges.  Each of those triangles goes away, and the
+// two edges left of it are glued into one.
+bool HalfEdgeMesh::CollapseEdge(int halfEdge, const Vector3& point)
+{
+	if (!this->IsUsableHalfEdge(halfEdge))
+		return false;
+
+	int h = halfEdge;
+	int t = (*this->halfEdgeArray)[h].twin;
+
+	int vertexA = (*this->halfEdgeArray)[h].vertex;
+	int vertexB = (*this->halfEdgeArray)[t].vertex;
+
+	if ((*this->halfEdgeArray)[h].facet == (*this->halfEdgeArray)[t].facet)
+		return false;
+
+	if (!this->IsBoundaryEdge(h) && this->IsBoundaryVertex(vertexA) && this->IsBoundaryVertex(vertexB))
+		return false;
+
+	int sideArray[2] = { h, t };
+	int numSideArray[2];
+	int numTriangles = 0;
+
+	for (int i = 0; i < 2; i++)
+	{
+		const HalfEdge& side = (*this->halfEdgeArray)[sideArray[i]];
+
+		numSideArray[i] = 1;
+		for (int j = side.next; j != sideArray[i]; j = (*this->halfEdgeArray)[j].next)
+			numSideArray[i]++;
+
+		if (numSideArray[i] == 3)
+		{
+			if (side.facet < 0)
+				return false;
+
+			numTriangles++;
+		}
+	}
+
+	std::vector<int> outgoingArrayA, outgoingArrayB;
+	std::set<int> neighborSetA;
+	int numCommon = 0;
+
+	this->ForVertexHalfEdges(vertexA, [this, &outgoingArrayA, &neighborSetA](int i) -> bool
+		{
+			outgoingArrayA.push_back(i);
+			neighborSetA.insert(this->GetDestination(i));
+			return true;
+		});
+
+	this->ForVertexHalfEdges(vertexB, [this, &outgoingArrayB, &neighborSetA, &numCommon](int i) -> bool
+		{
+			outgoingArrayB.push_back(i);
+			if (neighborSetA.find(this->GetDestination(i)) != neighborSetA.end())
+				numCommon++;
+			return true;
+		});
+
+	if (numCommon != numTriangles)
+		return false;
+
+	int valence = (int)outgoingArrayA.size() + (int)outgoingArrayB.size() - 2 - numCommon;
+	if (valence < (this->IsBoundaryEdge(h) ? 2 : 3))
+		return false;
+
+	for (int i = 0; i < 2; i++)
+	{
+		int s = sideArray[i];
+		int next = (*this->halfEdgeArray)[s].next;
+		int prev = (*this->halfEdgeArray)[s].prev;
+		int facet = (*this->halfEdgeArray)[s].facet;
+
+		if (numSideArray[i] == 3)
+		{
+			int twinNext = (*this->halfEdgeArray)[next].twin;
+			int twinPrev = (*this->halfEdgeArray)[prev].twin;
+
+			(*this->halfEdgeArray)[twinNext].twin = twinPrev;
+			(*this->halfEdgeArray)[twinPrev].twin = twinNext;
+
+			int vertexC = (*this->halfEdgeArray)[prev].vertex;
+			if ((*this->vertexArray)[vertexC].halfEdge == prev)
+				(*this->vertexArray)[vertexC].halfEdge = twinNext;
+
+			this->DeleteHalfEdge(next);
+			this->DeleteHalfEdge(prev);
+			this->DeleteFacet(facet);
+		}
+		else
+		{
+			this->LinkHalfEdges(prev, next);
+			if (facet >= 0 && (*this->facetArray)[facet].halfEdge == s)
+				(*this->facetArray)[facet].halfEdge = next;
+		}
+	}
+
+	this->DeleteHalfEdge(h);
+	this->DeleteHalfEdge(t);
+
+	for (int i : outgoingArrayB)
+		if (!(*this->halfEdgeArray)[i].deleted)
+			(*this->halfEdgeArray)[i].vertex = vertexA;
+
+	Vertex& vertex = (*this->vertexArray)[vertexA];
+	vertex.point = point;
+	vertex.halfEdge = -1;
+
+	for (const std::vector<int>* outgoingArray : { &outgoingArrayA, &outgoingArrayB })
+		for (int i : *outgoingArray)
+			if (vertex.halfEdge < 0 && !(*this->halfEdgeArray)[i].deleted)
+				vertex.halfEdge = i;
+
+	this->DeleteVertex(vertexB);
+	return true;
+}
+
+// If either end of the edge had no other edges than those of the two facets, it would be left sticking into the merged
+// facet, so that's refused, as is merging a facet with itself, or with one it shares another edge with.
+bool HalfEdgeMesh::MergeFacets(int halfEdge)
+{
+	if (!this->IsUsableHalfEdge(halfEdge))
+		return false;
+
+	int h = halfEdge;
+	int t = (*this->halfEdgeArray)[h].twin;
+
+	int facetA = (*this->halfEdgeArray)[h].facet;
+	int facetB = (*this->halfEdgeArray)[t].facet;
+
+	if (facetA < 0 || facetB < 0 || facetA == facetB)
+		return false;
+
+	int vertexA = (*this->halfEdgeArray)[h].vertex;
+	int vertexB = (*this->halfEdgeArray)[t].vertex;
+
+	if (this->CountVertexValence(vertexA) < 3 || this->CountVertexValence(vertexB) < 3)
+		return false;
+
+	bool sharesOtherEdge = false;
+	this->ForFacetHalfEdges(facetB, [this, t, facetA, &sharesOtherEdge](int i) -> bool
+		{
+			sharesOtherEdge = (i != t && (*this->halfEdgeArray)[(*this->halfEdgeArray)[i].twin].facet == facetA);
+			return !sharesOtherEdge;
+		});
+
+	if (sharesOtherEdge)
+		return false;
+
+	this->ForFacetHalfEdges(facetB, [this, facetA](int i) -> bool
+		{
+			(*this->halfEdgeArray)[i].facet = facetA;
+			return true;
+		});
+
+	int hNext = (*this->halfEdgeArray)[h].next;
+	int hPrev = (*this->halfEdgeArray)[h].prev;
+	int tNext = (*this->halfEdgeArray)[t].next;
+	int tPrev = (*this->halfEdgeArray)[t].prev;
+
+	this->LinkHalfEdges(hPrev, tNext);
+	this->LinkHalfEdges(tPrev, hNext);
+
+	(*this->facetArray)[facetA].halfEdge = hNext;
+
+	if ((*this->vertexArray)[vertexA].halfEdge == h)
+		(*this->vertexArray)[vertexA].halfEdge = tNext;
+
+	if ((*this->vertexArray)[vertexB].halfEdge == t)
+		(*this->vertexArray)[vertexB].halfEdge = hNext;
+
+	this->DeleteHalfEdge(h);
+	this->DeleteHalfEdge(t);
+	this->DeleteFacet(facetB);
+
+	return true;
+}
+
+bool HalfEdgeMesh::IsValid() const
+{
+	int numHalfEdges = (int)this->halfEdgeArray->size();
+
+	for (int i = 0; i < numHalfEdges; i++)
+	{
+		const HalfEdge& halfEdge = (*this->halfEdgeArray)[i];
+		if (halfEdge.deleted)
+			continue;
+
+		if (halfEdge.twin < 0 || halfEdge.twin >= numHalfEdges || halfEdge.next < 0 || halfEdge.next >= numHalfEdges || halfEdge.prev < 0 || halfEdge.prev >= numHalfEdges)
+			return false;
+
+		const HalfEdge& twin = (*this->halfEdgeArray)[halfEdge.twin];
+		const HalfEdge& next = (*this->halfEdgeArray)[halfEdge.next];
+
+		if (twin.deleted || next.deleted || (*this->halfEdgeArray)[halfEdge.prev].deleted)
+			return false;
+
+		if (twin.twin != i || next.prev != i || (*this->halfEdgeArray)[halfEdge.prev].next != i)
+			return false;
+
+		if (next.facet != halfEdge.facet || twin.vertex != next.vertex || halfEdge.twin == i)
+			return false;
+
+		if ((*this->vertexArray)[halfEdge.vertex].deleted)
+			return false;
+
+		if (halfEdge.facet >= 0 && (*this->facetArray)[halfEdge.facet].deleted)
+			return false;
+	}
+
+	for (int i = 0; i < (signed)this->facetArray->size(); i++)
+	{
+		const Facet& facet = (*this->facetArray)[i];
+		if (!facet.deleted && (*this->halfEdgeArray)[facet.halfEdge].facet != i)
+			return false;
+	}
+
+	for (int i = 0; i < (signed)this->vertexArray->size(); i++)
+	{
+		const Vertex& vertex = (*this->vertexArray)[i];
+		if (!vertex.deleted && vertex.halfEdge >= 0 && (*this->halfEdgeArray)[vertex.halfEdge].vertex != i)
+			return false;
+	}
+
+	return true;
+}
+
+// The edit operations check what they're given with this, so that a bad half-edge is refused rather than followed.
+bool HalfEdgeMesh::IsUsableHalfEdge(int halfEdge) const
+{
+	int numHalfEdges = (int)this->halfEdgeArray->size();
+	if (halfEdge < 0 || halfEdge >= numHalfEdges || (*this->halfEdgeArray)[halfEdge].deleted)
+		return false;
+
+	int twin = (*this->halfEdgeArray)[halfEdge].twin;
+	return 0 <= twin && twin < numHalfEdges && !(*this->halfEdgeArray)[twin].deleted;
+}
+
+int HalfEdgeMesh::NewVertex(const Vector3& point)
+{
+	int i = 0;
+
+	if (this->freeVertexArray->size() > 0)
+	{
+		i = this->freeVertexArray->back();
+		this->freeVertexArray->pop_back();
+	}
+	else
+	{
+		i = (int)this->vertexArray->size();
+		this->vertexArray->push_back(Vertex{});
+	}
+
+	(*this->vertexArray)[i] = Vertex{ point, -1, false };
+	return i;
+}
+
+int HalfEdgeMesh::NewHalfEdge()
+{
+	int i = 0;
+
+	if (this->freeHalfEdgeArray->size() > 0)
+	{
+		i = this->freeHalfEdgeArray->back();
+		this->freeHalfEdgeArray->pop_back();
+	}
+	else
+	{
+		i = (int)this->halfEdgeArray->size();
+		this->halfEdgeArray->push_back(HalfEdge{});
+	}
+
+	(*this->halfEdgeArray)[i] = HalfEdge{ -1, -1, -1, -1, -1, false };
+	return i;
+}
+
+int HalfEdgeMesh::NewFacet()
+{
+	int i = 0;
+
+	if (this->freeFacetArray->size() > 0)
+	{
+		i = this->freeFacetArray->back();
+		this->freeFacetArray->pop_back();
+	}
+	else
+	{
+		i = (int)this->facetArray->size();
+		this->facetArray->push_back(Facet{});
+	}
+
+	(*this->facetArray)[i] = Facet{ -1, false };
+	return i;
+}
+
+void HalfEdgeMesh::DeleteVertex(int vertex)
+{
+	(*this->vertexArray)[vertex].deleted = true;
+	this->freeVertexArray->push_back(vertex);
+}
+
+void HalfEdgeMesh::DeleteHalfEdge(int halfEdge)
+{
+	(*this->halfEdgeArray)[halfEdge].deleted = true;
+	this->freeHalfEdgeArray->push_back(halfEdge);
+}
+
+void HalfEdgeMesh::DeleteFacet(int facet)
+{
+	(*this->facetArray)[facet].deleted = true;
+	this->freeFacetArray->push_back(facet);
+}
+
+void HalfEdgeMesh::LinkHalfEdges(int halfEdgeA, int halfEdgeB)
+{
+	(*this->halfEdgeArray)[halfEdgeA].next = halfEdgeB;
+	(*this->halfEdgeArray)[halfEdgeB].prev = halfEdgeA;
+}
\ No newline at end of file
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "Common.h"
+#include "Math/Vector3.h"
+
+namespace MeshNinja
+{
+	class ConvexPolygonMesh;
+
+	// This is another way of storing a polygon mesh, where the adjacency of everything is written down, so that local
+	// edits can find what they need by following links rather than searching the whole mesh.  Every edge is made of
+	// two half-edges, one going each way, and each half-edge knows its twin, the next and previous half-edges around
+	// its facet, the facet itself and the vertex it starts at.  Each vertex knows one of the half-edges starting at it,
+	// and each facet one of those around it.
+	//
+	// The holes of the mesh are gone around by half-edges of their own, which have no facet, so that every half-edge
+	// has a twin and the half-edges around any vertex can be gone through the same way, border or not.  This does
+	// mean that the mesh has to be a manifold, possibly with borders, with its facets all wound the same way.
+	//
+	// Everything is kept in arrays.  Deleted elements are just marked as such and put on a free-list, to be reused by
+	// the next element made of the same kind, so the indices of everything else stay the same through any edit.
+	class MESH_NINJA_API HalfEdgeMesh
+	{
+	public:
+		HalfEdgeMesh();
+		virtual ~HalfEdgeMesh();
+
+		struct Vertex
+		{
+			Vector3 point;
+			int halfEdge;		// This is -1 if the vertex isn't used by any facet.
+			bool deleted;
+		};
+
+		struct HalfEdge
+		{
+			int vertex;
+			int twin;
+			int next;
+			int prev;
+			int facet;			// This is -1 if the half-edge goes around a hole.
+			bool deleted;
+		};
+
+		struct Facet
+		{
+			int halfEdge;
+			bool deleted;
+		};
+
+		void Clear();
+
+		// These take time in proportion to the size of the mesh.  The first fails if the given mesh isn't a manifold with
+		// its facets wound the same way.  The second leaves out whatever has been deleted, so the indices may change.
+		bool FromConvexPolygonMesh(const ConvexPolygonMesh& mesh);
+		void ToConvexPolygonMesh(ConvexPolygonMesh& mesh) const;
+
+		int GetDestination(int halfEdge) const;
+		int FindHalfEdge(int vertexA, int vertexB) const;
+		bool IsBoundaryVertex(int vertex) const;
+		bool IsBoundaryEdge(int halfEdge) const;
+		int CountVertexValence(int vertex) const;
+		int CountFacetSides(int facet) const;
+
+		// These go through the half-edges starting at the given vertex, and around the given facet, for as long as the
+		// given function returns true.
+		void ForVertexHalfEdges(int vertex, std::function<bool(int)> halfEdgeFunc) const;
+		void ForFacetHalfEdges(int facet, std::function<bool(int)> halfEdgeFunc) const;
+
+		// The edits below all refuse a half-edge that's out of range or deleted, giving back false or -1.
+		// The edge between two triangles is turned to join the other two corners of the quadrilateral they make.
+		bool FlipEdge(int halfEdge);
+
+		// A new vertex at the given point is put into the edge, and so into the facets on either side, which
+		// gives back the new vertex, or -1 if the edge is no good.
+		int SplitEdge(int halfEdge, const Vector3& point);
+
+		// The facet is split in two by a new edge from the start of the first given half-edge to the start of the
+		// second, both of which must be around the facet without being next to one another.  This gives back the
+		// new facet, which is the one containing the second half-edge, or -1 if the split can't be done.
+		int SplitFacet(int halfEdgeA, int halfEdgeB);
+
+		// The vertex at the end of the half-edge is merged into the one at its start, which moves to the given point.
+		// Triangles on the edge go away with it.  Collapses that would pinch the mesh, or close a hole, are refused.
+		bool CollapseEdge(int halfEdge, const Vector3& point);
+
+		// The two facets on either side of the edge become one, the first of them, by taking the edge away.
+		// Nothing is done to see that the result is convex.
+		bool MergeFacets(int halfEdge);
+
+		// This checks that the links all agree with one another, which is mostly useful for debugging.
+		bool IsValid() const;
+
+		std::vector<Vertex>* vertexArray;
+		std::vector<HalfEdge>* halfEdgeArray;
+		std::vector<Facet>* facetArray;
+
+	protected:
+
+		bool IsUsableHalfEdge(int halfEdge) const;
+		int NewVertex(const Vector3& point);
+		int NewHalfEdge();
+		int NewFacet();
+		void DeleteVertex(int vertex);
+		void DeleteHalfEdge(int halfEdge);
+		void DeleteFacet(int facet);
+		void LinkHalfEdges(int halfEdgeA, int halfEdgeB);
+
+		std::vector<int>* freeVertexArray;
+		std::vector<int>* freeHalfEdgeArray;
+		std::vector<int>* freeFacetArray;
+	};
+}
\ No newline at end of file
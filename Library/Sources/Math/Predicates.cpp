@@ -0,0 +1,318 @@
+#include "Predicates.h"
+#include "Vector3.h"
+
+using namespace MeshNinja;
+
+// Half the distance from 1.0 to the next larger double; the relative error of a single rounding.
+#define MESH_NINJA_ROUNDOFF		(DBL_EPSILON / 2.0)
+
+static thread_local Predicates::Mode threadMode = Predicates::Mode::EPSILON;
+
+//----------------------------------- Expansion arithmetic -----------------------------------
+
+// An expansion is a sum of doubles, ordered by increasing magnitude, no two of which overlap in the bits
+// they occupy.  It can represent the exact result of any number of additions and multiplications of doubles,
+// and its sign is always the sign of its last (largest) component.  Zero components are never stored.
+
+typedef std::vector<double> Expansion;
+
+static inline void TwoSum(double a, double b, double& x, double& y)
+{
+	x = a + b;
+	double bVirtual = x - a;
+	double aVirtual = x - bVirtual;
+	y = (a - aVirtual) + (b - bVirtual);
+}
+
+static inline void FastTwoSum(double a, double b, double& x, double& y)
+{
+	x = a + b;
+	y = b - (x - a);
+}
+
+static inline void TwoProduct(double a, double b, double& x, double& y)
+{
+	x = a * b;
+	y = ::fma(a, b, -x);
+}
+
+static Expansion MakeExpansion(double x, double y)
+{
+	Expansion e;
+
+	if (y != 0.0)
+		e.push_back(y);
+
+	if (x != 0.0)
+		e.push_back(x);
+
+	return e;
+}
+
+static Expansion Difference(double a, double b)
+{
+	double x = a - b;
+	double bVirtual = a - x;
+	double aVirtual = x + bVirtual;
+	double y = (a - aVirtual) + (bVirtual - b);
+	return MakeExpansion(x, y);
+}
+
+static Expansion Grow(const Expansion& e, double b)
+{
+	Expansion h;
+	double Q = b;
+
+	for (double component : e)
+	{
+		double sum = 0.0, error = 0.0;
+		TwoSum(Q, component, sum, error);
+		if (error != 0.0)
+			h.push_back(error);
+		Q = sum;
+	}
+
+	if (Q != 0.0)
+		h.push_back(Q);
+
+	return h;
+}
+
+static Expansion Sum(const Expansion& e, const Expansion& f)
+{
+	Expansion h = e;
+
+	for (double component : f)
+		h = Grow(h, component);
+
+	return h;
+}
+
+static Expansion Scale(const Expansion& e, double b)
+{
+	Expansion h;
+	if (e.size() == 0 || b == 0.0)
+		return h;
+
+	double Q = 0.0, error = 0.0;
+	TwoProduct(e[0], b, Q, error);
+	if (error != 0.0)
+		h.push_back(error);
+
+	for (int i = 1; i < (signed)e.size(); i++)
+	{
+		double productHigh = 0.0, productLow = 0.0, sum = 0.0;
+		TwoProduct(e[i], b, productHigh, productLow);
+		TwoSum(Q, productLow, sum, error);
+		if (error != 0.0)
+			h.push_back(error);
+		FastTwoSum(productHigh, sum, Q, error);
+		if (error != 0.0)
+			h.push_back(error);
+	}
+
+	if (Q != 0.0)
+		h.push_back(Q);
+
+	return h;
+}
+
+static Expansion Product(const Expansion& e, const Expansion& f)
+{
+	Expansion h;
+
+	for (double component : f)
+		h = Sum(h, Scale(e, component));
+
+	return h;
+}
+
+static Expansion Negate(const Expansion& e)
+{
+	Expansion h = e;
+
+	for (double& component : h)
+		component = -component;
+
+	return h;
+}
+
+static double Estimate(const Expansion& e)
+{
+	// The largest component alone has the right sign, but the sum is a better approximation of the value.
+	double sum = 0.0;
+
+	for (double component : e)
+		sum += component;
+
+	if (e.size() > 0 && MESH_NINJA_SIGN(sum) != MESH_NINJA_SIGN(e.back()))
+		return e.back();
+
+	return sum;
+}
+
+//----------------------------------- Predicates -----------------------------------
+
+static inline double Component(const Vector3& vector, int i)
+{
+	switch (i)
+	{
+		case 0: return vector.x;
+		case 1: return vector.y;
+	}
+
+	return vector.z;
+}
+
+/*static*/ void Predicates::SetMode(Mode mode)
+{
+	threadMode = mode;
+}
+
+/*static*/ Predicates::Mode Predicates::GetMode()
+{
+	return threadMode;
+}
+
+/*static*/ int Predicates::DominantAxis(const Vector3& normal)
+{
+	double x = fabs(normal.x);
+	double y = fabs(normal.y);
+	double z = fabs(normal.z);
+
+	if (x >= y && x >= z)
+		return 0;
+
+	if (y >= z)
+		return 1;
+
+	return 2;
+}
+
+/*static*/ double Predicates::Orient2D(double ax, double ay, double bx, double by, double cx, double cy)
+{
+	double detLeft = (bx - ax) * (cy - ay);
+	double detRight = (by - ay) * (cx - ax);
+	double det = detLeft - detRight;
+
+	double errorBound = (3.0 + 16.0 * MESH_NINJA_ROUNDOFF) * MESH_NINJA_ROUNDOFF * (fabs(detLeft) + fabs(detRight));
+	if (fabs(det) > errorBound)
+		return det;
+
+	return Orient2DExact(ax, ay, bx, by, cx, cy);
+}
+
+/*static*/ double Predicates::Orient2D(const Vector3& a, const Vector3& b, const Vector3& c, const Vector3& normal)
+{
+	int k = DominantAxis(normal);
+	int i = (k + 1) % 3;
+	int j = (k + 2) % 3;
+
+	double det = Orient2D(Component(a, i), Component(a, j), Component(b, i), Component(b, j), Component(c, i), Component(c, j));
+	return (Component(normal, k) < 0.0) ? -det : det;
+}
+
+/*static*/ double Predicates::Orient2DExact(double ax, double ay, double bx, double by, double cx, double cy)
+{
+	Expansion detLeft = Product(Difference(bx, ax), Difference(cy, ay));
+	Expansion detRight = Product(Difference(by, ay), Difference(cx, ax));
+	return Estimate(Sum(detLeft, Negate(detRight)));
+}
+
+/*static*/ double Predicates::Orient3D(const Vector3& a, const Vector3& b, const Vector3& c, const Vector3& d)
+{
+	double bx = b.x - a.x, by = b.y - a.y, bz = b.z - a.z;
+	double cx = c.x - a.x, cy = c.y - a.y, cz = c.z - a.z;
+	double dx = d.x - a.x, dy = d.y - a.y, dz = d.z - a.z;
+
+	double cydz = cy * dz, czdy = cz * dy;
+	double czdx = cz * dx, cxdz = cx * dz;
+	double cxdy = cx * dy, cydx = cy * dx;
+
+	double det = bx * (cydz - czdy) + by * (czdx - cxdz) + bz * (cxdy - cydx);
+
+	double permanent =
+		fabs(bx) * (fabs(cydz) + fabs(czdy)) +
+		fabs(by) * (fabs(czdx) + fabs(cxdz)) +
+		fabs(bz) * (fabs(cxdy) + fabs(cydx));
+
+	double errorBound = (7.0 + 56.0 * MESH_NINJA_ROUNDOFF) * MESH_NINJA_ROUNDOFF * permanent;
+	if (fabs(det) > errorBound)
+		return det;
+
+	return Orient3DExact(a, b, c, d);
+}
+
+/*static*/ double Predicates::Orient3DExact(const Vector3& a, const Vector3& b, const Vector3& c, const Vector3& d)
+{
+	Expansion bx = Difference(b.x, a.x), by = Difference(b.y, a.y), bz = Difference(b.z, a.z);
+	Expansion cx = Difference(c.x, a.x), cy = Difference(c.y, a.y), cz = Difference(c.z, a.z);
+	Expansion dx = Difference(d.x, a.x), dy = Difference(d.y, a.y), dz = Difference(d.z, a.z);
+
+	Expansion minorX = Sum(Product(cy, dz), Negate(Product(cz, dy)));
+	Expansion minorY = Sum(Product(cz, dx), Negate(Product(cx, dz)));
+	Expansion minorZ = Sum(Product(cx, dy), Negate(Product(cy, dx)));
+
+	Expansion det = Sum(Sum(Product(bx, minorX), Product(by, minorY)), Product(bz, minorZ));
+	return Estimate(det);
+}
+
+/*static*/ double Predicates::PlaneSide(const Vector3& normal, double D, const Vector3& point, double offset /*= 0.0*/)
+{
+	double x = normal.x * point.x;
+	double y = normal.y * point.y;
+	double z = normal.z * point.z;
+
+	double value = x + y + z - D - offset;
+
+	// Three products and four sums each contribute at most one rounding.
+	double errorBound = 8.0 * MESH_NINJA_ROUNDOFF * (fabs(x) + fabs(y) + fabs(z) + fabs(D) + fabs(offset));
+	if (fabs(value) > errorBound)
+		return value;
+
+	return PlaneSideExact(normal, D, point, offset);
+}
+
+/*static*/ double Predicates::PlaneSideExact(const Vector3& normal, double D, const Vector3& point, double offset)
+{
+	double high = 0.0, low = 0.0;
+	Expansion value;
+
+	TwoProduct(normal.x, point.x, high, low);
+	value = Sum(value, MakeExpansion(high, low));
+
+	TwoProduct(normal.y, point.y, high, low);
+	value = Sum(value, MakeExpansion(high, low));
+
+	TwoProduct(normal.z, point.z, high, low);
+	value = Sum(value, MakeExpansion(high, low));
+
+	value = Grow(value, -D);
+	value = Grow(value, -offset);
+
+	return Estimate(value);
+}
+
+/*static*/ int Predicates::SegmentPlaneSide(const Vector3& normal, double D, const Vector3& pointA, const Vector3& pointB, double halfWidth /*= 0.0*/)
+{
+	if (PlaneSide(normal, D, pointA, halfWidth) > 0.0 && PlaneSide(normal, D, pointB, halfWidth) > 0.0)
+		return 1;
+
+	if (PlaneSide(normal, D, pointA, -halfWidth) < 0.0 && PlaneSide(normal, D, pointB, -halfWidth) < 0.0)
+		return -1;
+
+	return 0;
+}
+
+//----------------------------------- Predicates::ModeScope -----------------------------------
+
+Predicates::ModeScope::ModeScope(Mode mode)
+{
+	this->previousMode = Predicates::GetMode();
+	Predicates::SetMode(mode);
+}
+
+/*virtual*/ Predicates::ModeScope::~ModeScope()
+{
+	Predicates::SetMode(this->previousMode);
+}
\ No newline at end of file
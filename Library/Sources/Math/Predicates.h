@@ -0,0 +1,67 @@
+#pragma once
+
+#include "../Common.h"
+
+namespace MeshNinja
+{
+	class Vector3;
+
+	// These are geometric predicates whose sign is always correct.  Each is first evaluated in ordinary
+	// floating-point along with a bound on its rounding error, and only if that can't settle the sign do
+	// we recompute it exactly using Shewchuk's expansion arithmetic.  The value returned is approximate,
+	// but its sign (including zero) is exact.  See "Adaptive Precision Floating-Point Arithmetic and Fast
+	// Robust Geometric Predicates" by Jonathan Shewchuk.
+	//
+	// Whether the rest of the library uses these predicates or its usual epsilon comparisons is decided
+	// by the mode set for the calling thread.  This is so that an algorithm can opt in to them without
+	// having to thread a new parameter through every call it makes.
+	class MESH_NINJA_API Predicates
+	{
+	public:
+		enum class Mode
+		{
+			EPSILON,
+			ADAPTIVE
+		};
+
+		static void SetMode(Mode mode);
+		static Mode GetMode();
+
+		// Sets the mode for the calling thread for the lifetime of this object.
+		class MESH_NINJA_API ModeScope
+		{
+		public:
+			ModeScope(Mode mode);
+			virtual ~ModeScope();
+
+		private:
+			Mode previousMode;
+		};
+
+		// Positive if point c is to the left of the directed line from a to b.
+		static double Orient2D(double ax, double ay, double bx, double by, double cx, double cy);
+
+		// This is orient2d on the projection of the given points onto the coordinate plane most nearly
+		// parallel to the plane with the given normal.  Its sign is that of ((b - a) x (c - a)) . normal.
+		static double Orient2D(const Vector3& a, const Vector3& b, const Vector3& c, const Vector3& normal);
+
+		// Positive if point d is on the side of triangle abc that (b - a) x (c - a) points toward.
+		static double Orient3D(const Vector3& a, const Vector3& b, const Vector3& c, const Vector3& d);
+
+		// Evaluates normal . point - D - offset.  Planes in this library are stored as a normal and distance,
+		// so this is the exact side of the given point with respect to the plane as it is actually stored.
+		static double PlaneSide(const Vector3& normal, double D, const Vector3& point, double offset = 0.0);
+
+		// Returns +1 if the whole segment is further than halfWidth in front of the plane, -1 if the whole segment
+		// is further than halfWidth behind it, and 0 if the segment touches the slab of that half-width about the plane.
+		static int SegmentPlaneSide(const Vector3& normal, double D, const Vector3& pointA, const Vector3& pointB, double halfWidth = 0.0);
+
+		static int DominantAxis(const Vector3& normal);
+
+	private:
+
+		static double Orient2DExact(double ax, double ay, double bx, double by, double cx, double cy);
+		static double Orient3DExact(const Vector3& a, const Vector3& b, const Vector3& c, const Vector3& d);
+		static double PlaneSideExact(const Vector3& normal, double D, const Vector3& point, double offset);
+	};
+}
\ No newline at end of file
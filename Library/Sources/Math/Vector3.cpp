@@ -223,35 +223,36 @@ bool Vector3::FromString(const std::string& str)
 	return false;
 }
 
+// Ties between the largest components go to whichever comes first, so that only the zero vector fails.
 bool Vector3::MakeOrthogonalTo(const Vector3& vector)
 {
 	double ax = fabs(vector.x);
 	double ay = fabs(vector.y);
 	double az = fabs(vector.z);
 
-	if (ax > ay && ax > az)
+	if (ax == 0.0 && ay == 0.0 && az == 0.0)
+		return false;
+
+	if (ax >= ay && ax >= az)
 	{
 		this->z = vector.x;
 		this->x = -vector.z;
 		this->y = 0.0;
-		return true;
 	}
-	else if (ay > ax && ay > az)
+	else if (ay >= az)
 	{
 		this->x = vector.y;
 		this->y = -vector.x;
 		this->z = 0.0;
-		return true;
 	}
-	else if (az > ax && az > ay)
+	else
 	{
 		this->y = vector.z;
 		this->z = -vector.y;
 		this->x = 0.0;
-		return true;
 	}
 
-	return false;
+	return true;
 }
 
 bool Vector3::IsEqualTo(const Vector3& vector, double eps /*= MESH_NINJA_EPS*/) const
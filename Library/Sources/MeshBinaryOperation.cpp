@@ -1,5 +1,6 @@
 #include "MeshBinaryOperation.h"
 #include "ConvexPolygonMesh.h"
+#include "MeshCache.h"
 
 using namespace MeshNinja;
 
@@ -15,6 +16,29 @@ MeshBinaryOperation::MeshBinaryOperation()
 	delete this->error;
 }
 
+bool MeshBinaryOperation::PerformCached(const ConvexPolygonMesh& meshA, const ConvexPolygonMesh& meshB, ConvexPolygonMesh& resultingMesh, MeshCache& cache)
+{
+	std::string cacheTag = this->GetCacheTag();
+	if (cacheTag.size() == 0)
+		return this->Perform(meshA, meshB, resultingMesh);
+
+	uint64_t key = MeshCache::Hash(meshB, MeshCache::Hash(meshA, MeshCache::Hash(cacheTag)));
+	if (cache.LoadMesh(key, resultingMesh))
+		return true;
+
+	if (!this->Perform(meshA, meshB, resultingMesh))
+		return false;
+
+	// Failing to store the result doesn't make it any less of a result.
+	cache.StoreMesh(key, resultingMesh);
+	return true;
+}
+
+/*virtual*/ std::string MeshBinaryOperation::GetCacheTag() const
+{
+	return "";
+}
+
 //----------------------------------- MeshMergeOperation -----------------------------------
 
 MeshMergeOperation::MeshMergeOperation()
@@ -35,4 +59,9 @@ MeshMergeOperation::MeshMergeOperation()
 	resultingMesh.FromConvexPolygonArray(polygonArray);
 
 	return true;
+}
+
+/*virtual*/ std::string MeshMergeOperation::GetCacheTag() const
+{
+	return "merge";
 }
\ No newline at end of file
@@ -5,6 +5,7 @@
 namespace MeshNinja
 {
 	class ConvexPolygonMesh;
+	class MeshCache;
 
 	class MESH_NINJA_API MeshBinaryOperation
 	{
@@ -14,6 +15,13 @@ namespace MeshNinja
 
 		virtual bool Perform(const ConvexPolygonMesh& meshA, const ConvexPolygonMesh& meshB, ConvexPolygonMesh& resultingMesh) = 0;
 
+		// This is Perform, but with the result looked up in the given cache first, and stored there if it wasn't found.
+		// Operations that don't describe themselves with a cache tag are just performed.
+		bool PerformCached(const ConvexPolygonMesh& meshA, const ConvexPolygonMesh& meshB, ConvexPolygonMesh& resultingMesh, MeshCache& cache);
+
+		// This names the operation along with any of its parameters that affect the result.
+		virtual std::string GetCacheTag() const;
+
 		std::string* error;
 	};
 
@@ -24,5 +32,6 @@ namespace MeshNinja
 		virtual ~MeshMergeOperation();
 
 		virtual bool Perform(const ConvexPolygonMesh& meshA, const ConvexPolygonMesh& meshB, ConvexPolygonMesh& resultingMesh) override;
+		virtual std::string GetCacheTag() const override;
 	};
 }
\ No newline at end of file
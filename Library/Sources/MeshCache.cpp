@@ -0,0 +1,498 @@
+#include "MeshCache.h"
+#include "ConvexPolygonMesh.h"
+#include "RenderMesh.h"
+#include <thread>
+#include <string.h>
+
+using namespace MeshNinja;
+
+// This takes in a word at a time, which is what makes fingerprinting a large mesh quick.
+class CacheKeyHasher
+{
+public:
+	CacheKeyHasher(uint64_t seed)
+	{
+		this->state = seed ^ 0x9e3779b97f4a7c15;
+	}
+
+	void Add(uint64_t word)
+	{
+		word *= 0x87c37b91114253d5;
+		word = (word << 31) | (word >> 33);
+		this->state ^= word * 0x4cf5ad432745937f;
+		this->state = ((this->state << 27) | (this->state >> 37)) * 5 + 0x52dce729;
+	}
+
+	void Add(double value)
+	{
+		// Both zeros compare equal, so they had better hash the same.
+		if (value == 0.0)
+			value = 0.0;
+
+		uint64_t word = 0;
+		::memcpy(&word, &value, sizeof(word));
+		this->Add(word);
+	}
+
+	void Add(const Vector3& vector)
+	{
+		this->Add(vector.x);
+		this->Add(vector.y);
+		this->Add(vector.z);
+	}
+
+	uint64_t Finish() const
+	{
+		uint64_t hash = this->state;
+		hash ^= hash >> 33;
+		hash *= 0xff51afd7ed558ccd;
+		hash ^= hash >> 33;
+		hash *= 0xc4ceb9fe1a85ec53;
+		hash ^= hash >> 33;
+		return hash;
+	}
+
+private:
+	uint64_t state;
+};
+
+template<typename T>
+static void Write(std::string& data, T value)
+{
+	data.append((const char*)&value, sizeof(T));
+}
+
+template<typename T>
+static bool Read(const std::string& data, size_t& offset, T& value)
+{
+	if (offset + sizeof(T) > data.size())
+		return false;
+
+	::memcpy(&value, data.data() + offset, sizeof(T));
+	offset += sizeof(T);
+	return true;
+}
+
+MeshCache::MeshCache()
+{
+	this->error = new std::string();
+	this->entryMap = new std::map<uint64_t, Entry>();
+	this->useOrderMap = new std::map<uint64_t, uint64_t>();
+	this->mutex = new std::mutex();
+	this->maxBytes = 0;
+	this->useCount = 0;
+	this->open = false;
+	this->stats.totalBytes = 0;
+	this->stats.numEntries = 0;
+	this->ResetStats();
+}
+
+MeshCache::MeshCache(const std::string& directory, uint64_t maxBytes /*= 256 * 1024 * 1024*/) : MeshCache()
+{
+	this->Open(directory, maxBytes);
+}
+
+/*virtual*/ MeshCache::~MeshCache()
+{
+	delete this->error;
+	delete this->entryMap;
+	delete this->useOrderMap;
+	delete this->mutex;
+}
+
+// Whatever is already in the directory is picked up, in order of when it was last used.
+bool MeshCache::Open(const std::string& directory, uint64_t maxBytes /*= 256 * 1024 * 1024*/)
+{
+	std::lock_guard<std::mutex> lock(*this->mutex);
+
+	this->entryMap->clear();
+	this->useOrderMap->clear();
+	this->directory = directory;
+	this->maxBytes = maxBytes;
+	this->useCount = 0;
+	this->stats.totalBytes = 0;
+	this->stats.numEntries = 0;
+	this->open = false;
+
+	std::error_code errorCode;
+	std::filesystem::create_directories(this->directory, errorCode);
+	if (!std::filesystem::is_directory(this->directory, errorCode))
+	{
+		*this->error = "Could not create cache directory: " + directory;
+		return false;
+	}
+
+	struct Found
+	{
+		uint64_t key;
+		uint64_t size;
+		std::filesystem::file_time_type time;
+	};
+
+	std::vector<Found> foundArray;
+
+	for (const std::filesystem::directory_entry& directoryEntry : std::filesystem::directory_iterator(this->directory, errorCode))
+	{
+		if (!directoryEntry.is_regular_file(errorCode) || directoryEntry.path().extension() != ".mesh")
+			continue;
+
+		std::string stem = directoryEntry.path().stem().string();
+		if (stem.size() != 16 || stem.find_first_not_of("0123456789abcdef") != std::string::npos)
+			continue;
+
+		foundArray.push_back(Found{ std::stoull(stem, nullptr, 16), directoryEntry.file_size(errorCode), directoryEntry.last_write_time(errorCode) });
+	}
+
+	std::sort(foundArray.begin(), foundArray.end(), [](const Found& foundA, const Found& foundB) -> bool
+		{
+			return foundA.time < foundB.time;
+		});
+
+	for (const Found& found : foundArray)
+	{
+		Entry entry{ found.size, ++this->useCount };
+		this->entryMap->insert(std::pair<uint64_t, Entry>(found.key, entry));
+		this->useOrderMap->insert(std::pair<uint64_t, uint64_t>(entry.lastUse, found.key));
+		this->stats.totalBytes += found.size;
+	}
+
+	this->stats.numEntries = (int)this->entryMap->size();
+	this->open = true;
+
+	this->Evict();
+	return true;
+}
+
+bool MeshCache::IsOpen() const
+{
+	return this->open;
+}
+
+// This deletes everything in the cache, but not the directory itself.
+void MeshCache::Clear()
+{
+	std::lock_guard<std::mutex> lock(*this->mutex);
+
+	std::error_code errorCode;
+	for (const std::pair<const uint64_t, Entry>& pair : *this->entryMap)
+		std::filesystem::remove(this->MakeFilePath(pair.first), errorCode);
+
+	this->entryMap->clear();
+	this->useOrderMap->clear();
+	this->stats.totalBytes = 0;
+	this->stats.numEntries = 0;
+}
+
+void MeshCache::SetMaxBytes(uint64_t maxBytes)
+{
+	std::lock_guard<std::mutex> lock(*this->mutex);
+
+	this->maxBytes = maxBytes;
+	this->Evict();
+}
+
+MeshCache::Stats MeshCache::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(*this->mutex);
+
+	return this->stats;
+}
+
+void MeshCache::ResetStats()
+{
+	std::lock_guard<std::mutex> lock(*this->mutex);
+
+	this->stats.hits = 0;
+	this->stats.misses = 0;
+	this->stats.stores = 0;
+	this->stats.evictions = 0;
+}
+
+std::filesystem::path MeshCache::MakeFilePath(uint64_t key) const
+{
+	return this->directory / std::format("{:016x}.mesh", key);
+}
+
+void MeshCache::Touch(uint64_t key, Entry& entry)
+{
+	this->useOrderMap->erase(entry.lastUse);
+	entry.lastUse = ++this->useCount;
+	this->useOrderMap->insert(std::pair<uint64_t, uint64_t>(entry.lastUse, key));
+}
+
+void MeshCache::Evict()
+{
+	while (this->stats.totalBytes > this->maxBytes && this->useOrderMap->size() > 0)
+	{
+		uint64_t key = this->useOrderMap->begin()->second;
+		this->useOrderMap->erase(this->useOrderMap->begin());
+
+		std::map<uint64_t, Entry>::iterator iter = this->entryMap->find(key);
+		this->stats.totalBytes -= iter->second.size;
+		this->entryMap->erase(iter);
+
+		std::error_code errorCode;
+		std::filesystem::remove(this->MakeFilePath(key), errorCode);
+
+		this->stats.evictions++;
+	}
+
+	this->stats.numEntries = (int)this->entryMap->size();
+}
+
+bool MeshCache::LoadData(uint64_t key, std::string& data)
+{
+	std::lock_guard<std::mutex> lock(*this->mutex);
+
+	std::map<uint64_t, Entry>::iterator iter = this->entryMap->find(key);
+	if (!this->open || iter == this->entryMap->end())
+	{
+		this->stats.misses++;
+		return false;
+	}
+
+	std::filesystem::path filePath = this->MakeFilePath(key);
+	std::ifstream fileStream(filePath, std::ios::in | std::ios::binary);
+	if (fileStream.is_open())
+	{
+		data.resize(iter->second.size);
+		fileStream.read(data.data(), data.size());
+	}
+
+	if (!fileStream.is_open() || !fileStream)
+	{
+		// Someone else must have removed or changed the file out from under us, so forget about it.
+		this->useOrderMap->erase(iter->second.lastUse);
+		this->stats.totalBytes -= iter->second.size;
+		this->entryMap->erase(iter);
+		this->stats.numEntries = (int)this->entryMap->size();
+		this->stats.misses++;
+		return false;
+	}
+
+	fileStream.close();
+
+	this->Touch(key, iter->second);
+
+	std::error_code errorCode;
+	std::filesystem::last_write_time(filePath, std::filesystem::file_time_type::clock::now(), errorCode);
+
+	this->stats.hits++;
+	return true;
+}
+
+bool MeshCache::StoreData(uint64_t key, const std::string& data)
+{
+	std::lock_guard<std::mutex> lock(*this->mutex);
+
+	if (!this->open)
+	{
+		*this->error = "Cache not open.";
+		return false;
+	}
+
+	// A result bigger than the whole cache would just evict itself.
+	if (data.size() > this->maxBytes)
+		return false;
+
+	// Write to the side and then rename, so that a reader never sees a file half written.
+	std::filesystem::path filePath = this->MakeFilePath(key);
+	std::filesystem::path tempFilePath = filePath;
+	tempFilePath += std::format(".{:x}", (uint64_t)std::hash<std::thread::id>()(std::this_thread::get_id()));
+
+	std::ofstream fileStream(tempFilePath, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!fileStream.is_open())
+	{
+		*this->error = "Could not open cache file for writing: " + tempFilePath.string();
+		return false;
+	}
+
+	fileStream.write(data.data(), data.size());
+	fileStream.close();
+
+	std::error_code errorCode;
+	std::filesystem::rename(tempFilePath, filePath, errorCode);
+	if (errorCode)
+	{
+		std::filesystem::remove(tempFilePath, errorCode);
+		*this->error = "Could not write cache file: " + filePath.string();
+		return false;
+	}
+
+	std::map<uint64_t, Entry>::iterator iter = this->entryMap->find(key);
+	if (iter != this->entryMap->end())
+	{
+		this->stats.totalBytes -= iter->second.size;
+		iter->second.size = data.size();
+	}
+	else
+	{
+		iter = this->entryMap->insert(std::pair<uint64_t, Entry>(key, Entry{ data.size(), 0 })).first;
+		this->useOrderMap->insert(std::pair<uint64_t, uint64_t>(0, key));
+	}
+
+	this->stats.totalBytes += data.size();
+	this->Touch(key, iter->second);
+	this->stats.stores++;
+
+	this->Evict();
+	return true;
+}
+
+bool MeshCache::LoadMesh(uint64_t key, ConvexPolygonMesh& mesh)
+{
+	std::string data;
+	if (!this->LoadData(key, data))
+		return false;
+
+	mesh.Clear();
+
+	size_t offset = 0;
+	uint32_t numVertices = 0, numFacets = 0;
+
+	bool valid = Read(data, offset, numVertices);
+	for (uint32_t i = 0; i < numVertices && valid; i++)
+	{
+		double x = 0.0, y = 0.0, z = 0.0;
+		valid = Read(data, offset, x) && Read(data, offset, y) && Read(data, offset, z);
+		mesh.vertexArray->push_back(Vector3(x, y, z));
+	}
+
+	valid = valid && Read(data, offset, numFacets);
+	for (uint32_t i = 0; i < numFacets && valid; i++)
+	{
+		mesh.facetArray->push_back(ConvexPolygonMesh::Facet());
+		ConvexPolygonMesh::Facet& facet = mesh.facetArray->back();
+
+		uint32_t numFacetVertices = 0;
+		valid = Read(data, offset, numFacetVertices);
+		for (uint32_t j = 0; j < numFacetVertices && valid; j++)
+		{
+			int32_t vertex = 0;
+			valid = Read(data, offset, vertex) && 0 <= vertex && vertex < (int32_t)numVertices;
+			facet.vertexArray->push_back(vertex);
+		}
+	}
+
+	if (!valid || offset != data.size())
+	{
+		mesh.Clear();
+		*this->error = std::format("Cache entry {:016x} is corrupt.", key);
+		return false;
+	}
+
+	return true;
+}
+
+bool MeshCache::StoreMesh(uint64_t key, const ConvexPolygonMesh& mesh)
+{
+	std::string data;
+
+	Write(data, (uint32_t)mesh.vertexArray->size());
+	for (const Vector3& vertex : *mesh.vertexArray)
+	{
+		Write(data, vertex.x);
+		Write(data, vertex.y);
+		Write(data, vertex.z);
+	}
+
+	Write(data, (uint32_t)mesh.facetArray->size());
+	for (const ConvexPolygonMesh::Facet& facet : *mesh.facetArray)
+	{
+		Write(data, (uint32_t)facet.vertexArray->size());
+		for (int i = 0; i < (signed)facet.vertexArray->size(); i++)
+			Write(data, (int32_t)facet[i]);
+	}
+
+	return this->StoreData(key, data);
+}
+
+/*static*/ uint64_t MeshCache::Hash(const void* data, size_t size, uint64_t seed /*= 0*/)
+{
+	CacheKeyHasher hasher(seed);
+	hasher.Add((uint64_t)size);
+
+	const unsigned char* bytes = (const unsigned char*)data;
+	size_t i = 0;
+
+	for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+	{
+		uint64_t word = 0;
+		::memcpy(&word, bytes + i, sizeof(word));
+		hasher.Add(word);
+	}
+
+	if (i < size)
+	{
+		uint64_t word = 0;
+		::memcpy(&word, bytes + i, size - i);
+		hasher.Add(word);
+	}
+
+	return hasher.Finish();
+}
+
+/*static*/ uint64_t MeshCache::Hash(const std::string& string, uint64_t seed /*= 0*/)
+{
+	return Hash(string.data(), string.size(), seed);
+}
+
+// Both the positions and the connectivity go into the hash, so that any change to the mesh, however small,
+// makes for a different key.  Meshes that are the same shape but are laid out differently get different keys.
+/*static*/ uint64_t MeshCache::Hash(const ConvexPolygonMesh& mesh, uint64_t seed /*= 0*/)
+{
+	CacheKeyHasher hasher(seed);
+
+	hasher.Add((uint64_t)mesh.vertexArray->size());
+	for (const Vector3& vertex : *mesh.vertexArray)
+		hasher.Add(vertex);
+
+	hasher.Add((uint64_t)mesh.facetArray->size());
+	for (const ConvexPolygonMesh::Facet& facet : *mesh.facetArray)
+	{
+		hasher.Add((uint64_t)facet.vertexArray->size());
+		for (int i = 0; i < (signed)facet.vertexArray->size(); i++)
+			hasher.Add((uint64_t)facet[i]);
+	}
+
+	return hasher.Finish();
+}
+
+/*static*/ uint64_t MeshCache::Hash(const std::vector<Vector3>& pointArray, uint64_t seed /*= 0*/)
+{
+	CacheKeyHasher hasher(seed);
+
+	hasher.Add((uint64_t)pointArray.size());
+	for (const Vector3& point : pointArray)
+		hasher.Add(point);
+
+	return hasher.Finish();
+}
+
+/*static*/ uint64_t MeshCache::Hash(const RenderMesh& mesh, uint64_t seed /*= 0*/)
+{
+	CacheKeyHasher hasher(seed);
+
+	hasher.Add((uint64_t)mesh.vertexArray->size());
+	for (const RenderMesh::Vertex& vertex : *mesh.vertexArray)
+	{
+		hasher.Add(vertex.position);
+		hasher.Add(vertex.color);
+		hasher.Add(vertex.normal);
+		hasher.Add(vertex.texCoords);
+	}
+
+	hasher.Add((uint64_t)mesh.facetArray->size());
+	for (const RenderMesh::Facet& facet : *mesh.facetArray)
+	{
+		hasher.Add((uint64_t)facet.vertexArray->size());
+		for (int i = 0; i < (signed)facet.vertexArray->size(); i++)
+			hasher.Add((uint64_t)facet[i]);
+
+		hasher.Add(facet.color);
+		hasher.Add(facet.normal);
+		hasher.Add(facet.center);
+	}
+
+	return hasher.Finish();
+}
\ No newline at end of file
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Common.h"
+#include "Math/Vector3.h"
+#include <mutex>
+
+namespace MeshNinja
+{
+	class ConvexPolygonMesh;
+	class RenderMesh;
+
+	// This remembers the results of mesh operations on disk, so that a pipeline run over and over again on
+	// mostly the same inputs only has to do the work for those inputs that changed.  Each result is stored in
+	// its own file, named for a key made by hashing everything that went into it: the input meshes, the kind of
+	// operation, and its parameters.  When the files take up more than the given number of bytes, those least
+	// recently used are deleted.  File times are kept up to date as results are used, so that what's least
+	// recently used is remembered from one run to the next.  A cache may be shared by several threads.
+	class MESH_NINJA_API MeshCache
+	{
+	public:
+		MeshCache();
+		MeshCache(const std::string& directory, uint64_t maxBytes = 256 * 1024 * 1024);
+		virtual ~MeshCache();
+
+		struct Stats
+		{
+			uint64_t hits;
+			uint64_t misses;
+			uint64_t stores;
+			uint64_t evictions;
+			uint64_t totalBytes;
+			int numEntries;
+		};
+
+		bool Open(const std::string& directory, uint64_t maxBytes = 256 * 1024 * 1024);
+		bool IsOpen() const;
+		void Clear();
+		void SetMaxBytes(uint64_t maxBytes);
+		Stats GetStats() const;
+		void ResetStats();
+
+		bool LoadData(uint64_t key, std::string& data);
+		bool StoreData(uint64_t key, const std::string& data);
+		bool LoadMesh(uint64_t key, ConvexPolygonMesh& mesh);
+		bool StoreMesh(uint64_t key, const ConvexPolygonMesh& mesh);
+
+		// Keys are made by feeding everything that matters into a hash, starting from the given seed.
+		// These are the same from one run to the next, and from one machine to the next of the same endianness.
+		static uint64_t Hash(const void* data, size_t size, uint64_t seed = 0);
+		static uint64_t Hash(const std::string& string, uint64_t seed = 0);
+		static uint64_t Hash(const ConvexPolygonMesh& mesh, uint64_t seed = 0);
+		static uint64_t Hash(const RenderMesh& mesh, uint64_t seed = 0);
+		static uint64_t Hash(const std::vector<Vector3>& pointArray, uint64_t seed = 0);
+
+		std::string* error;
+
+	protected:
+
+		struct Entry
+		{
+			uint64_t size;
+			uint64_t lastUse;
+		};
+
+		std::filesystem::path MakeFilePath(uint64_t key) const;
+		void Touch(uint64_t key, Entry& entry);
+		void Evict();
+
+		std::filesystem::path directory;
+		uint64_t maxBytes;
+		uint64_t useCount;
+		Stats stats;
+		bool open;
+
+		// The entries are kept in order of use by the second map, which goes from each entry's last use to its key.
+		std::map<uint64_t, Entry>* entryMap;
+		std::map<uint64_t, uint64_t>* useOrderMap;
+		std::mutex* mutex;
+	};
+}
\ No newline at end of file
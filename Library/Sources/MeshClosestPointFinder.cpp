@@ -0,0 +1,309 @@
+#include "MeshClosestPointFinder.h"
+#include "ConvexPolygonMesh.h"
+#include "Ray.h"
+#include "TaskScheduler.h"
+
+using namespace MeshNinja;
+
+//----------------------------------- MeshClosestPointFinder -----------------------------------
+
+MeshClosestPointFinder::MeshClosestPointFinder()
+{
+	this->tree = new BoundingBoxTree();
+	this->triangleArray = new std::vector<Triangle*>();
+}
+
+/*virtual*/ MeshClosestPointFinder::~MeshClosestPointFinder()
+{
+	this->Clear();
+
+	delete this->tree;
+	delete this->triangleArray;
+}
+
+void MeshClosestPointFinder::Clear()
+{
+	// Note that the tree owns the triangles.
+	this->tree->Clear();
+	this->triangleArray->clear();
+}
+
+// The normal at each vertex is the sum of the normals of the facets around it, each weighted by the area of its facet.
+bool MeshClosestPointFinder::Build(const ConvexPolygonMesh& mesh)
+{
+	this->Clear();
+
+	const std::vector<Vector3>& vertexArray = *mesh.vertexArray;
+
+	std::vector<Vector3> facetNormalArray(mesh.facetArray->size());
+	std::vector<Vector3> vertexNormalArray(vertexArray.size());
+
+	for (int i = 0; i < (signed)mesh.facetArray->size(); i++)
+	{
+		const ConvexPolygonMesh::Facet& facet = (*mesh.facetArray)[i];
+
+		for (int j = 1; j < (signed)facet.vertexArray->size() - 1; j++)
+			facetNormalArray[i] += (vertexArray[facet[j]] - vertexArray[facet[0]]).Cross(vertexArray[facet[j + 1]] - vertexArray[facet[0]]);
+
+		for (int j = 0; j < (signed)facet.vertexArray->size(); j++)
+			vertexNormalArray[facet[j]] += facetNormalArray[i];
+
+		facetNormalArray[i].Normalize();
+	}
+
+	for (Vector3& vertexNormal : vertexNormalArray)
+		vertexNormal.Normalize();
+
+	std::vector<BoundingBoxTree::Object*> objectArray;
+
+	for (int i = 0; i < (signed)mesh.facetArray->size(); i++)
+	{
+		const ConvexPolygonMesh::Facet& facet = (*mesh.facetArray)[i];
+
+		for (int j = 1; j < (signed)facet.vertexArray->size() - 1; j++)
+		{
+			int vertexIndex[3] = { facet[0], facet[j], facet[j + 1] };
+
+			Triangle* triangle = new Triangle(i);
+
+			for (int k = 0; k < 3; k++)
+			{
+				triangle->vertex[k] = vertexArray[vertexIndex[k]];
+
+				// A vertex where the facets around it cancel one another out has no normal of its own.
+				triangle->normal[k] = vertexNormalArray[vertexIndex[k]];
+				if (triangle->normal[k].Length() == 0.0)
+					triangle->normal[k] = facetNormalArray[i];
+			}
+
+			triangle->box = AxisAlignedBoundingBox(triangle->vertex[0]);
+			triangle->box.ExpandToIncludePoint(triangle->vertex[1]);
+			triangle->box.ExpandToIncludePoint(triangle->vertex[2]);
+
+			this->triangleArray->push_back(triangle);
+			objectArray.push_back(triangle);
+		}
+	}
+
+	if (objectArray.size() == 0)
+		return false;
+
+	this->tree->Rebuild(objectArray);
+	return true;
+}
+
+bool MeshClosestPointFinder::IsBuilt() const
+{
+	return this->triangleArray->size() > 0;
+}
+
+bool MeshClosestPointFinder::FindClosestPoint(const Vector3& point, ClosestPoint& closestPoint, double maxDistance /*= DBL_MAX*/) const
+{
+	BoundingBoxTree::TraversalStack stack;
+	return this->FindClosestPoint(point, closestPoint, maxDistance, stack);
+}
+
+bool MeshClosestPointFinder::FindClosestPoint(const Vector3& point, ClosestPoint& closestPoint, double maxDistance, BoundingBoxTree::TraversalStack& stack) const
+{
+	double distance = 0.0;
+	const Triangle* triangle = (const Triangle*)this->tree->FindClosestObject(point, [&point](BoundingBoxTree::Object* object) -> double
+		{
+			return (((Triangle*)object)->CalcClosestPoint(point, nullptr) - point).Length();
+		}, stack, &distance, maxDistance);
+
+	if (!triangle)
+		return false;
+
+	double weight[3];
+	closestPoint.point = triangle->CalcClosestPoint(point, weight);
+	closestPoint.normal = (triangle->normal[0] * weight[0] + triangle->normal[1] * weight[1] + triangle->normal[2] * weight[2]).Normalized();
+	closestPoint.facet = triangle->facet;
+	closestPoint.distance = distance;
+	return true;
+}
+
+void MeshClosestPointFinder::FindClosestPoints(const std::vector<Vector3>& pointArray, std::vector<ClosestPoint>& closestPointArray, double maxDistance /*= DBL_MAX*/, int threadCount /*= 0*/) const
+{
+	closestPointArray.resize(pointArray.size());
+
+	// Points for which nothing is found are given a facet of -1.
+	TaskScheduler::ParallelFor(0, (int)pointArray.size(), 64, [this, &pointArray, &closestPointArray, maxDistance](int start, int stop)
+		{
+			BoundingBoxTree::TraversalStack stack;
+
+			for (int i = start; i < stop; i++)
+			{
+				ClosestPoint& closestPoint = closestPointArray[i];
+				if (!this->FindClosestPoint(pointArray[i], closestPoint, maxDistance, stack))
+				{
+					closestPoint.facet = -1;
+					closestPoint.distance = DBL_MAX;
+				}
+			}
+		}, threadCount);
+}
+
+double MeshClosestPointFinder::CalcDistance(const Vector3& point) const
+{
+	ClosestPoint closestPoint;
+	if (!this->FindClosestPoint(point, closestPoint))
+		return DBL_MAX;
+
+	return closestPoint.distance;
+}
+
+// The tree only rules out the triangles the ray exactly parallels, so those it hits are tested again
+// with the given tolerance.
+bool MeshClosestPointFinder::RayCast(const Ray& ray, double& alpha, int* facet /*= nullptr*/, double eps /*= MESH_NINJA_EPS*/) const
+{
+	const Triangle* foundTriangle = nullptr;
+	double smallestAlpha = DBL_MAX;
+
+	this->tree->ForHitObjects(ray, [&ray, &foundTriangle, &smallestAlpha, eps](BoundingBoxTree::Object* object, double hitAlpha) -> bool
+		{
+			const Triangle* triangle = (const Triangle*)object;
+			if (hitAlpha < smallestAlpha && triangle->IsHitByRay(ray, hitAlpha, eps))
+			{
+				smallestAlpha = hitAlpha;
+				foundTriangle = triangle;
+			}
+
+			return true;
+		});
+
+	if (!foundTriangle)
+		return false;
+
+	alpha = smallestAlpha;
+
+	if (facet)
+		*facet = foundTriangle->facet;
+
+	return true;
+}
+
+//----------------------------------- MeshClosestPointFinder::Triangle -----------------------------------
+
+MeshClosestPointFinder::Triangle::Triangle(int facet)
+{
+	this->facet = facet;
+}
+
+/*virtual*/ MeshClosestPointFinder::Triangle::~Triangle()
+{
+}
+
+/*virtual*/ AxisAlignedBoundingBox MeshClosestPointFinder::Triangle::GetBoundingBox() const
+{
+	return this->box;
+}
+
+/*virtual*/ bool MeshClosestPointFinder::Triangle::IsHitByRay(const Ray& ray, double& alpha) const
+{
+	return this->IsHitByRay(ray, alpha, 0.0);
+}
+
+// This is the Moller-Trumbore test.  The determinant is the ray direction dotted with the unnormalized
+// normal, so dividing out the lengths gives the sine of the angle between the ray and the triangle.
+bool MeshClosestPointFinder::Triangle::IsHitByRay(const Ray& ray, double& alpha, double eps) const
+{
+	Vector3 edgeA = this->vertex[1] - this->vertex[0];
+	Vector3 edgeB = this->vertex[2] - this->vertex[0];
+
+	Vector3 p = ray.direction.Cross(edgeB);
+	double det = edgeA.Dot(p);
+	if (fabs(det) <= eps * ray.direction.Length() * edgeA.Cross(edgeB).Length())
+		return false;
+
+	double invDet = 1.0 / det;
+
+	Vector3 t = ray.origin - this->vertex[0];
+	double u = t.Dot(p) * invDet;
+	if (u < 0.0 || u > 1.0)
+		return false;
+
+	Vector3 q = t.Cross(edgeA);
+	double v = ray.direction.Dot(q) * invDet;
+	if (v < 0.0 || u + v > 1.0)
+		return false;
+
+	alpha = edgeB.Dot(q) * invDet;
+	return alpha >= 0.0;
+}
+
+// See "Real-Time Collision Detection" by Christer Ericson, section 5.1.5.  We work out which of the regions
+// of the triangle's plane, bounded by its vertices, edges and face, the point projects into.  The weights
+// of the vertices in the returned point are given back too if asked for.
+Vector3 MeshClosestPointFinder::Triangle::CalcClosestPoint(const Vector3& point, double* weight) const
+{
+	const Vector3& a = this->vertex[0];
+	const Vector3& b = this->vertex[1];
+	const Vector3& c = this->vertex[2];
+
+	double u = 1.0, v = 0.0, w = 0.0;
+
+	Vector3 ab = b - a;
+	Vector3 ac = c - a;
+	Vector3 ap = point - a;
+	double d1 = ab.Dot(ap);
+	double d2 = ac.Dot(ap);
+
+	Vector3 bp = point - b;
+	double d3 = ab.Dot(bp);
+	double d4 = ac.Dot(bp);
+
+	Vector3 cp = point - c;
+	double d5 = ab.Dot(cp);
+	double d6 = ac.Dot(cp);
+
+	double vc = d1 * d4 - d3 * d2;
+	double vb = d5 * d2 - d1 * d6;
+	double va = d3 * d6 - d5 * d4;
+
+	if (d1 <= 0.0 && d2 <= 0.0)
+	{
+		u = 1.0; v = 0.0; w = 0.0;
+	}
+	else if (d3 >= 0.0 && d4 <= d3)
+	{
+		u = 0.0; v = 1.0; w = 0.0;
+	}
+	else if (d6 >= 0.0 && d5 <= d6)
+	{
+		u = 0.0; v = 0.0; w = 1.0;
+	}
+	else if (vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0)
+	{
+		v = d1 / (d1 - d3);
+		u = 1.0 - v; w = 0.0;
+	}
+	else if (vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0)
+	{
+		w = d2 / (d2 - d6);
+		u = 1.0 - w; v = 0.0;
+	}
+	else if (va <= 0.0 && (d4 - d3) >= 0.0 && (d5 - d6) >= 0.0)
+	{
+		w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+		u = 0.0; v = 1.0 - w;
+	}
+	else
+	{
+		double denominator = va + vb + vc;
+		if (denominator != 0.0)
+		{
+			v = vb / denominator;
+			w = vc / denominator;
+			u = 1.0 - v - w;
+		}
+	}
+
+	if (weight)
+	{
+		weight[0] = u;
+		weight[1] = v;
+		weight[2] = w;
+	}
+
+	return a * u + b * v + c * w;
+}
\ No newline at end of file
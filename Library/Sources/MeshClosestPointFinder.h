@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Common.h"
+#include "Math/Vector3.h"
+#include "BoundingBoxTree.h"
+
+namespace MeshNinja
+{
+	class ConvexPolygonMesh;
+	class Ray;
+
+	// This finds the point on the surface of a given mesh closest to a given point, and casts rays against that surface.
+	// The mesh is triangulated once into a bounding-box tree that persists between queries, so that only the triangles
+	// near a query are ever looked at.  All queries are const, and so may be made from any number of threads at once
+	// after the finder has been built.
+	class MESH_NINJA_API MeshClosestPointFinder
+	{
+	public:
+		MeshClosestPointFinder();
+		virtual ~MeshClosestPointFinder();
+
+		struct ClosestPoint
+		{
+			Vector3 point;
+			Vector3 normal;		// This is interpolated from the normals of the vertices around the point, so it's smooth across edges.
+			int facet;
+			double distance;
+		};
+
+		void Clear();
+		bool Build(const ConvexPolygonMesh& mesh);
+		bool IsBuilt() const;
+
+		// Nothing is found if the surface is further away than the given distance.
+		bool FindClosestPoint(const Vector3& point, ClosestPoint& closestPoint, double maxDistance = DBL_MAX) const;
+		void FindClosestPoints(const std::vector<Vector3>& pointArray, std::vector<ClosestPoint>& closestPointArray, double maxDistance = DBL_MAX, int threadCount = 0) const;
+		double CalcDistance(const Vector3& point) const;
+
+		// Unlike the other queries, this counts a hit at the ray origin.  A triangle the ray is within the given
+		// tolerance of parallel to, by the sine of the angle between them, isn't counted as hit.
+		bool RayCast(const Ray& ray, double& alpha, int* facet = nullptr, double eps = MESH_NINJA_EPS) const;
+
+	protected:
+
+		bool FindClosestPoint(const Vector3& point, ClosestPoint& closestPoint, double maxDistance, BoundingBoxTree::TraversalStack& stack) const;
+
+		class Triangle : public BoundingBoxTree::Object
+		{
+		public:
+			Triangle(int facet);
+			virtual ~Triangle();
+
+			virtual AxisAlignedBoundingBox GetBoundingBox() const override;
+			virtual bool IsHitByRay(const Ray& ray, double& alpha) const override;
+			bool IsHitByRay(const Ray& ray, double& alpha, double eps) const;
+
+			Vector3 CalcClosestPoint(const Vector3& point, double* weight) const;
+
+			Vector3 vertex[3];
+			Vector3 normal[3];
+			AxisAlignedBoundingBox box;
+			int facet;
+		};
+
+		BoundingBoxTree* tree;
+		std::vector<Triangle*>* triangleArray;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,591 @@
+#include "MeshDecimator.h"
+#include "ConvexPolygonMesh.h"
+#include "TaskScheduler.h"
+#include "Math/Matrix3x3.h"
+#include <queue>
+
+using namespace MeshNinja;
+
+MeshDecimator::MeshDecimator()
+{
+	this->targetTriangleCount = 0;
+	this->maxError = DBL_MAX;
+	this->maxNormalTurn = MESH_NINJA_PI / 3.0;
+	this->preserveBoundaries = true;
+	this->parallelThreshold = 250000;
+	this->vertexArray = new std::vector<Vector3>();
+	this->triangleArray = new std::vector<Triangle>();
+	this->vertexTriangleArray = new std::vector<std::vector<int>>();
+	this->quadricArray = new std::vector<Quadric>();
+	this->versionArray = new std::vector<int>();
+	this->boundaryArray = new std::vector<char>();
+	this->triangleCount = 0;
+}
+
+/*virtual*/ MeshDecimator::~MeshDecimator()
+{
+	delete this->vertexArray;
+	delete this->triangleArray;
+	delete this->vertexTriangleArray;
+	delete this->quadricArray;
+	delete this->versionArray;
+	delete this->boundaryArray;
+}
+
+bool MeshDecimator::Decimate(ConvexPolygonMesh& mesh, int threadCount /*= 0*/)
+{
+	if (this->targetTriangleCount < 0 || this->maxError < 0.0)
+		return false;
+
+	this->Setup(mesh, threadCount);
+
+	if (this->triangleCount == 0)
+		return false;
+
+	double maxCost = (this->maxError == DBL_MAX) ? DBL_MAX : MESH_NINJA_SQUARED(this->maxError);
+
+	if (this->triangleCount > this->parallelThreshold)
+		this->DecimateInRounds(MESH_NINJA_MAX(this->targetTriangleCount, this->parallelThreshold), maxCost, threadCount);
+
+	this->DecimateSerially(this->targetTriangleCount, maxCost, threadCount);
+
+	this->MakeMesh(mesh);
+
+	this->vertexArray->clear();
+	this->triangleArray->clear();
+	this->vertexTriangleArray->clear();
+	this->quadricArray->clear();
+	this->versionArray->clear();
+	this->boundaryArray->clear();
+	this->triangleCount = 0;
+
+	return true;
+}
+
+// Each facet is fanned into triangles, which is fine, since they're all convex.  Each vertex then gathers its quadric
+// from the triangles around it, so the vertices can all be done at once.  An edge of the mesh that only one triangle
+// has is a border, and each end of it gets a plane through it at right angles to that triangle, weighted heavily
+// enough that moving the border costs a lot more than moving anything else.
+void MeshDecimator::Setup(const ConvexPolygonMesh& mesh, int threadCount)
+{
+	*this->vertexArray = *mesh.vertexArray;
+	this->triangleArray->clear();
+
+	for (const ConvexPolygonMesh::Facet& facet : *mesh.facetArray)
+		for (int i = 1; i < (signed)facet.vertexArray->size() - 1; i++)
+			this->triangleArray->push_back(Triangle{ { facet[0], facet[i], facet[i + 1] } });
+
+	int numVertices = (int)this->vertexArray->size();
+	this->triangleCount = (int)this->triangleArray->size();
+
+	this->vertexTriangleArray->clear();
+	this->vertexTriangleArray->resize(numVertices);
+	for (int i = 0; i < this->triangleCount; i++)
+		for (int j = 0; j < 3; j++)
+			(*this->vertexTriangleArray)[(*this->triangleArray)[i].vertex[j]].push_back(i);
+
+	this->quadricArray->resize(numVertices);
+	this->versionArray->assign(numVertices, 0);
+	this->boundaryArray->assign(numVertices, 0);
+
+	const double boundaryWeight = 1000.0;
+
+	TaskScheduler::ParallelFor(0, numVertices, 1024, [this, boundaryWeight](int start, int stop)
+		{
+			std::vector<int> edgeVertexArray;
+
+			for (int i = start; i < stop; i++)
+			{
+				Quadric& quadric = (*this->quadricArray)[i];
+				quadric.Clear();
+				edgeVertexArray.clear();
+
+				for (int j : (*this->vertexTriangleArray)[i])
+				{
+					const Triangle& triangle = (*this->triangleArray)[j];
+					const Vector3& pointA = (*this->vertexArray)[triangle.vertex[0]];
+					const Vector3& pointB = (*this->vertexArray)[triangle.vertex[1]];
+					const Vector3& pointC = (*this->vertexArray)[triangle.vertex[2]];
+
+					Vector3 normal = (pointB - pointA).Cross(pointC - pointA);
+					double area = 0.0;
+					if (normal.Normalize(&area))
+					{
+						area /= 2.0;
+						quadric.AddPlane(normal, -normal.Dot(pointA), area);
+						quadric.weight += area;
+					}
+
+					for (int k = 0; k < 3; k++)
+						if (triangle.vertex[k] != i)
+							edgeVertexArray.push_back(triangle.vertex[k]);
+				}
+
+				// Each edge from this vertex turns up once for every triangle that has it.
+				std::sort(edgeVertexArray.begin(), edgeVertexArray.end());
+
+				for (int k = 0; k < (signed)edgeVertexArray.size(); k++)
+				{
+					int edgeVertex = edgeVertexArray[k];
+					if ((k > 0 && edgeVertexArray[k - 1] == edgeVertex) || (k + 1 < (signed)edgeVertexArray.size() && edgeVertexArray[k + 1] == edgeVertex))
+						continue;
+
+					(*this->boundaryArray)[i] = 1;
+
+					if (!this->preserveBoundaries)
+						continue;
+
+					for (int j : (*this->vertexTriangleArray)[i])
+					{
+						const Triangle& triangle = (*this->triangleArray)[j];
+						if (!triangle.HasVertex(edgeVertex))
+							continue;
+
+						const Vector3& pointA = (*this->vertexArray)[triangle.vertex[0]];
+						Vector3 faceNormal = ((*this->vertexArray)[triangle.vertex[1]] - pointA).Cross((*this->vertexArray)[triangle.vertex[2]] - pointA);
+						Vector3 edgeVector = (*this->vertexArray)[edgeVertex] - (*this->vertexArray)[i];
+						Vector3 normal = edgeVector.Cross(faceNormal);
+						if (normal.Normalize())
+							quadric.AddPlane(normal, -normal.Dot((*this->vertexArray)[i]), boundaryWeight * edgeVector.Dot(edgeVector));
+					}
+				}
+			}
+		}, threadCount);
+}
+
+// The candidates are found a chunk of vertices at a time, each vertex offering its edges to the vertices after it,
+// and the chunks are put together in order, so the list comes out the same however the work was shared.
+void MeshDecimator::FindCollapses(std::vector<Collapse>& collapseArray, double maxCost, int threadCount) const
+{
+	const int grainSize = 1024;
+	int numVertices = (int)this->vertexArray->size();
+	int numChunks = (numVertices + grainSize - 1) / grainSize;
+
+	std::vector<std::vector<Collapse>> chunkArray(numChunks);
+
+	TaskScheduler::ParallelFor(0, numVertices, grainSize, [this, &chunkArray, maxCost, grainSize](int start, int stop)
+		{
+			std::vector<Collapse>& chunkCollapseArray = chunkArray[start / grainSize];
+			std::vector<int> neighborArray;
+
+			for (int i = start; i < stop; i++)
+			{
+				this->FindNeighbors(i, neighborArray);
+
+				for (int j : neighborArray)
+				{
+					Collapse collapse;
+					if (j > i && this->CalcCollapse(i, j, collapse) && collapse.cost <= maxCost)
+						chunkCollapseArray.push_back(collapse);
+				}
+			}
+		}, threadCount);
+
+	collapseArray.clear();
+	for (const std::vector<Collapse>& chunkCollapseArray : chunkArray)
+		collapseArray.insert(collapseArray.end(), chunkCollapseArray.begin(), chunkCollapseArray.end());
+}
+
+// Two collapses can be done at the same time if neither touches a triangle the other does.  That's so if the ends of
+// each aren't among the ends of the other or their neighbors, which is easy to keep track of by marking each
+// collapse's ends and their neighbors as it's chosen.  Only the cheaper part of the candidates is looked at in each
+// round, so that nothing expensive is done while there's still plenty that's cheap.
+void MeshDecimator::DecimateInRounds(int targetCount, double maxCost, int threadCount)
+{
+	std::vector<Collapse> collapseArray, chosenCollapseArray;
+	std::vector<int> neighborArray;
+	std::vector<char> markArray;
+
+	while (this->triangleCount > targetCount)
+	{
+		this->FindCollapses(collapseArray, maxCost, threadCount);
+		if (collapseArray.size() == 0)
+			break;
+
+		std::sort(collapseArray.begin(), collapseArray.end());
+
+		int numCandidates = MESH_NINJA_MAX((int)collapseArray.size() / 4, 1);
+		int maxCollapses = MESH_NINJA_MAX((this->triangleCount - targetCount) / 2, 1);
+
+		markArray.assign(this->vertexArray->size(), 0);
+		chosenCollapseArray.clear();
+
+		for (int i = 0; i < numCandidates && (int)chosenCollapseArray.size() < maxCollapses; i++)
+		{
+			const Collapse& collapse = collapseArray[i];
+			if (markArray[collapse.vertexA] || markArray[collapse.vertexB])
+				continue;
+
+			chosenCollapseArray.push_back(collapse);
+
+			markArray[collapse.vertexA] = 1;
+			markArray[collapse.vertexB] = 1;
+
+			this->FindNeighbors(collapse.vertexA, neighborArray);
+			for (int j : neighborArray)
+				markArray[j] = 1;
+
+			this->FindNeighbors(collapse.vertexB, neighborArray);
+			for (int j : neighborArray)
+				markArray[j] = 1;
+		}
+
+		std::vector<int> removedCountArray(chosenCollapseArray.size(), 0);
+
+		TaskScheduler::ParallelFor(0, (int)chosenCollapseArray.size(), 64, [this, &chosenCollapseArray, &removedCountArray](int start, int stop)
+			{
+				for (int i = start; i < stop; i++)
+					if (this->IsCollapseValid(chosenCollapseArray[i]))
+						removedCountArray[i] = this->PerformCollapse(chosenCollapseArray[i]);
+			}, threadCount);
+
+		int removedCount = 0;
+		for (int count : removedCountArray)
+			removedCount += count;
+
+		if (removedCount == 0)
+			break;
+
+		this->triangleCount -= removedCount;
+	}
+}
+
+// Candidates are never taken out of the heap when a collapse makes them stale.  They're just passed over when they
+// come up, since their versions no longer match those of their vertices.
+void MeshDecimator::DecimateSerially(int targetCount, double maxCost, int threadCount)
+{
+	std::vector<Collapse> collapseArray;
+	this->FindCollapses(collapseArray, maxCost, threadCount);
+
+	std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> collapseQueue(std::greater<Collapse>(), std::move(collapseArray));
+	std::vector<int> neighborArray;
+
+	while (this->triangleCount > targetCount && collapseQueue.size() > 0)
+	{
+		Collapse collapse = collapseQueue.top();
+		collapseQueue.pop();
+
+		if (collapse.versionA != (*this->versionArray)[collapse.vertexA] || collapse.versionB != (*this->versionArray)[collapse.vertexB])
+			continue;
+
+		if (!this->IsCollapseValid(collapse))
+			continue;
+
+		this->triangleCount -= this->PerformCollapse(collapse);
+
+		this->FindNeighbors(collapse.vertexA, neighborArray);
+		for (int j : neighborArray)
+		{
+			Collapse newCollapse;
+			if (this->CalcCollapse(MESH_NINJA_MIN(collapse.vertexA, j), MESH_NINJA_MAX(collapse.vertexA, j), newCollapse) && newCollapse.cost <= maxCost)
+				collapseQueue.push(newCollapse);
+		}
+	}
+}
+
+// Vertices left with no triangles are dropped, and the rest keep their order.
+void MeshDecimator::MakeMesh(ConvexPolygonMesh& mesh) const
+{
+	mesh.Clear();
+
+	std::vector<int> indexArray(this->vertexArray->size(), -1);
+
+	for (const Triangle& triangle : *this->triangleArray)
+	{
+		if (triangle.IsRemoved())
+			continue;
+
+		for (int i = 0; i < 3; i++)
+			indexArray[triangle.vertex[i]] = 0;
+	}
+
+	for (int i = 0; i < (signed)indexArray.size(); i++)
+	{
+		if (indexArray[i] == 0)
+		{
+			indexArray[i] = (int)mesh.vertexArray->size();
+			mesh.vertexArray->push_back((*this->vertexArray)[i]);
+		}
+	}
+
+	mesh.facetArray->reserve(this->triangleCount);
+
+	for (const Triangle& triangle : *this->triangleArray)
+	{
+		if (triangle.IsRemoved())
+			continue;
+
+		ConvexPolygonMesh::Facet facet;
+		for (int i = 0; i < 3; i++)
+			facet.vertexArray->push_back(indexArray[triangle.vertex[i]]);
+
+		mesh.facetArray->push_back(facet);
+	}
+}
+
+void MeshDecimator::FindNeighbors(int i, std::vector<int>& neighborArray) const
+{
+	neighborArray.clear();
+
+	for (int j : (*this->vertexTriangleArray)[i])
+	{
+		const Triangle& triangle = (*this->triangleArray)[j];
+		if (triangle.IsRemoved())
+			continue;
+
+		for (int k = 0; k < 3; k++)
+			if (triangle.vertex[k] != i)
+				neighborArray.push_back(triangle.vertex[k]);
+	}
+
+	std::sort(neighborArray.begin(), neighborArray.end());
+	neighborArray.erase(std::unique(neighborArray.begin(), neighborArray.end()), neighborArray.end());
+}
+
+// The point minimizing the combined quadric is used if there is one to be had.  Otherwise, the quadric doesn't care
+// where along some line or plane the point goes, and we settle for the best of the ends and the middle of the edge.
+bool MeshDecimator::CalcCollapse(int i, int j, Collapse& collapse) const
+{
+	Quadric quadric = (*this->quadricArray)[i];
+	quadric.Add((*this->quadricArray)[j]);
+
+	collapse.vertexA = i;
+	collapse.vertexB = j;
+	collapse.versionA = (*this->versionArray)[i];
+	collapse.versionB = (*this->versionArray)[j];
+
+	if (quadric.Minimize(collapse.point))
+		collapse.cost = quadric.Evaluate(collapse.point);
+	else
+	{
+		const Vector3& pointA = (*this->vertexArray)[i];
+		const Vector3& pointB = (*this->vertexArray)[j];
+		Vector3 pointArray[3] = { pointA, pointB, (pointA + pointB) / 2.0 };
+
+		collapse.cost = DBL_MAX;
+		for (const Vector3& point : pointArray)
+		{
+			double cost = quadric.Evaluate(point);
+			if (cost < collapse.cost)
+			{
+				collapse.cost = cost;
+				collapse.point = point;
+			}
+		}
+	}
+
+	// The quadric comes out a little negative sometimes from round-off.
+	collapse.cost = MESH_NINJA_MAX(collapse.cost, 0.0);
+	if (quadric.weight > 0.0)
+		collapse.cost /= quadric.weight;
+
+	return collapse.cost == collapse.cost;
+}
+
+// The ends of an edge must have no neighbors in common other than those across the triangles on the edge, or the
+// collapse would pinch the mesh there.  An edge that isn't on a border, but whose ends both are, would close a gap.
+bool MeshDecimator::IsCollapseValid(const Collapse& collapse) const
+{
+	int i = collapse.vertexA;
+	int j = collapse.vertexB;
+
+	const std::vector<int>& triangleListA = (*this->vertexTriangleArray)[i];
+	const std::vector<int>& triangleListB = (*this->vertexTriangleArray)[j];
+
+	int sharedCount = 0;
+	for (int k : triangleListA)
+		if (!(*this->triangleArray)[k].IsRemoved() && (*this->triangleArray)[k].HasVertex(j))
+			sharedCount++;
+
+	if (sharedCount == 0 || sharedCount > 2)
+		return false;
+
+	if (sharedCount == 2 && (*this->boundaryArray)[i] && (*this->boundaryArray)[j])
+		return false;
+
+	std::vector<int> neighborArrayA, neighborArrayB, commonArray, unionArray;
+	this->FindNeighbors(i, neighborArrayA);
+	this->FindNeighbors(j, neighborArrayB);
+
+	std::set_intersection(neighborArrayA.begin(), neighborArrayA.end(), neighborArrayB.begin(), neighborArrayB.end(), std::back_inserter(commonArray));
+	std::set_union(neighborArrayA.begin(), neighborArrayA.end(), neighborArrayB.begin(), neighborArrayB.end(), std::back_inserter(unionArray));
+
+	if ((int)commonArray.size() != sharedCount)
+		return false;
+
+	// The ends of the edge are each in the other's list of neighbors.  What's left must still be enough to go around the new vertex.
+	if ((int)unionArray.size() - 2 < 3)
+		return false;
+
+	double minCosine = ::cos(this->maxNormalTurn);
+
+	for (const std::vector<int>* triangleList : { &triangleListA, &triangleListB })
+	{
+		for (int k : *triangleList)
+		{
+			const Triangle& triangle = (*this->triangleArray)[k];
+			if (triangle.IsRemoved() || (triangle.HasVertex(i) && triangle.HasVertex(j)))
+				continue;
+
+			Vector3 point[3], movedPoint[3];
+			for (int l = 0; l < 3; l++)
+			{
+				point[l] = (*this->vertexArray)[triangle.vertex[l]];
+				movedPoint[l] = (triangle.vertex[l] == i || triangle.vertex[l] == j) ? collapse.point : point[l];
+			}
+
+			Vector3 normal = (point[1] - point[0]).Cross(point[2] - point[0]);
+			Vector3 movedNormal = (movedPoint[1] - movedPoint[0]).Cross(movedPoint[2] - movedPoint[0]);
+
+			double length = normal.Length();
+			double movedLength = movedNormal.Length();
+
+			if (movedLength <= MESH_NINJA_EPS * MESH_NINJA_EPS * length)
+				return false;
+
+			if (length > 0.0 && normal.Dot(movedNormal) < minCosine * length * movedLength)
+				return false;
+		}
+	}
+
+	return true;
+}
+
+// Vertex B is left with no triangles, and so drops out of the mesh.  This gives the number of triangles removed.
+int MeshDecimator::PerformCollapse(const Collapse& collapse)
+{
+	int i = collapse.vertexA;
+	int j = collapse.vertexB;
+
+	std::vector<int>& triangleListA = (*this->vertexTriangleArray)[i];
+	std::vector<int>& triangleListB = (*this->vertexTriangleArray)[j];
+
+	int removedCount = 0;
+	for (int k : triangleListA)
+	{
+		Triangle& triangle = (*this->triangleArray)[k];
+		if (!triangle.IsRemoved() && triangle.HasVertex(j))
+		{
+			triangle.vertex[0] = -1;
+			removedCount++;
+		}
+	}
+
+	std::vector<int> triangleList;
+	triangleList.reserve(triangleListA.size() + triangleListB.size());
+
+	for (int k : triangleListA)
+		if (!(*this->triangleArray)[k].IsRemoved())
+			triangleList.push_back(k);
+
+	for (int k : triangleListB)
+	{
+		Triangle& triangle = (*this->triangleArray)[k];
+		if (triangle.IsRemoved())
+			continue;
+
+		for (int l = 0; l < 3; l++)
+			if (triangle.vertex[l] == j)
+				triangle.vertex[l] = i;
+
+		triangleList.push_back(k);
+	}
+
+	triangleListA = std::move(triangleList);
+	triangleListB.clear();
+	triangleListB.shrink_to_fit();
+
+	(*this->vertexArray)[i] = collapse.point;
+	(*this->quadricArray)[i].Add((*this->quadricArray)[j]);
+	(*this->boundaryArray)[i] = (*this->boundaryArray)[i] || (*this->boundaryArray)[j];
+	(*this->versionArray)[i]++;
+	(*this->versionArray)[j]++;
+
+	return removedCount;
+}
+
+//----------------------------------- MeshDecimator::Quadric -----------------------------------
+
+void MeshDecimator::Quadric::Clear()
+{
+	for (int i = 0; i < 10; i++)
+		this->a[i] = 0.0;
+
+	this->weight = 0.0;
+}
+
+// The plane is that of the points x with n.x + d = 0, and the quadric of it gives the squared distance to it.
+void MeshDecimator::Quadric::AddPlane(const Vector3& normal, double d, double weight)
+{
+	this->a[0] += weight * normal.x * normal.x;
+	this->a[1] += weight * normal.x * normal.y;
+	this->a[2] += weight * normal.x * normal.z;
+	this->a[3] += weight * normal.x * d;
+	this->a[4] += weight * normal.y * normal.y;
+	this->a[5] += weight * normal.y * normal.z;
+	this->a[6] += weight * normal.y * d;
+	this->a[7] += weight * normal.z * normal.z;
+	this->a[8] += weight * normal.z * d;
+	this->a[9] += weight * d * d;
+}
+
+void MeshDecimator::Quadric::Add(const Quadric& quadric)
+{
+	for (int i = 0; i < 10; i++)
+		this->a[i] += quadric.a[i];
+
+	this->weight += quadric.weight;
+}
+
+double MeshDecimator::Quadric::Evaluate(const Vector3& point) const
+{
+	double x = point.x, y = point.y, z = point.z;
+
+	return
+		this->a[0] * x * x + 2.0 * this->a[1] * x * y + 2.0 * this->a[2] * x * z + 2.0 * this->a[3] * x +
+		this->a[4] * y * y + 2.0 * this->a[5] * y * z + 2.0 * this->a[6] * y +
+		this->a[7] * z * z + 2.0 * this->a[8] * z +
+		this->a[9];
+}
+
+// A nearly singular system is refused, rather than solved, since its answer could be anywhere.
+bool MeshDecimator::Quadric::Minimize(Vector3& point) const
+{
+	Matrix3x3 matrix;
+	matrix.ele[0][0] = this->a[0];
+	matrix.ele[0][1] = this->a[1];
+	matrix.ele[0][2] = this->a[2];
+	matrix.ele[1][0] = this->a[1];
+	matrix.ele[1][1] = this->a[4];
+	matrix.ele[1][2] = this->a[5];
+	matrix.ele[2][0] = this->a[2];
+	matrix.ele[2][1] = this->a[5];
+	matrix.ele[2][2] = this->a[7];
+
+	double scale = matrix.Trace();
+	if (scale <= 0.0 || ::fabs(matrix.Determinant()) <= 1e-9 * MESH_NINJA_CUBED(scale))
+		return false;
+
+	Matrix3x3 inverse;
+	if (!matrix.GetInverse(inverse))
+		return false;
+
+	point = inverse * Vector3(-this->a[3], -this->a[6], -this->a[8]);
+	return true;
+}
+
+bool MeshDecimator::Collapse::operator<(const Collapse& collapse) const
+{
+	if (this->cost != collapse.cost)
+		return this->cost < collapse.cost;
+
+	if (this->vertexA != collapse.vertexA)
+		return this->vertexA < collapse.vertexA;
+
+	return this->vertexB < collapse.vertexB;
+}
+
+bool MeshDecimator::Collapse::operator>(const Collapse& collapse) const
+{
+	return collapse < *this;
+}
\ No newline at end of file
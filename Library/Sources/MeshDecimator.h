@@ -0,0 +1,106 @@
+#pragma once
+
+#include "Common.h"
+#include "Math/Vector3.h"
+
+namespace MeshNinja
+{
+	class ConvexPolygonMesh;
+
+	// This reduces the number of triangles in a mesh by collapsing its edges one at a time, each into a single vertex,
+	// always choosing the collapse that least disturbs the shape, as measured by the quadric error metric of Garland and
+	// Heckbert.  Each vertex carries the sum of the squared distances to the planes of the triangles it has absorbed, in
+	// the form of a quadric, and an edge collapses to the point minimizing the sum of the quadrics of its ends.  The
+	// mesh is triangulated first, and comes back as triangles.
+	//
+	// A collapse is refused if it would change the topology of the mesh, by pinching it or closing a hole, or if it
+	// would turn any triangle too far, which is what folds a mesh over on itself.  Borders of the mesh are kept in
+	// place by planes at right angles to the triangles along them.
+	//
+	// Very large meshes are first brought down to size in rounds.  In each, the cheapest collapses that share no
+	// triangles with one another are all done at once, in parallel, before the costs are found again.  This isn't
+	// quite as careful as taking the single cheapest collapse every time, which is how the rest is done, but it's
+	// what makes millions of triangles practical.  Either way, the result is the same for any number of threads.
+	class MESH_NINJA_API MeshDecimator
+	{
+	public:
+		MeshDecimator();
+		virtual ~MeshDecimator();
+
+		// Collapses go on until the mesh has no more than the target number of triangles, or until no collapse
+		// is left that would move the surface by less than the maximum error, whichever comes first.
+		bool Decimate(ConvexPolygonMesh& mesh, int threadCount = 0);
+
+		// A count of zero means there's no target count.
+		int targetTriangleCount;
+
+		// This is a distance, the root of the mean squared distance from a collapsed vertex to the planes it stands for.
+		double maxError;
+
+		// This is the angle, in radians, beyond which no triangle may be turned by a collapse.
+		double maxNormalTurn;
+
+		bool preserveBoundaries;
+
+		// Meshes with more triangles than this are brought down to this many in parallel rounds first.
+		int parallelThreshold;
+
+	protected:
+
+		// This is the symmetric 4x4 matrix of a quadric, by its upper triangle, along with the total
+		// weight of the planes that went into it.
+		struct Quadric
+		{
+			double a[10];
+			double weight;
+
+			void Clear();
+			void AddPlane(const Vector3& normal, double d, double weight);
+			void Add(const Quadric& quadric);
+			double Evaluate(const Vector3& point) const;
+			bool Minimize(Vector3& point) const;
+		};
+
+		struct Triangle
+		{
+			int vertex[3];
+
+			bool IsRemoved() const { return this->vertex[0] < 0; }
+			bool HasVertex(int i) const { return this->vertex[0] == i || this->vertex[1] == i || this->vertex[2] == i; }
+		};
+
+		// Vertex B is collapsed into vertex A.  The versions are those of the vertices when this was made, which tells
+		// us whether it's gone stale.
+		struct Collapse
+		{
+			int vertexA;
+			int vertexB;
+			int versionA;
+			int versionB;
+			double cost;
+			Vector3 point;
+
+			bool operator<(const Collapse& collapse) const;
+			bool operator>(const Collapse& collapse) const;
+		};
+
+		void Setup(const ConvexPolygonMesh& mesh, int threadCount);
+		void DecimateInRounds(int targetCount, double maxCost, int threadCount);
+		void DecimateSerially(int targetCount, double maxCost, int threadCount);
+		void FindCollapses(std::vector<Collapse>& collapseArray, double maxCost, int threadCount) const;
+		void MakeMesh(ConvexPolygonMesh& mesh) const;
+		void FindNeighbors(int i, std::vector<int>& neighborArray) const;
+		bool CalcCollapse(int i, int j, Collapse& collapse) const;
+		bool IsCollapseValid(const Collapse& collapse) const;
+		int PerformCollapse(const Collapse& collapse);
+
+		// This is all only used while a mesh is being decimated.
+		std::vector<Vector3>* vertexArray;
+		std::vector<Triangle>* triangleArray;
+		std::vector<std::vector<int>>* vertexTriangleArray;
+		std::vector<Quadric>* quadricArray;
+		std::vector<int>* versionArray;
+		std::vector<char>* boundaryArray;
+		int triangleCount;
+	};
+}
\ No newline at end of file
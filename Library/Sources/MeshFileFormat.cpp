@@ -1,4 +1,6 @@
 #include "MeshFileFormat.h"
+#include "MeshCache.h"
+#include <string.h>
 
 using namespace MeshNinja;
 
@@ -8,4 +10,88 @@ MeshFileFormat::MeshFileFormat()
 
 /*virtual*/ MeshFileFormat::~MeshFileFormat()
 {
+}
+
+/*virtual*/ void MeshFileFormat::GetSavedFilePaths(const std::string& filePath, std::vector<std::string>& filePathArray) const
+{
+	filePathArray.clear();
+	filePathArray.push_back(filePath);
+}
+
+bool MeshFileFormat::SaveMeshCached(const std::string& filePath, const ConvexPolygonMesh& mesh, MeshCache& cache)
+{
+	return this->SaveCached(filePath, MeshCache::Hash(mesh), cache, [this, &filePath, &mesh]() -> bool
+		{
+			return this->SaveMesh(filePath, mesh);
+		});
+}
+
+bool MeshFileFormat::SaveRenderMeshCached(const std::string& filePath, const RenderMesh& mesh, MeshCache& cache)
+{
+	return this->SaveCached(filePath, MeshCache::Hash(mesh), cache, [this, &filePath, &mesh]() -> bool
+		{
+			return this->SaveRenderMesh(filePath, mesh);
+		});
+}
+
+// Files can refer to one another by name, so the names go into the key along with the mesh and format, but the
+// directories they're in don't.  What's cached is the contents of each file written, one after another.
+bool MeshFileFormat::SaveCached(const std::string& filePath, uint64_t meshKey, MeshCache& cache, std::function<bool()> saveFunc)
+{
+	std::vector<std::string> filePathArray;
+	this->GetSavedFilePaths(filePath, filePathArray);
+
+	uint64_t key = MeshCache::Hash(this->GetExtension(), meshKey);
+	for (const std::string& savedFilePath : filePathArray)
+		key = MeshCache::Hash(std::filesystem::path(savedFilePath).filename().string(), key);
+
+	std::string data;
+	if (cache.LoadData(key, data))
+	{
+		size_t offset = 0;
+		bool restored = true;
+
+		for (int i = 0; i < (signed)filePathArray.size() && restored; i++)
+		{
+			uint64_t size = 0;
+			restored = (offset + sizeof(size) <= data.size());
+			if (restored)
+			{
+				::memcpy(&size, data.data() + offset, sizeof(size));
+				offset += sizeof(size);
+				restored = (offset + size <= data.size());
+			}
+
+			if (restored)
+			{
+				std::ofstream fileStream(filePathArray[i], std::ios::out | std::ios::binary | std::ios::trunc);
+				fileStream.write(data.data() + offset, size);
+				restored = fileStream.good();
+				offset += size;
+			}
+		}
+
+		// If what was cached doesn't make sense, just save the mesh the usual way.
+		if (restored)
+			return true;
+	}
+
+	if (!saveFunc())
+		return false;
+
+	data.clear();
+	for (const std::string& savedFilePath : filePathArray)
+	{
+		std::ifstream fileStream(savedFilePath, std::ios::in | std::ios::binary);
+		if (!fileStream.is_open())
+			return true;
+
+		std::string contents((std::istreambuf_iterator<char>(fileStream)), std::istreambuf_iterator<char>());
+		uint64_t size = contents.size();
+		data.append((const char*)&size, sizeof(size));
+		data.append(contents);
+	}
+
+	cache.StoreData(key, data);
+	return true;
 }
\ No newline at end of file
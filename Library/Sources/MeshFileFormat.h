@@ -6,6 +6,7 @@ namespace MeshNinja
 {
 	class ConvexPolygonMesh;
 	class RenderMesh;
+	class MeshCache;
 
 	// For simplicity, we just associate one mesh per file, and we don't try to take
 	// advantage of all features of each file format.  For files containing multiple
@@ -23,5 +24,16 @@ namespace MeshNinja
 
 		virtual bool LoadRenderMesh(const std::string& filePath, RenderMesh& mesh, int meshNumber = 0) = 0;
 		virtual bool SaveRenderMesh(const std::string& filePath, const RenderMesh& mesh) = 0;
+
+		// Saving the very same mesh again under the same name just writes out what was written the last time.
+		bool SaveMeshCached(const std::string& filePath, const ConvexPolygonMesh& mesh, MeshCache& cache);
+		bool SaveRenderMeshCached(const std::string& filePath, const RenderMesh& mesh, MeshCache& cache);
+
+		// These are all the files written when saving to the given path, the given file first.
+		virtual void GetSavedFilePaths(const std::string& filePath, std::vector<std::string>& filePathArray) const;
+
+	protected:
+
+		bool SaveCached(const std::string& filePath, uint64_t meshKey, MeshCache& cache, std::function<bool()> saveFunc);
 	};
 }
\ No newline at end of file
@@ -4,6 +4,9 @@
 #include "Ray.h"
 #include "AlgebraicSurface.h"
 #include "Plane.h"
+#include "MeshClosestPointFinder.h"
+#include "SpatialHash.h"
+#include "TaskScheduler.h"
 #if defined MESH_NINJA_DEBUG
 #	include "MeshFileFormat.h"
 #endif //MESH_NINJA_DEBUG
@@ -20,7 +23,13 @@ MeshFitter::MeshFitter()
 {
 }
 
-bool MeshFitter::GenerateMesh(ConvexPolygonMesh& mesh, const AxisAlignedBoundingBox& aabb, double approximateEdgeLength, const FittableObject& object)
+// The front is the boundary of the mesh generated so far, and it's made of edges waiting to have a facet put on
+// them, taken in the order they were added.  Every edge of the front is kept in lists by its two vertices, so that
+// the edges touching a given edge can be found without looking through the whole front.  Edges are never changed
+// once made, so the ray cast for the flap that might be put on an edge can be done before its turn comes; these
+// are done in batches for the edges at the head of the front, in parallel, and thrown away for any edges that
+// get merged instead.  The mesh generated is the same whatever the number of threads.
+bool MeshFitter::GenerateMesh(ConvexPolygonMesh& mesh, const AxisAlignedBoundingBox& aabb, double approximateEdgeLength, const FittableObject& object, int threadCount /*= 0*/)
 {
 	mesh.Clear();
 
@@ -40,126 +49,258 @@ bool MeshFitter::GenerateMesh(ConvexPolygonMesh& mesh, const AxisAlignedBounding
 
 	tangentDirection.Normalize();
 	ray = Ray(surfacePointA + tangentDirection * approximateEdgeLength, normalDirection);
-	if (!object.RayCast(ray, alpha))
+	if (!CastOntoSurface(ray, alpha, object))
 		return false;
 
 	Vector3 surfacePointB = ray.Lerp(alpha);
 
+	// New vertices are snapped to any existing vertex within half an edge length.
+	SpatialHash vertexHash(approximateEdgeLength / 2.0);
+
 	mesh.vertexArray->push_back(surfacePointA);
 	mesh.vertexArray->push_back(surfacePointB);
+	vertexHash.AddPoint(surfacePointA);
+	vertexHash.AddPoint(surfacePointB);
 
 	struct Edge
 	{
 		int i, j;
+		bool queued;
+		bool prepared;
+		bool flapFound;
+		Vector3 normalVector;
+		Vector3 flapPoint;
+	};
+
+	std::vector<Edge> edgeArray;
+	std::deque<int> edgeQueue;
+	std::vector<std::vector<int>> edgesFromVertex, edgesToVertex;
+
+	auto addEdge = [&edgeArray, &edgeQueue, &edgesFromVertex, &edgesToVertex](int i, int j)
+	{
+		int k = (int)edgeArray.size();
+		edgeArray.push_back(Edge{ i, j, true, false, false, Vector3(0.0, 0.0, 0.0), Vector3(0.0, 0.0, 0.0) });
+		edgeQueue.push_back(k);
+
+		int numVertices = MESH_NINJA_MAX(i, j) + 1;
+		if ((signed)edgesFromVertex.size() < numVertices)
+		{
+			edgesFromVertex.resize(numVertices);
+			edgesToVertex.resize(numVertices);
+		}
+
+		edgesFromVertex[i].push_back(k);
+		edgesToVertex[j].push_back(k);
+	};
+
+	// Edges are only ever added at the end, so the edge listed first for a vertex is the one longest in the front.
+	auto removeEdge = [&edgeArray, &edgesFromVertex, &edgesToVertex](int k)
+	{
+		Edge& edge = edgeArray[k];
+		edge.queued = false;
+
+		std::vector<int>& fromArray = edgesFromVertex[edge.i];
+		fromArray.erase(std::find(fromArray.begin(), fromArray.end(), k));
+
+		std::vector<int>& toArray = edgesToVertex[edge.j];
+		toArray.erase(std::find(toArray.begin(), toArray.end(), k));
+	};
+
+	// This is all the work done on an edge that depends only on the edge itself.  It's done on many
+	// threads at once, so it only reads the mesh, through a const reference.
+	const ConvexPolygonMesh& constMesh = mesh;
+	auto prepareEdge = [&constMesh, &object, approximateEdgeLength](Edge& edge)
+	{
+		const Vector3& vertexA = (*constMesh.vertexArray)[edge.i];
+		const Vector3& vertexB = (*constMesh.vertexArray)[edge.j];
+
+		edge.normalVector = object.CalculateSurfaceNormalAt(vertexA);
+
+		Vector3 edgeVector = vertexB - vertexA;
+		Vector3 tangentVector = edge.normalVector.Cross(edgeVector);
+		double length = approximateEdgeLength * ::sqrt(3.0) / 2.0;
+		Vector3 point = vertexA + (edgeVector / 2.0) + (tangentVector.Normalized() * length);
+		Ray flapRay(point, edge.normalVector);
+
+		double flapAlpha = 0.0;
+		edge.flapFound = CastOntoSurface(flapRay, flapAlpha, object);
+		if (edge.flapFound)
+			edge.flapPoint = flapRay.Lerp(flapAlpha);
+
+		edge.prepared = true;
 	};
 
-	std::list<Edge> edgeQueue;
-	edgeQueue.push_back(Edge{ 0, 1 });
-	edgeQueue.push_back(Edge{ 1, 0 });
+	const int batchSize = 256;
+	std::vector<int> batchArray;
+
+	addEdge(0, 1);
+	addEdge(1, 0);
 
 	while (edgeQueue.size() > 0)
 	{
-		std::list<Edge>::iterator iter = edgeQueue.begin();
-		Edge edge = *iter;
-		edgeQueue.erase(iter);
+		int k = edgeQueue.front();
+		edgeQueue.pop_front();
+
+		if (!edgeArray[k].queued)
+			continue;
+
+		removeEdge(k);
 
-		if (!aabb.ContainsPoint((*mesh.vertexArray)[edge.i]) || !aabb.ContainsPoint((*mesh.vertexArray)[edge.j]))
+		if (!aabb.ContainsPoint((*mesh.vertexArray)[edgeArray[k].i]) || !aabb.ContainsPoint((*mesh.vertexArray)[edgeArray[k].j]))
 			continue;
 
-		std::vector<Edge> newEdgeArray;
+		if (!edgeArray[k].prepared)
+		{
+			batchArray.clear();
+			batchArray.push_back(k);
+
+			for (int l = 0; l < (signed)edgeQueue.size() && (signed)batchArray.size() < batchSize; l++)
+			{
+				const Edge& queuedEdge = edgeArray[edgeQueue[l]];
+				if (queuedEdge.queued && !queuedEdge.prepared && aabb.ContainsPoint((*mesh.vertexArray)[queuedEdge.i]) && aabb.ContainsPoint((*mesh.vertexArray)[queuedEdge.j]))
+					batchArray.push_back(edgeQueue[l]);
+			}
+
+			TaskScheduler::ParallelFor(0, (int)batchArray.size(), 16, [&edgeArray, &batchArray, &prepareEdge](int start, int stop)
+				{
+					for (int l = start; l < stop; l++)
+						prepareEdge(edgeArray[batchArray[l]]);
+				}, threadCount);
+		}
+
+		Edge edge = edgeArray[k];
+
+		std::vector<std::pair<int, int>> newEdgeArray;
 		ConvexPolygonMesh::Facet newFacet;
 
-		Vector3 normalVector = object.CalculateSurfaceNormalAt((*mesh.vertexArray)[edge.i]);
+		Vector3 normalVector = edge.normalVector;
 		Vector3 edgeVector = (*mesh.vertexArray)[edge.j] - (*mesh.vertexArray)[edge.i];
 		Vector3 tangentVector = normalVector.Cross(edgeVector);
 		Plane edgePlane((*mesh.vertexArray)[edge.i], tangentVector);
 
-		// Merge two edges together first if we can.
-		for (iter = edgeQueue.begin(); iter != edgeQueue.end(); iter++)
+		// Merge two edges together first if we can.  Of the edges we could merge with, we take the one longest in the front.
+		int mergeEdge = -1;
+
+		for (int l : edgesToVertex[edge.i])
 		{
-			const Edge& adjacentEdge = *iter;
-			if (adjacentEdge.j == edge.i && adjacentEdge.i != edge.j && edgePlane.WhichSide((*mesh.vertexArray)[adjacentEdge.i]) == Plane::Side::FRONT)
+			const Edge& adjacentEdge = edgeArray[l];
+			if (adjacentEdge.i != edge.j && edgePlane.WhichSide((*mesh.vertexArray)[adjacentEdge.i]) == Plane::Side::FRONT)
 			{
 				Vector3 vectorA = (*mesh.vertexArray)[adjacentEdge.i] - (*mesh.vertexArray)[adjacentEdge.j];
 				Vector3 vectorB = (*mesh.vertexArray)[edge.j] - (*mesh.vertexArray)[edge.i];
 				double angle = vectorA.AngleBetweenThisAnd(vectorB);
 				if (angle < MESH_NINJA_PI / 2.0)
 				{
-					newEdgeArray.push_back(Edge{ adjacentEdge.i, edge.j });
-					newFacet.vertexArray->push_back(adjacentEdge.i);
-					newFacet.vertexArray->push_back(edge.i);
-					newFacet.vertexArray->push_back(edge.j);
-					edgeQueue.erase(iter);
+					mergeEdge = l;
 					break;
 				}
 			}
-			else if (edge.j == adjacentEdge.i && edge.i != adjacentEdge.j && edgePlane.WhichSide((*mesh.vertexArray)[adjacentEdge.j]) == Plane::Side::FRONT)
+		}
+
+		for (int l : edgesFromVertex[edge.j])
+		{
+			if (mergeEdge >= 0 && mergeEdge < l)
+				break;
+
+			const Edge& adjacentEdge = edgeArray[l];
+			if (edge.i != adjacentEdge.j && edgePlane.WhichSide((*mesh.vertexArray)[adjacentEdge.j]) == Plane::Side::FRONT)
 			{
 				Vector3 vectorA = (*mesh.vertexArray)[adjacentEdge.j] - (*mesh.vertexArray)[adjacentEdge.i];
 				Vector3 vectorB = (*mesh.vertexArray)[edge.i] - (*mesh.vertexArray)[edge.j];
 				double angle = vectorA.AngleBetweenThisAnd(vectorB);
 				if (angle < MESH_NINJA_PI / 2.0)
 				{
-					newEdgeArray.push_back(Edge{ edge.i, adjacentEdge.j });
-					newFacet.vertexArray->push_back(adjacentEdge.j);
-					newFacet.vertexArray->push_back(edge.i);
-					newFacet.vertexArray->push_back(edge.j);
-					edgeQueue.erase(iter);
+					mergeEdge = l;
 					break;
 				}
 			}
 		}
 
+		if (mergeEdge >= 0)
+		{
+			const Edge& adjacentEdge = edgeArray[mergeEdge];
+			if (adjacentEdge.j == edge.i)
+			{
+				newEdgeArray.push_back(std::pair<int, int>(adjacentEdge.i, edge.j));
+				newFacet.vertexArray->push_back(adjacentEdge.i);
+				newFacet.vertexArray->push_back(edge.i);
+				newFacet.vertexArray->push_back(edge.j);
+			}
+			else
+			{
+				newEdgeArray.push_back(std::pair<int, int>(edge.i, adjacentEdge.j));
+				newFacet.vertexArray->push_back(adjacentEdge.j);
+				newFacet.vertexArray->push_back(edge.i);
+				newFacet.vertexArray->push_back(edge.j);
+			}
+
+			removeEdge(mergeEdge);
+		}
+
 		// Okay, we should have enough room to create a new flap.
 		if (newFacet.vertexArray->size() == 0)
 		{
-			double length = approximateEdgeLength * ::sqrt(3.0) / 2.0;
-			Vector3 point = (*mesh.vertexArray)[edge.i] + (edgeVector / 2.0) + (tangentVector.Normalized() * length);
-			ray = Ray(point, normalVector);
-			if (!object.RayCast(ray, alpha))
+			if (!edge.flapFound)
 				return false;
 
-			Vector3 surfacePointC = ray.Lerp(alpha);
-			double smallestDistance = 0.0;
-			int i = mesh.FindClosestPointTo(surfacePointC, &smallestDistance);
-			if (i < 0 || smallestDistance > approximateEdgeLength / 2.0)
+			Vector3 surfacePointC = edge.flapPoint;
+			int i = vertexHash.FindPoint(surfacePointC, approximateEdgeLength / 2.0);
+			if (i < 0)
 			{
 				i = mesh.vertexArray->size();
 				mesh.vertexArray->push_back(surfacePointC);
+				vertexHash.AddPoint(surfacePointC);
 			}
 
 			newFacet.vertexArray->push_back(edge.i);
 			newFacet.vertexArray->push_back(edge.j);
 			newFacet.vertexArray->push_back(i);
 
-			newEdgeArray.push_back(Edge{ i, edge.j });
-			newEdgeArray.push_back(Edge{ edge.i, i });
+			newEdgeArray.push_back(std::pair<int, int>(i, edge.j));
+			newEdgeArray.push_back(std::pair<int, int>(edge.i, i));
 		}
 
 		mesh.facetArray->push_back(newFacet);
 
-		for (const Edge& newEdge : newEdgeArray)
+		// A new edge cancels out the edge of the front that's its reverse, if there is one.
+		for (const std::pair<int, int>& newEdge : newEdgeArray)
 		{
-			bool edgeCanceled = false;
-			for (iter = edgeQueue.begin(); iter != edgeQueue.end(); iter++)
+			int canceledEdge = -1;
+			if (newEdge.second < (signed)edgesFromVertex.size())
 			{
-				const Edge& queuedEdge = *iter;
-				if (queuedEdge.i == newEdge.j && queuedEdge.j == newEdge.i)
+				for (int l : edgesFromVertex[newEdge.second])
 				{
-					edgeCanceled = true;
-					edgeQueue.erase(iter);
-					break;
+					if (edgeArray[l].j == newEdge.first)
+					{
+						canceledEdge = l;
+						break;
+					}
 				}
 			}
 
-			if (!edgeCanceled)
-				edgeQueue.push_back(newEdge);
+			if (canceledEdge >= 0)
+				removeEdge(canceledEdge);
+			else
+				addEdge(newEdge.first, newEdge.second);
 		}
 	}
 
 	return true;
 }
 
+// If the surface isn't in front of the ray, we look behind it.  Points put down near the surface are often on the wrong side of it.
+/*static*/ bool MeshFitter::CastOntoSurface(const Ray& ray, double& alpha, const FittableObject& object)
+{
+	if (object.RayCast(ray, alpha))
+		return true;
+
+	if (!object.RayCast(Ray(ray.origin, -ray.direction), alpha))
+		return false;
+
+	alpha = -alpha;
+	return true;
+}
+
 //----------------------------- MeshFitter::FittableObject -----------------------------
 
 MeshFitter::FittableObject::FittableObject()
@@ -202,26 +343,66 @@ MeshFitter::FittableAlgebraicSurface::FittableAlgebraicSurface(const AlgebraicSu
 MeshFitter::FittableMesh::FittableMesh(const ConvexPolygonMesh* mesh)
 {
 	this->mesh = mesh;
+	this->finder = new MeshClosestPointFinder();
+	this->finder->Build(*mesh);
 }
 
 /*virtual*/ MeshFitter::FittableMesh::~FittableMesh()
 {
+	delete this->finder;
 }
 
 /*virtual*/ bool MeshFitter::FittableMesh::RayCast(const Ray& ray, double& alpha, double eps /*= MESH_NINJA_EPS*/) const
 {
-	// TODO: We should cast against a bounding-box-tree here instead for efficiency purposes.
-	return ray.CastAgainst(*this->mesh, alpha, eps);
+	return this->finder->RayCast(ray, alpha, nullptr, eps);
 }
 
+// The given point is usually only close to the surface, so we use the normal where the surface is closest to it.
 /*virtual*/ Vector3 MeshFitter::FittableMesh::CalculateSurfaceNormalAt(const Vector3& surfacePoint) const
 {
-	// TODO: Write this.  Using bounding-box-tree to be more efficient.
-	return Vector3(0.0, 0.0, 0.0);
+	MeshClosestPointFinder::ClosestPoint closestPoint;
+	if (!this->finder->FindClosestPoint(surfacePoint, closestPoint))
+		return Vector3(0.0, 0.0, 0.0);
+
+	return closestPoint.normal;
 }
 
+// We shoot a ray from outside the mesh straight down onto the middle of its biggest facet.  The biggest
+// facet is the one least likely to be missed, or hidden behind some other part of the mesh.
 /*virtual*/ Ray MeshFitter::FittableMesh::CalcInitialContactRay() const
 {
-	// TODO: Write this.  Just shoot a ray at the biggest triangle or something like that?
-	return Ray(Vector3(0.0, 0.0, 0.0), Vector3(0.0, 0.0, 1.0));
+	const std::vector<Vector3>& vertexArray = *this->mesh->vertexArray;
+	if (vertexArray.size() == 0)
+		return Ray(Vector3(0.0, 0.0, 0.0), Vector3(0.0, 0.0, 1.0));
+
+	AxisAlignedBoundingBox aabb(vertexArray[0]);
+	for (const Vector3& vertex : vertexArray)
+		aabb.ExpandToIncludePoint(vertex);
+
+	double largestArea = 0.0;
+	Vector3 center, normal;
+
+	for (const ConvexPolygonMesh::Facet& facet : *this->mesh->facetArray)
+	{
+		Vector3 areaVector;
+		for (int i = 1; i < (signed)facet.vertexArray->size() - 1; i++)
+			areaVector += (vertexArray[facet[i]] - vertexArray[facet[0]]).Cross(vertexArray[facet[i + 1]] - vertexArray[facet[0]]);
+
+		double area = areaVector.Length() / 2.0;
+		if (area > largestArea)
+		{
+			largestArea = area;
+			normal = areaVector.Normalized();
+			center = Vector3(0.0, 0.0, 0.0);
+			for (int i = 0; i < (signed)facet.vertexArray->size(); i++)
+				center += vertexArray[facet[i]];
+			center /= double(facet.vertexArray->size());
+		}
+	}
+
+	if (largestArea == 0.0)
+		return Ray(aabb.Center(), Vector3(0.0, 0.0, 1.0));
+
+	double distance = (aabb.max - aabb.min).Length();
+	return Ray(center + normal * distance, -normal);
 }
\ No newline at end of file
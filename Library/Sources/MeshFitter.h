@@ -8,6 +8,7 @@ namespace MeshNinja
 	class Ray;
 	class AxisAlignedBoundingBox;
 	class AlgebraicSurface;
+	class MeshClosestPointFinder;
 
 	class MESH_NINJA_API MeshFitter
 	{
@@ -16,6 +17,7 @@ namespace MeshNinja
 		virtual ~MeshFitter();
 
 		// We should be able to fit a mesh to an object that inherits and impliments this interface.
+		// These may be called from several threads at once while a mesh is being generated.
 		class MESH_NINJA_API FittableObject
 		{
 		public:
@@ -43,6 +45,8 @@ namespace MeshNinja
 
 		// Fitting a mesh to a mesh is one way to down-res the mesh.  Up-ressing would probably be better
 		// done using polygon subdivision, but down-ressing the mesh is a more difficult problem.
+		// The given mesh mustn't change while this refers to it, because its surface is only looked
+		// at once, when we're constructed.
 		class MESH_NINJA_API FittableMesh : public FittableObject
 		{
 		public:
@@ -54,8 +58,14 @@ namespace MeshNinja
 			virtual Ray CalcInitialContactRay() const override;
 
 			const ConvexPolygonMesh* mesh;
+			MeshClosestPointFinder* finder;
 		};
 
-		bool GenerateMesh(ConvexPolygonMesh& mesh, const AxisAlignedBoundingBox& boundingBox, double approximateEdgeLength, const FittableObject& object);
+		// A thread count of one keeps all calls to the given object on the calling thread.
+		bool GenerateMesh(ConvexPolygonMesh& mesh, const AxisAlignedBoundingBox& boundingBox, double approximateEdgeLength, const FittableObject& object, int threadCount = 0);
+
+	protected:
+
+		static bool CastOntoSurface(const Ray& ray, double& alpha, const FittableObject& object);
 	};
 }
\ No newline at end of file
@@ -0,0 +1,212 @@
+#include "MeshPointClassifier.h"
+#include "ConvexPolygonMesh.h"
+#include "Ray.h"
+#include "TaskScheduler.h"
+
+using namespace MeshNinja;
+
+//----------------------------------- MeshPointClassifier -----------------------------------
+
+MeshPointClassifier::MeshPointClassifier()
+{
+	this->tree = new BoundingBoxTree();
+	this->triangleArray = new std::vector<Triangle*>();
+}
+
+/*virtual*/ MeshPointClassifier::~MeshPointClassifier()
+{
+	this->Clear();
+
+	delete this->tree;
+	delete this->triangleArray;
+}
+
+void MeshPointClassifier::Clear()
+{
+	// Note that the tree owns the triangles.
+	this->tree->Clear();
+	this->triangleArray->clear();
+}
+
+bool MeshPointClassifier::Build(const ConvexPolygonMesh& mesh)
+{
+	this->Clear();
+
+	std::vector<BoundingBoxTree::Object*> objectArray;
+
+	for (const ConvexPolygonMesh::Facet& facet : *mesh.facetArray)
+	{
+		for (int i = 1; i < (signed)facet.vertexArray->size() - 1; i++)
+		{
+			Triangle* triangle = new Triangle(
+				(*mesh.vertexArray)[facet[0]],
+				(*mesh.vertexArray)[facet[i]],
+				(*mesh.vertexArray)[facet[i + 1]]);
+
+			this->triangleArray->push_back(triangle);
+			objectArray.push_back(triangle);
+		}
+	}
+
+	if (objectArray.size() == 0)
+		return false;
+
+	this->tree->Rebuild(objectArray);
+	return true;
+}
+
+bool MeshPointClassifier::IsBuilt() const
+{
+	return this->triangleArray->size() > 0;
+}
+
+int MeshPointClassifier::CountRayCrossings(const Ray& ray) const
+{
+	BoundingBoxTree::TraversalStack stack;
+	return this->CountRayCrossings(ray, stack);
+}
+
+int MeshPointClassifier::CountRayCrossings(const Ray& ray, BoundingBoxTree::TraversalStack& stack) const
+{
+	int count = 0;
+
+	this->tree->ForHitObjects(ray, [&count](BoundingBoxTree::Object* /*object*/, double /*alpha*/) -> bool
+		{
+			count++;
+			return true;
+		}, stack);
+
+	return count;
+}
+
+double MeshPointClassifier::CalcWindingNumber(const Vector3& point) const
+{
+	double totalSolidAngle = 0.0;
+
+	for (const Triangle* triangle : *this->triangleArray)
+		totalSolidAngle += triangle->CalcSolidAngle(point);
+
+	return totalSolidAngle / (4.0 * MESH_NINJA_PI);
+}
+
+MeshPointClassifier::Side MeshPointClassifier::Classify(const Vector3& point, Method method /*= Method::RAY_PARITY*/) const
+{
+	BoundingBoxTree::TraversalStack stack;
+	return this->Classify(point, method, stack);
+}
+
+MeshPointClassifier::Side MeshPointClassifier::Classify(const Vector3& point, Method method, BoundingBoxTree::TraversalStack& stack) const
+{
+	switch (method)
+	{
+		case Method::RAY_PARITY:
+		{
+			// A ray that grazes an edge or vertex of the mesh can count a crossing twice or not at all,
+			// so we cast in a few unrelated directions and let them vote.  None of these are axis-aligned,
+			// because axis-aligned rays are the ones most likely to graze the features of typical meshes.
+			static const Vector3 directionArray[] =
+			{
+				Vector3(0.5773502692, 0.5345224838, 0.6172133998),
+				Vector3(-0.6666666667, 0.2357022604, 0.7071067812),
+				Vector3(0.1825741858, -0.9128709292, 0.3651483717)
+			};
+
+			int insideVotes = 0;
+			for (const Vector3& direction : directionArray)
+			{
+				Ray ray(point, direction);
+				if (this->CountRayCrossings(ray, stack) % 2 == 1)
+					insideVotes++;
+			}
+
+			return (insideVotes >= 2) ? Side::INSIDE : Side::OUTSIDE;
+		}
+		case Method::WINDING_NUMBER:
+		{
+			return (this->CalcWindingNumber(point) > 0.5) ? Side::INSIDE : Side::OUTSIDE;
+		}
+	}
+
+	return Side::OUTSIDE;
+}
+
+void MeshPointClassifier::ClassifyPoints(const std::vector<Vector3>& pointArray, std::vector<Side>& sideArray, Method method /*= Method::RAY_PARITY*/, int threadCount /*= 0*/) const
+{
+	sideArray.resize(pointArray.size());
+
+	// It isn't worth handing out just a handful of points at a time.
+	TaskScheduler::ParallelFor(0, (int)pointArray.size(), 64, [this, &pointArray, &sideArray, method](int start, int stop)
+		{
+			BoundingBoxTree::TraversalStack stack;
+
+			for (int i = start; i < stop; i++)
+				sideArray[i] = this->Classify(pointArray[i], method, stack);
+		}, threadCount);
+}
+
+//----------------------------------- MeshPointClassifier::Triangle -----------------------------------
+
+MeshPointClassifier::Triangle::Triangle(const Vector3& vertexA, const Vector3& vertexB, const Vector3& vertexC)
+{
+	this->vertex[0] = vertexA;
+	this->vertex[1] = vertexB;
+	this->vertex[2] = vertexC;
+
+	this->box = AxisAlignedBoundingBox(vertexA);
+	this->box.ExpandToIncludePoint(vertexB);
+	this->box.ExpandToIncludePoint(vertexC);
+}
+
+/*virtual*/ MeshPointClassifier::Triangle::~Triangle()
+{
+}
+
+/*virtual*/ AxisAlignedBoundingBox MeshPointClassifier::Triangle::GetBoundingBox() const
+{
+	return this->box;
+}
+
+// This is the Moller-Trumbore test.  Unlike Ray::CastAgainst, we don't count a hit at the ray origin,
+// because a point on the surface of the mesh shouldn't register a crossing of that surface.
+/*virtual*/ bool MeshPointClassifier::Triangle::IsHitByRay(const Ray& ray, double& alpha) const
+{
+	Vector3 edgeA = this->vertex[1] - this->vertex[0];
+	Vector3 edgeB = this->vertex[2] - this->vertex[0];
+
+	Vector3 p = ray.direction.Cross(edgeB);
+	double det = edgeA.Dot(p);
+	if (fabs(det) < 1e-12)
+		return false;
+
+	double invDet = 1.0 / det;
+
+	Vector3 t = ray.origin - this->vertex[0];
+	double u = t.Dot(p) * invDet;
+	if (u < 0.0 || u > 1.0)
+		return false;
+
+	Vector3 q = t.Cross(edgeA);
+	double v = ray.direction.Dot(q) * invDet;
+	if (v < 0.0 || u + v > 1.0)
+		return false;
+
+	alpha = edgeB.Dot(q) * invDet;
+	return alpha > 1e-12;
+}
+
+// See "The Solid Angle of a Plane Triangle" by Van Oosterom and Strackee.
+double MeshPointClassifier::Triangle::CalcSolidAngle(const Vector3& point) const
+{
+	Vector3 a = this->vertex[0] - point;
+	Vector3 b = this->vertex[1] - point;
+	Vector3 c = this->vertex[2] - point;
+
+	double lengthA = a.Length();
+	double lengthB = b.Length();
+	double lengthC = c.Length();
+
+	double numerator = a.Dot(b.Cross(c));
+	double denominator = lengthA * lengthB * lengthC + a.Dot(b) * lengthC + b.Dot(c) * lengthA + c.Dot(a) * lengthB;
+
+	return 2.0 * ::atan2(numerator, denominator);
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "Common.h"
+#include "Math/Vector3.h"
+#include "BoundingBoxTree.h"
+
+namespace MeshNinja
+{
+	class ConvexPolygonMesh;
+	class Ray;
+
+	// This answers the question of whether a given point is inside or outside a given closed mesh.
+	// The mesh is triangulated once into a bounding-box tree that persists between queries, so that
+	// many points can be classified against the same mesh cheaply.  All queries are const, and so
+	// may be made from any number of threads at once after the classifier has been built.
+	class MESH_NINJA_API MeshPointClassifier
+	{
+	public:
+		MeshPointClassifier();
+		virtual ~MeshPointClassifier();
+
+		enum class Method
+		{
+			// Count the crossings of a few rays cast from the point and take a majority vote on their parity.
+			// This uses the tree, but is only reliable for water-tight meshes.
+			RAY_PARITY,
+
+			// Sum the solid angles subtended by every triangle.  This is linear in the size of the mesh,
+			// but degrades gracefully for meshes with small holes or overlapping parts.
+			WINDING_NUMBER
+		};
+
+		enum class Side
+		{
+			INSIDE,
+			OUTSIDE
+		};
+
+		void Clear();
+		bool Build(const ConvexPolygonMesh& mesh);
+		bool IsBuilt() const;
+		Side Classify(const Vector3& point, Method method = Method::RAY_PARITY) const;
+		void ClassifyPoints(const std::vector<Vector3>& pointArray, std::vector<Side>& sideArray, Method method = Method::RAY_PARITY, int threadCount = 0) const;
+		int CountRayCrossings(const Ray& ray) const;
+		double CalcWindingNumber(const Vector3& point) const;
+
+	protected:
+
+		Side Classify(const Vector3& point, Method method, BoundingBoxTree::TraversalStack& stack) const;
+		int CountRayCrossings(const Ray& ray, BoundingBoxTree::TraversalStack& stack) const;
+
+		class Triangle : public BoundingBoxTree::Object
+		{
+		public:
+			Triangle(const Vector3& vertexA, const Vector3& vertexB, const Vector3& vertexC);
+			virtual ~Triangle();
+
+			virtual AxisAlignedBoundingBox GetBoundingBox() const override;
+			virtual bool IsHitByRay(const Ray& ray, double& alpha) const override;
+
+			double CalcSolidAngle(const Vector3& point) const;
+
+			Vector3 vertex[3];
+			AxisAlignedBoundingBox box;
+		};
+
+		BoundingBoxTree* tree;
+		std::vector<Triangle*>* triangleArray;
+	};
+}
\ No newline at end of file
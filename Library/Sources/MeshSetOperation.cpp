@@ -1,10 +1,15 @@
 #include "MeshSetOperation.h"
 #include "ConvexPolygonMesh.h"
+#include "PreparedConvexPolygon.h"
+#include "PreparedMesh.h"
 #include "LineSegment.h"
 #include "Plane.h"
 #include "AxisAlignedBoundingBox.h"
 #include "Ray.h"
 #include "BoundingBoxTree.h"
+#include "MeshPointClassifier.h"
+#include "SpatialHash.h"
+#include "TaskScheduler.h"
 #if defined MESH_NINJA_DEBUG
 #	include "FileFormats/ObjFileFormat.h"
 #endif
@@ -15,6 +20,7 @@ using namespace MeshNinja;
 
 MeshSetOperation::MeshSetOperation()
 {
+	this->predicateMode = Predicates::Mode::EPSILON;
 }
 
 /*virtual*/ MeshSetOperation::~MeshSetOperation()
@@ -23,24 +29,65 @@ MeshSetOperation::MeshSetOperation()
 
 bool MeshSetOperation::CalculatePolygonLists(const ConvexPolygonMesh& meshA, const ConvexPolygonMesh& meshB, PolygonLists& polygonLists)
 {
-#if defined MESH_NINJA_DEBUG
-	ObjFileFormat objFileFormat;
-#endif //MESH_NINJA_DEBUG
-
 	std::vector<ConvexPolygon> polygonArrayA, polygonArrayB;
 
 	meshA.ToConvexPolygonArray(polygonArrayA);
 	meshB.ToConvexPolygonArray(polygonArrayB);
 
+	return this->CalculatePolygonLists(polygonArrayA, polygonArrayB, polygonLists, nullptr, nullptr);
+}
+
+// The polygons given here get chopped up where they're cut.  Each side is told which of the other's polygons are inside
+// it by a classifier of the first mesh; if none is given, one is built for the side's cut-mesh.  A given classifier
+// lets one side be just the part of some larger mesh that's near the other side.  The planes of the first side's
+// polygons can be given too, if they're already known.
+bool MeshSetOperation::CalculatePolygonLists(std::vector<ConvexPolygon>& polygonArrayA, std::vector<ConvexPolygon>& polygonArrayB, PolygonLists& polygonLists, const MeshPointClassifier* classifierA, const MeshPointClassifier* classifierB, const std::vector<Plane>* planeArrayA /*= nullptr*/)
+{
+	Predicates::ModeScope modeScope(this->predicateMode);
+
+#if defined MESH_NINJA_DEBUG
+	ObjFileFormat objFileFormat;
+#endif //MESH_NINJA_DEBUG
+
 	PolylineCollection polylineCollection;
 
-	// Note that for large meshes, this O(N^2) algorithm could be reduced to
-	// O(N log N) if here we used a spatial partitioning data-structure.
+	// Only polygons whose boxes overlap can intersect, so rather than test every pair of polygons,
+	// we put the polygons of one mesh in a bounding-box tree and look up each polygon of the other in it.
+	std::vector<BoundingBoxTree::Object*> objectArray;
+	for (int i = 0; i < (signed)polygonArrayB.size(); i++)
+	{
+		AxisAlignedBoundingBox box;
+		polygonArrayB[i].CalcBox(box);
+		objectArray.push_back(new BoundingBoxTree::IndexedObject(i, box));
+	}
+
+	BoundingBoxTree tree;
+	tree.Rebuild(objectArray);
+
+	Vector3 margin(2.0 * MESH_NINJA_EPS, 2.0 * MESH_NINJA_EPS, 2.0 * MESH_NINJA_EPS);
+	std::vector<int> candidateArray;
 
 	for (const ConvexPolygon& polygonA : polygonArrayA)
 	{
-		for (const ConvexPolygon& polygonB : polygonArrayB)
+		AxisAlignedBoundingBox box;
+		polygonA.CalcBox(box);
+		box.min -= margin;
+		box.max += margin;
+
+		candidateArray.clear();
+		tree.ForOverlappingObjects(box, [&candidateArray](BoundingBoxTree::Object* object) -> bool
+			{
+				candidateArray.push_back(((BoundingBoxTree::IndexedObject*)object)->index);
+				return true;
+			});
+
+		// Keep the pairs in their original order so that the cuts come out the same as they would without the tree.
+		std::sort(candidateArray.begin(), candidateArray.end());
+
+		for (int i : candidateArray)
 		{
+			const ConvexPolygon& polygonB = polygonArrayB[i];
+
 			ConvexPolygon intersection;
 			if (intersection.Intersect(polygonA, polygonB))
 			{
@@ -68,20 +115,18 @@ bool MeshSetOperation::CalculatePolygonLists(const ConvexPolygonMesh& meshA, con
 				}
 				else if (intersection.vertexArray->size() == 2)
 				{
-					Polyline polyline((*intersection.vertexArray)[0], (*intersection.vertexArray)[1]);
-					polylineCollection.AddPolyline(polyline);
+					polylineCollection.AddSegment((*intersection.vertexArray)[0], (*intersection.vertexArray)[1]);
 				}
 			}
 		}
 	}
 
-	for (const Polyline& polyline : polylineCollection.polylineList)
+	if (!polylineCollection.Stitch())
 	{
-		if (!polyline.IsLineLoop())
-		{
-			*this->error = "Did not find all line-loop cuts between the two given meshes.";
-			return false;
-		}
+		std::string description;
+		polylineCollection.DescribeOpenChains(description);
+		*this->error = "Did not find all line-loop cuts between the two given meshes.  " + description;
+		return false;
 	}
 
 #if defined MESH_NINJA_DEBUG
@@ -106,7 +151,7 @@ bool MeshSetOperation::CalculatePolygonLists(const ConvexPolygonMesh& meshA, con
 		}
 	}
 
-	this->ChopupPolygonArray(polygonArrayA, lineSegmentArray);
+	this->ChopupPolygonArray(polygonArrayA, lineSegmentArray, planeArrayA);
 	this->ChopupPolygonArray(polygonArrayB, lineSegmentArray);
 
 	ConvexPolygonMesh cutMeshA, cutMeshB;
@@ -139,18 +184,6 @@ bool MeshSetOperation::CalculatePolygonLists(const ConvexPolygonMesh& meshA, con
 	graphA.Generate(cutMeshA);
 	graphB.Generate(cutMeshB);
 
-	if (!graphA.ColorEdges(lineSegmentArray))
-	{
-		*this->error = "Failed to color edges of graph A.";
-		return false;
-	}
-
-	if (!graphB.ColorEdges(lineSegmentArray))
-	{
-		*this->error = "Failed to color edges of graph B.";
-		return false;
-	}
-	
 #if defined MESH_NINJA_DEBUG
 	DebugDraw graphDebugDrawA;
 	DebugDraw graphDebugDrawB;
@@ -162,13 +195,27 @@ bool MeshSetOperation::CalculatePolygonLists(const ConvexPolygonMesh& meshA, con
 	graphDebugDrawB.Save("Meshes/GraphDebugDrawB.json");
 #endif //MESH_NINJA_DEBUG
 
-	if (!graphA.ColorNodes(&graphB))
+	MeshPointClassifier cutClassifierA, cutClassifierB;
+
+	if (!classifierB)
+	{
+		cutClassifierB.Build(cutMeshB);
+		classifierB = &cutClassifierB;
+	}
+
+	if (!graphA.ColorNodes(*classifierB))
 	{
 		*this->error = "Failed to color nodes of graph A.";
 		return false;
 	}
 
-	if (!graphB.ColorNodes(&graphA))
+	if (!classifierA)
+	{
+		cutClassifierA.Build(cutMeshA);
+		classifierA = &cutClassifierA;
+	}
+
+	if (!graphB.ColorNodes(*classifierA))
 	{
 		*this->error = "Failed to color nodes of graph B.";
 		return false;
@@ -180,99 +227,179 @@ bool MeshSetOperation::CalculatePolygonLists(const ConvexPolygonMesh& meshA, con
 	return true;
 }
 
-void MeshSetOperation::ChopupPolygonArray(std::vector<ConvexPolygon>& polygonArray, const std::vector<LineSegment>& lineSegmentArray)
+// Rather than test every cut segment against every polygon, we put the segments in a bounding-box
+// tree and give each polygon only those segments that overlap its box and lie in its plane.  When a
+// polygon gets split, its halves inherit what remains of that list, filtered again by their own boxes.
+// A polygon's halves also share its plane, so we only ever calculate that once per input polygon, and not at
+// all if the planes are given.
+void MeshSetOperation::ChopupPolygonArray(std::vector<ConvexPolygon>& polygonArray, const std::vector<LineSegment>& lineSegmentArray, const std::vector<Plane>* planeArray /*= nullptr*/)
 {
-	std::list<ConvexPolygon> polygonQueue;
-	for (const ConvexPolygon& polygon : polygonArray)
-		polygonQueue.push_back(polygon);
+	std::vector<AxisAlignedBoundingBox> segmentBoxArray;
+	std::vector<BoundingBoxTree::Object*> objectArray;
+
+	for (int i = 0; i < (signed)lineSegmentArray.size(); i++)
+	{
+		const LineSegment& lineSegment = lineSegmentArray[i];
+
+		AxisAlignedBoundingBox box(lineSegment.vertexA);
+		box.ExpandToIncludePoint(lineSegment.vertexB);
+		box.min -= Vector3(MESH_NINJA_EPS, MESH_NINJA_EPS, MESH_NINJA_EPS);
+		box.max += Vector3(MESH_NINJA_EPS, MESH_NINJA_EPS, MESH_NINJA_EPS);
+
+		segmentBoxArray.push_back(box);
+		objectArray.push_back(new BoundingBoxTree::IndexedObject(i, box));
+	}
+
+	BoundingBoxTree tree;
+	tree.Rebuild(objectArray);
+
+	struct Task
+	{
+		Task(const ConvexPolygon& polygon, const Plane& plane) : polygon(polygon), plane(plane)
+		{
+		}
+
+		ConvexPolygon polygon;
+		Plane plane;
+		std::vector<int> candidateArray;
+	};
+
+	std::list<Task> taskQueue;
+
+	for (int i = 0; i < (signed)polygonArray.size(); i++)
+	{
+		const ConvexPolygon& polygon = polygonArray[i];
+
+		taskQueue.push_back(Task(polygon, Plane()));
+		Task& task = taskQueue.back();
+
+		if (planeArray)
+			task.plane = (*planeArray)[i];
+		else
+			polygon.CalcPlane(task.plane);
+
+		AxisAlignedBoundingBox box;
+		polygon.CalcBox(box);
+
+		tree.ForOverlappingObjects(box, [&task, &lineSegmentArray](BoundingBoxTree::Object* object) -> bool
+			{
+				const LineSegment& lineSegment = lineSegmentArray[((BoundingBoxTree::IndexedObject*)object)->index];
+
+				if (task.plane.WhichSide(lineSegment.vertexA) == Plane::Side::NEITHER &&
+					task.plane.WhichSide(lineSegment.vertexB) == Plane::Side::NEITHER)
+				{
+					task.candidateArray.push_back(((BoundingBoxTree::IndexedObject*)object)->index);
+				}
+
+				return true;
+			});
+
+		// Keep the segments in their original order so that the chopping comes out the same as it would without the tree.
+		std::sort(task.candidateArray.begin(), task.candidateArray.end());
+	}
 
 	polygonArray.clear();
 
-	while (polygonQueue.size() > 0)
+	while (taskQueue.size() > 0)
 	{
-		std::list<ConvexPolygon>::iterator iter = polygonQueue.begin();
-		ConvexPolygon polygon = *iter;
-		polygonQueue.erase(iter);
+		std::list<Task>::iterator iter = taskQueue.begin();
+		const Task& task = *iter;
 
 		ConvexPolygon polygonA, polygonB;
-		if (!this->ChopupPolygon(polygon, polygonA, polygonB, lineSegmentArray))
-			polygonArray.push_back(polygon);
+		int splitIndex = -1;
+		if (!this->ChopupPolygon(task.polygon, task.plane, polygonA, polygonB, lineSegmentArray, task.candidateArray, splitIndex))
+			polygonArray.push_back(task.polygon);
 		else
 		{
-			polygonQueue.push_back(polygonA);
-			polygonQueue.push_back(polygonB);
+			// The segment we split along now lies on the boundary of both halves, so it can't split either of them again.
+			for (const ConvexPolygon* childPolygon : { &polygonA, &polygonB })
+			{
+				taskQueue.push_back(Task(*childPolygon, task.plane));
+				Task& childTask = taskQueue.back();
+
+				AxisAlignedBoundingBox box;
+				childPolygon->CalcBox(box);
+
+				for (int i = splitIndex + 1; i < (signed)task.candidateArray.size(); i++)
+				{
+					int j = task.candidateArray[i];
+					if (box.OverlapsWith(segmentBoxArray[j]))
+						childTask.candidateArray.push_back(j);
+				}
+			}
 		}
+
+		taskQueue.erase(iter);
 	}
 }
 
-bool MeshSetOperation::ChopupPolygon(const ConvexPolygon& polygon, ConvexPolygon& polygonA, ConvexPolygon& polygonB, const std::vector<LineSegment>& lineSegmentArray)
+bool MeshSetOperation::ChopupPolygon(const ConvexPolygon& polygon, const Plane& plane, ConvexPolygon& polygonA, ConvexPolygon& polygonB, const std::vector<LineSegment>& lineSegmentArray, const std::vector<int>& candidateArray, int& splitIndex)
 {
-	for (const LineSegment& lineSegment : lineSegmentArray)
+	// The same polygon is tested against every candidate, so work out what those tests need just once.
+	PreparedConvexPolygon preparedPolygon(polygon);
+
+	for (int i = 0; i < (signed)candidateArray.size(); i++)
 	{
-		Plane plane;
-		polygon.CalcPlane(plane);
+		const LineSegment& lineSegment = lineSegmentArray[candidateArray[i]];
 
-		if (plane.WhichSide(lineSegment.vertexA) == Plane::Side::NEITHER &&
-			plane.WhichSide(lineSegment.vertexB) == Plane::Side::NEITHER)
-		{
-			bool performSplit = false;
-			bool isInteriorPoint = false;
+		bool performSplit = false;
+		bool isInteriorPoint = false;
 
-			if ((polygon.ContainsPoint(lineSegment.vertexA, &isInteriorPoint) && isInteriorPoint) ||
-				(polygon.ContainsPoint(lineSegment.vertexB, &isInteriorPoint) && isInteriorPoint))
-			{
-				performSplit = true;
-			}
+		if ((preparedPolygon.ContainsPoint(lineSegment.vertexA, &isInteriorPoint) && isInteriorPoint) ||
+			(preparedPolygon.ContainsPoint(lineSegment.vertexB, &isInteriorPoint) && isInteriorPoint))
+		{
+			performSplit = true;
+		}
 
-			if (!performSplit)
-			{
-				Ray rayA(lineSegment.vertexA, lineSegment.vertexB - lineSegment.vertexA);
-				Ray rayB(lineSegment.vertexB, lineSegment.vertexA - lineSegment.vertexB);
+		if (!performSplit)
+		{
+			Ray rayA(lineSegment.vertexA, lineSegment.vertexB - lineSegment.vertexA);
+			Ray rayB(lineSegment.vertexB, lineSegment.vertexA - lineSegment.vertexB);
 
-				double alpha = 0.0, beta = 0.0;
+			double alpha = 0.0, beta = 0.0;
 
-				if (rayA.CastAgainst(polygon, alpha) && 0.0 <= alpha && alpha <= 1.0 &&
-					rayB.CastAgainst(polygon, beta) && 0.0 <= beta && beta <= 1.0)
-				{
-					Vector3 hitPointA = rayA.Lerp(alpha);
-					Vector3 hitPointB = rayB.Lerp(beta);
-					Vector3 point = (hitPointA + hitPointB) / 2.0;
-					
-					if (polygon.ContainsPoint(point, &isInteriorPoint) && isInteriorPoint)
-						performSplit = true;
-				}
+			if (rayA.CastAgainst(preparedPolygon, alpha) && 0.0 <= alpha && alpha <= 1.0 &&
+				rayB.CastAgainst(preparedPolygon, beta) && 0.0 <= beta && beta <= 1.0)
+			{
+				Vector3 hitPointA = rayA.Lerp(alpha);
+				Vector3 hitPointB = rayB.Lerp(beta);
+				Vector3 point = (hitPointA + hitPointB) / 2.0;
+				
+				if (preparedPolygon.ContainsPoint(point, &isInteriorPoint) && isInteriorPoint)
+					performSplit = true;
 			}
+		}
 
-			if (performSplit)
+		if (performSplit)
+		{
+			Vector3 normal = (lineSegment.vertexB - lineSegment.vertexA).Cross(plane.normal);
+			Plane cuttingPlane(lineSegment.vertexA, normal);
+			if (polygon.SplitAgainst(cuttingPlane, polygonA, polygonB))
 			{
-				Vector3 normal = (lineSegment.vertexB - lineSegment.vertexA).Cross(plane.normal);
-				Plane cuttingPlane(lineSegment.vertexA, normal);
-				if (polygon.SplitAgainst(cuttingPlane, polygonA, polygonB))
-				{
-					polygonA.Compress();
-					polygonB.Compress();
+				polygonA.Compress();
+				polygonB.Compress();
 
-					if (polygonA.vertexArray->size() < 3 || polygonB.vertexArray->size() < 3)
-					{
+				if (polygonA.vertexArray->size() < 3 || polygonB.vertexArray->size() < 3)
+				{
 #if defined MESH_NINJA_DEBUG
-						std::vector<ConvexPolygon> polygonArray;
-						polygonArray.push_back(polygon);
-						ConvexPolygonMesh mesh;
-						mesh.FromConvexPolygonArray(polygonArray);
-						ObjFileFormat objFileFormat;
-						objFileFormat.SaveMesh("Meshes/DebugMeshA.obj", mesh);
-						Polyline polyline;
-						polyline.vertexArray->push_back(lineSegment.vertexA);
-						polyline.vertexArray->push_back(lineSegment.vertexB);
-						polyline.GenerateTubeMesh(mesh, 0.1, 5);
-						objFileFormat.SaveMesh("Meshes/DebugMeshB.obj", mesh);
+					std::vector<ConvexPolygon> polygonArray;
+					polygonArray.push_back(polygon);
+					ConvexPolygonMesh mesh;
+					mesh.FromConvexPolygonArray(polygonArray);
+					ObjFileFormat objFileFormat;
+					objFileFormat.SaveMesh("Meshes/DebugMeshA.obj", mesh);
+					Polyline polyline;
+					polyline.vertexArray->push_back(lineSegment.vertexA);
+					polyline.vertexArray->push_back(lineSegment.vertexB);
+					polyline.GenerateTubeMesh(mesh, 0.1, 5);
+					objFileFormat.SaveMesh("Meshes/DebugMeshB.obj", mesh);
 #endif //MESH_NINJA_DEBUG
 
-						return false;
-					}
-
-					return true;
+					return false;
 				}
+
+				splitIndex = i;
+				return true;
 			}
 		}
 	}
@@ -280,310 +407,681 @@ bool MeshSetOperation::ChopupPolygon(const ConvexPolygon& polygon, ConvexPolygon
 	return false;
 }
 
-//----------------------------------- MeshSetOperation::PolylineCollection -----------------------------------
-
-MeshSetOperation::PolylineCollection::PolylineCollection()
+bool MeshSetOperation::PerformPrepared(const PreparedMesh& preparedMeshA, const ConvexPolygonMesh& meshB, ConvexPolygonMesh& resultingMesh)
 {
-}
-
-/*virtual*/ MeshSetOperation::PolylineCollection::~PolylineCollection()
-{
-}
+	if (!preparedMeshA.IsPrepared())
+	{
+		*this->error = "The first mesh has not been prepared.";
+		return false;
+	}
 
-void MeshSetOperation::PolylineCollection::AddPolyline(const Polyline& givenPolyline)
-{
-	std::list<Polyline> polylineQueue;
-	polylineQueue.push_back(givenPolyline);
+	const ConvexPolygonMesh& meshA = preparedMeshA.GetMesh();
 
-	while (polylineQueue.size() > 0)
+	// A facet whose box is clear of the other mesh's box can't be cut by that mesh, and must be outside of it.
+	std::vector<int> nearFacetArray;
+	AxisAlignedBoundingBox boxB;
+	if (CalcBoundingBox(meshB, boxB))
 	{
-		std::list<Polyline>::iterator iter = polylineQueue.begin();
-		Polyline polyline = *iter;
-		polylineQueue.erase(iter);
+		Vector3 margin(2.0 * MESH_NINJA_EPS, 2.0 * MESH_NINJA_EPS, 2.0 * MESH_NINJA_EPS);
+		boxB.min -= margin;
+		boxB.max += margin;
 
-		bool mergeHappened = false;
-		for (iter = this->polylineList.begin(); iter != this->polylineList.end(); iter++)
-		{
-			const Polyline& existingPolyline = *iter;
-			Polyline mergedPolyline;
-			if (mergedPolyline.Merge(polyline, existingPolyline))
-			{
-				this->polylineList.erase(iter);
-				polylineQueue.push_back(mergedPolyline);
-				mergeHappened = true;
-				break;
-			}
-		}
+		preparedMeshA.FindFacetsOverlapping(boxB, nearFacetArray);
 
-		if (!mergeHappened)
-			this->polylineList.push_back(polyline);
+		// Cutting a facet can put new vertices on any of its edges, and the facets on the other side of those
+		// edges have to be given the same vertices, so those go through the operation too.
+		preparedMeshA.AddNeighboringFacets(nearFacetArray);
 	}
-}
 
-//----------------------------------- MeshSetOperation::Node -----------------------------------
+	std::vector<ConvexPolygon> polygonArrayA, polygonArrayB;
+	std::vector<Plane> planeArrayA;
 
-MeshSetOperation::Node::Node()
-{
-	this->side = Side::UNKNOWN;
-}
+	for (int i : nearFacetArray)
+	{
+		ConvexPolygon polygon;
+		(*meshA.facetArray)[i].MakePolygon(polygon, &meshA);
+		polygonArrayA.push_back(polygon);
+		planeArrayA.push_back(preparedMeshA.GetFacetPlane(i));
+	}
 
-/*virtual*/ MeshSetOperation::Node::~Node()
-{
-}
+	meshB.ToConvexPolygonArray(polygonArrayB);
 
-/*virtual*/ Vector3 MeshSetOperation::Node::GetDebugColor() const
-{
-	switch (this->side)
+	PolygonLists polygonLists;
+	if (!this->CalculatePolygonLists(polygonArrayA, polygonArrayB, polygonLists, &preparedMeshA.GetClassifier(), nullptr, &planeArrayA))
+		return false;
+
+	std::vector<ConvexPolygon> polygonArray;
+	this->SelectPolygons(polygonLists, polygonArray);
+
+	resultingMesh.Clear();
+
+	std::vector<int> vertexMap(meshA.vertexArray->size(), -1);
+	auto mapVertex = [&meshA, &resultingMesh, &vertexMap](int i) -> int
 	{
-		case Side::INSIDE:
+		if (vertexMap[i] < 0)
 		{
-			return Vector3(1.0, 0.0, 0.0);
+			vertexMap[i] = (int)resultingMesh.vertexArray->size();
+			resultingMesh.vertexArray->push_back((*meshA.vertexArray)[i]);
 		}
-		case Side::OUTSIDE:
+
+		return vertexMap[i];
+	};
+
+	if (this->KeepsOutsideOfA())
+	{
+		std::vector<bool> isNearArray(meshA.facetArray->size(), false);
+		for (int i : nearFacetArray)
+			isNearArray[i] = true;
+
+		resultingMesh.facetArray->reserve(meshA.facetArray->size() - nearFacetArray.size() + polygonArray.size());
+
+		for (int i = 0; i < (signed)meshA.facetArray->size(); i++)
 		{
-			return Vector3(0.0, 0.0, 1.0);
+			if (isNearArray[i])
+				continue;
+
+			const ConvexPolygonMesh::Facet& facet = (*meshA.facetArray)[i];
+
+			resultingMesh.facetArray->push_back(ConvexPolygonMesh::Facet());
+			ConvexPolygonMesh::Facet& newFacet = resultingMesh.facetArray->back();
+
+			for (int j = 0; j < (signed)facet.vertexArray->size(); j++)
+				newFacet.vertexArray->push_back(mapVertex(facet[j]));
 		}
 	}
 
-	return Vector3(0.5, 0.5, 0.5);
-}
+	// Where the polygons near the other mesh meet the facets copied over, they have to share vertices.  Points are
+	// welded here just as ConvexPolygonMesh::FromConvexPolygonArray would weld them.
+	std::map<Vector3, int> nearVertexMap;
+	for (int i : nearFacetArray)
+	{
+		const ConvexPolygonMesh::Facet& facet = (*meshA.facetArray)[i];
+		for (int j = 0; j < (signed)facet.vertexArray->size(); j++)
+			nearVertexMap.insert(std::pair<Vector3, int>((*meshA.vertexArray)[facet[j]], facet[j]));
+	}
 
-//----------------------------------- MeshSetOperation::Edge -----------------------------------
+	std::map<Vector3, int> pointMap;
 
-MeshSetOperation::Edge::Edge()
-{
-	this->type = Type::UNKNOWN;
-}
+	for (const ConvexPolygon& polygon : polygonArray)
+	{
+		resultingMesh.facetArray->push_back(ConvexPolygonMesh::Facet());
+		ConvexPolygonMesh::Facet& newFacet = resultingMesh.facetArray->back();
 
-/*virtual*/ MeshSetOperation::Edge::~Edge()
-{
+		for (const Vector3& vertex : *polygon.vertexArray)
+		{
+			std::map<Vector3, int>::iterator iter = nearVertexMap.find(vertex);
+			if (iter != nearVertexMap.end())
+			{
+				newFacet.vertexArray->push_back(mapVertex(iter->second));
+				continue;
+			}
+
+			iter = pointMap.find(vertex);
+			if (iter == pointMap.end())
+			{
+				iter = pointMap.insert(std::pair<Vector3, int>(vertex, (int)resultingMesh.vertexArray->size())).first;
+				resultingMesh.vertexArray->push_back(vertex);
+			}
+
+			newFacet.vertexArray->push_back(iter->second);
+		}
+	}
+
+	return true;
 }
 
-/*virtual*/ Vector3 MeshSetOperation::Edge::GetDebugColor() const
+/*virtual*/ bool MeshSetOperation::PerformMany(const std::vector<const ConvexPolygonMesh*>& meshArray, ConvexPolygonMesh& resultingMesh, int threadCount /*= 0*/)
 {
-	switch (this->type)
+	int numMeshes = (signed)meshArray.size();
+
+	std::vector<AxisAlignedBoundingBox> boxArray(numMeshes);
+	for (int i = 0; i < numMeshes; i++)
+		CalcBoundingBox(*meshArray[i], boxArray[i]);
+
+	std::vector<std::vector<int>> overlapArray;
+	FindOverlaps(boxArray, overlapArray);
+
+	std::vector<std::vector<int>> clusterArray;
+	FindClusters(overlapArray, clusterArray);
+
+	// Within each cluster, the meshes are colored so that no two meshes of the same color overlap, which
+	// means the meshes of each color can be put together as disjoint meshes are.  What's left of the cluster
+	// is then one operand for each color.  The coloring is done by always taking next the mesh overlapping
+	// the most colors already, which finds the fewest colors for the common case of meshes that fall into
+	// two sets of mutually disjoint meshes, such as the rooms and corridors of a maze.
+	std::vector<std::vector<const ConvexPolygonMesh*>> layerArray;
+	std::vector<int> layerClusterArray;
+	std::vector<int> colorArray(numMeshes, -1);
+	std::vector<std::set<int>> neighborColorSetArray(numMeshes);
+
+	for (int i = 0; i < (signed)clusterArray.size(); i++)
 	{
-		case Type::NORMAL:
+		std::vector<int>& cluster = clusterArray[i];
+		OrderSpatially(boxArray, cluster, 0, (signed)cluster.size());
+
+		int firstLayer = (signed)layerArray.size();
+
+		for (int count = 0; count < (signed)cluster.size(); count++)
 		{
-			return Vector3(0.0, 1.0, 0.0);
+			int j = -1;
+			for (int k : cluster)
+			{
+				if (colorArray[k] >= 0)
+					continue;
+
+				if (j < 0 || neighborColorSetArray[k].size() > neighborColorSetArray[j].size() ||
+					(neighborColorSetArray[k].size() == neighborColorSetArray[j].size() && overlapArray[k].size() > overlapArray[j].size()))
+				{
+					j = k;
+				}
+			}
+
+			int color = 0;
+			while (neighborColorSetArray[j].find(color) != neighborColorSetArray[j].end())
+				color++;
+
+			colorArray[j] = color;
+			for (int k : overlapArray[j])
+				neighborColorSetArray[k].insert(color);
+
+			if (firstLayer + color >= (signed)layerArray.size())
+			{
+				layerArray.resize(firstLayer + color + 1);
+				layerClusterArray.resize(firstLayer + color + 1, i);
+			}
 		}
-		case Type::CUT_BOUNDARY:
+
+		// Each layer lists its meshes in the spatial order of the cluster.
+		for (int j : cluster)
+			layerArray[firstLayer + colorArray[j]].push_back(meshArray[j]);
+	}
+
+	std::vector<ConvexPolygonMesh*> ownedMeshArray;
+	std::vector<std::vector<const ConvexPolygonMesh*>> clusterMeshArray(clusterArray.size());
+
+	for (int i = 0; i < (signed)layerArray.size(); i++)
+	{
+		if (layerArray[i].size() == 1)
+			clusterMeshArray[layerClusterArray[i]].push_back(layerArray[i][0]);
+		else
 		{
-			return Vector3(1.0, 0.0, 0.0);
+			ConvexPolygonMesh* layerMesh = new ConvexPolygonMesh();
+			ownedMeshArray.push_back(layerMesh);
+			this->CombineDisjoint(layerArray[i], *layerMesh);
+			clusterMeshArray[layerClusterArray[i]].push_back(layerMesh);
 		}
 	}
 
-	return Vector3(0.5, 0.5, 0.5);
-}
+	bool success = this->Reduce(clusterMeshArray, ownedMeshArray, threadCount);
 
-//----------------------------------- MeshSetOperation::Graph -----------------------------------
+	// Nothing from one cluster touches anything from another, so what's left is just to put the clusters together.
+	if (success)
+	{
+		std::vector<const ConvexPolygonMesh*> finalMeshArray;
+		for (const std::vector<const ConvexPolygonMesh*>& clusterMesh : clusterMeshArray)
+			finalMeshArray.push_back(clusterMesh[0]);
+
+		if (finalMeshArray.size() == 0)
+			resultingMesh.Clear();
+		else if (finalMeshArray.size() == 1)
+			resultingMesh.Copy(*finalMeshArray[0]);
+		else
+			this->CombineDisjoint(finalMeshArray, resultingMesh);
+	}
 
-MeshSetOperation::Graph::Graph()
-{
+	for (ConvexPolygonMesh* mesh : ownedMeshArray)
+		delete mesh;
+
+	return success;
 }
 
-/*virtual*/ MeshSetOperation::Graph::~Graph()
+bool MeshSetOperation::PerformIfOverlapping(const ConvexPolygonMesh& meshA, const ConvexPolygonMesh& meshB, ConvexPolygonMesh& resultingMesh)
 {
+	AxisAlignedBoundingBox boxA, boxB;
+	if (!CalcBoundingBox(meshA, boxA) || !CalcBoundingBox(meshB, boxB) || !boxA.OverlapsWith(boxB))
+	{
+		this->CombineDisjoint({ &meshA, &meshB }, resultingMesh);
+		return true;
+	}
+
+	return this->Perform(meshA, meshB, resultingMesh);
 }
 
-/*virtual*/ MeshGraph::Node* MeshSetOperation::Graph::CreateNode()
+// The meshes of each group are combined in pairs, then the results of that in pairs, and so on, until each group is
+// down to one mesh.  This way no polygon goes through more than logarithmically many operations, and all the pairs
+// of a round, from all groups, can be worked on at the same time.  Neighbouring meshes of a group are paired first,
+// so each group should be given in a spatially coherent order.  The meshes made along the way are left to the caller.
+bool MeshSetOperation::Reduce(std::vector<std::vector<const ConvexPolygonMesh*>>& groupArray, std::vector<ConvexPolygonMesh*>& ownedMeshArray, int threadCount)
 {
-	return new MeshSetOperation::Node();
+	struct Pair
+	{
+		const ConvexPolygonMesh* meshA;
+		const ConvexPolygonMesh* meshB;
+		ConvexPolygonMesh* resultingMesh;
+	};
+
+	std::atomic<bool> failed = false;
+
+	while (!failed)
+	{
+		std::vector<Pair> pairArray;
+
+		for (std::vector<const ConvexPolygonMesh*>& group : groupArray)
+		{
+			if (group.size() <= 1)
+				continue;
+
+			std::vector<const ConvexPolygonMesh*> nextGroup;
+
+			for (int i = 0; i + 1 < (signed)group.size(); i += 2)
+			{
+				ConvexPolygonMesh* pairMesh = new ConvexPolygonMesh();
+				ownedMeshArray.push_back(pairMesh);
+				pairArray.push_back(Pair{ group[i], group[i + 1], pairMesh });
+				nextGroup.push_back(pairMesh);
+			}
+
+			if (group.size() % 2 == 1)
+				nextGroup.push_back(group.back());
+
+			group = nextGroup;
+		}
+
+		int numPairs = (signed)pairArray.size();
+		if (numPairs == 0)
+			break;
+
+		std::mutex errorMutex;
+
+		// Each pair gets an operation of its own, since an operation holds onto its error.
+		TaskScheduler::ParallelFor(0, numPairs, 1, [this, &pairArray, &failed, &errorMutex](int start, int stop)
+			{
+				for (int i = start; i < stop && !failed; i++)
+				{
+					const Pair& pair = pairArray[i];
+
+					MeshSetOperation* operation = this->CreateOperation();
+					operation->predicateMode = this->predicateMode;
+
+					if (!operation->PerformIfOverlapping(*pair.meshA, *pair.meshB, *pair.resultingMesh))
+					{
+						std::lock_guard<std::mutex> lock(errorMutex);
+						if (!failed)
+						{
+							failed = true;
+							*this->error = *operation->error;
+						}
+					}
+
+					delete operation;
+				}
+			}, threadCount);
+	}
+
+	return !failed;
 }
 
-/*virtual*/ MeshGraph::Edge* MeshSetOperation::Graph::CreateEdge()
+// An empty mesh gets a box that contains nothing and overlaps nothing.
+/*static*/ bool MeshSetOperation::CalcBoundingBox(const ConvexPolygonMesh& mesh, AxisAlignedBoundingBox& boundingBox)
 {
-	return new MeshSetOperation::Edge();
+	if (mesh.vertexArray->size() == 0)
+	{
+		boundingBox.min = Vector3(DBL_MAX, DBL_MAX, DBL_MAX);
+		boundingBox.max = Vector3(-DBL_MAX, -DBL_MAX, -DBL_MAX);
+		return false;
+	}
+
+	boundingBox = AxisAlignedBoundingBox((*mesh.vertexArray)[0]);
+	for (const Vector3& vertex : *mesh.vertexArray)
+		boundingBox.ExpandToIncludePoint(vertex);
+
+	return true;
 }
 
-bool MeshSetOperation::Graph::ColorEdges(const std::vector<LineSegment>& lineSegmentArray, double eps /*= MESH_NINJA_EPS*/)
+// The overlapping pairs of boxes are found by sweeping across them from left to right.
+/*static*/ void MeshSetOperation::FindOverlaps(const std::vector<AxisAlignedBoundingBox>& boxArray, std::vector<std::vector<int>>& overlapArray)
 {
-	for (Edge* edge : *this->edgeArray)
+	int numBoxes = (signed)boxArray.size();
+
+	overlapArray.clear();
+	overlapArray.resize(numBoxes);
+
+	std::vector<int> sortedArray;
+	for (int i = 0; i < numBoxes; i++)
+		if (boxArray[i].IsValid())
+			sortedArray.push_back(i);
+
+	std::sort(sortedArray.begin(), sortedArray.end(), [&boxArray](int i, int j) -> bool
+		{
+			if (boxArray[i].min.x != boxArray[j].min.x)
+				return boxArray[i].min.x < boxArray[j].min.x;
+
+			return i < j;
+		});
+
+	std::vector<int> activeArray;
+	for (int i : sortedArray)
 	{
-		LineSegment edgeSegment((*this->mesh->vertexArray)[edge->pair.i], (*this->mesh->vertexArray)[edge->pair.j]);
+		const AxisAlignedBoundingBox& box = boxArray[i];
 
-		bool cutFound = false;
+		std::erase_if(activeArray, [&boxArray, &box](int j) -> bool
+			{
+				return boxArray[j].max.x < box.min.x;
+			});
 
-		for (const LineSegment& lineSegment : lineSegmentArray)
+		for (int j : activeArray)
 		{
-			if (lineSegment.ContainsPoint(edgeSegment.vertexA, eps) && lineSegment.ContainsPoint(edgeSegment.vertexB, eps))
+			if (box.OverlapsWith(boxArray[j]))
 			{
-				cutFound = true;
-				((MeshSetOperation::Edge*)edge)->type = MeshSetOperation::Edge::Type::CUT_BOUNDARY;
-				break;
+				overlapArray[i].push_back(j);
+				overlapArray[j].push_back(i);
 			}
 		}
 
-		if (!cutFound)
-			((MeshSetOperation::Edge*)edge)->type = MeshSetOperation::Edge::Type::NORMAL;
+		activeArray.push_back(i);
 	}
-
-	return true;
 }
 
-bool MeshSetOperation::Graph::ColorNodes(const Graph* otherGraph)
+// The clusters are the connected components of the graph of overlaps, listed in order of their first members.
+/*static*/ void MeshSetOperation::FindClusters(const std::vector<std::vector<int>>& overlapArray, std::vector<std::vector<int>>& clusterArray)
 {
-	BoundingBoxTree tree;
+	clusterArray.clear();
+
+	int numBoxes = (signed)overlapArray.size();
+	std::vector<bool> visitedArray(numBoxes, false);
 
-	while (true)
+	for (int i = 0; i < numBoxes; i++)
 	{
-		MeshSetOperation::Node* node = this->FindInitialOutsideNode(otherGraph, tree);
-		if (!node)
-			break;
+		if (visitedArray[i])
+			continue;
 
-		assert(node->side == MeshSetOperation::Node::Side::UNKNOWN);
-		node->side = MeshSetOperation::Node::Side::OUTSIDE;
+		clusterArray.push_back(std::vector<int>());
+		std::vector<int>& cluster = clusterArray.back();
 
-		std::list<MeshSetOperation::Node*> nodeQueue;
-		nodeQueue.push_back(node);
+		std::vector<int> stack;
+		stack.push_back(i);
+		visitedArray[i] = true;
 
-		while (nodeQueue.size() > 0)
+		while (stack.size() > 0)
 		{
-			std::list<MeshSetOperation::Node*>::iterator iter = nodeQueue.begin();
-			node = *iter;
-			nodeQueue.erase(iter);
+			int j = stack.back();
+			stack.pop_back();
+			cluster.push_back(j);
 
-			for (Edge* edge : node->edgeArray)
+			for (int k : overlapArray[j])
 			{
-				MeshSetOperation::Node* adjacentNode = (MeshSetOperation::Node*)edge->Fallow(node);
-				if (adjacentNode->side == MeshSetOperation::Node::Side::UNKNOWN)
+				if (!visitedArray[k])
 				{
-					switch (((MeshSetOperation::Edge*)edge)->type)
-					{
-						case MeshSetOperation::Edge::Type::CUT_BOUNDARY:
-						{
-							if (node->side == MeshSetOperation::Node::Side::INSIDE)
-								adjacentNode->side = MeshSetOperation::Node::Side::OUTSIDE;
-							else
-								adjacentNode->side = MeshSetOperation::Node::Side::INSIDE;
-							break;
-						}
-						case MeshSetOperation::Edge::Type::NORMAL:
-						{
-							adjacentNode->side = node->side;
-							break;
-						}
-						default:
-						{
-							return false;
-						}
-					}
-
-					nodeQueue.push_back(adjacentNode);
+					visitedArray[k] = true;
+					stack.push_back(k);
 				}
 			}
 		}
 	}
+}
 
-	return true;
+// This orders the boxes so that Reduce pairs up neighbours.  Reduce always ends by combining the first
+// power-of-two many meshes with the rest, so that's where each range is split, across its longest extent.
+/*static*/ void MeshSetOperation::OrderSpatially(const std::vector<AxisAlignedBoundingBox>& boxArray, std::vector<int>& indexArray, int begin, int end)
+{
+	int count = end - begin;
+	if (count <= 2)
+		return;
+
+	int split = 1;
+	while (2 * split < count)
+		split *= 2;
+
+	AxisAlignedBoundingBox centerBox(boxArray[indexArray[begin]].Center());
+	for (int i = begin + 1; i < end; i++)
+		centerBox.ExpandToIncludePoint(boxArray[indexArray[i]].Center());
+
+	int axis = 0;
+	if (centerBox.Height() > centerBox.Width() && centerBox.Height() >= centerBox.Depth())
+		axis = 1;
+	else if (centerBox.Depth() > centerBox.Width() && centerBox.Depth() > centerBox.Height())
+		axis = 2;
+
+	std::nth_element(indexArray.begin() + begin, indexArray.begin() + begin + split, indexArray.begin() + end, [&boxArray, axis](int i, int j) -> bool
+		{
+			Vector3 centerI = boxArray[i].Center();
+			Vector3 centerJ = boxArray[j].Center();
+
+			switch (axis)
+			{
+				case 0: return centerI.x < centerJ.x;
+				case 1: return centerI.y < centerJ.y;
+			}
+
+			return centerI.z < centerJ.z;
+		});
+
+	OrderSpatially(boxArray, indexArray, begin, begin + split);
+	OrderSpatially(boxArray, indexArray, begin + split, end);
+}
+
+//----------------------------------- MeshSetOperation::PolylineCollection -----------------------------------
+
+MeshSetOperation::PolylineCollection::PolylineCollection()
+{
+}
+
+/*virtual*/ MeshSetOperation::PolylineCollection::~PolylineCollection()
+{
+}
+
+void MeshSetOperation::PolylineCollection::Clear()
+{
+	this->segmentArray.clear();
+	this->polylineList.clear();
+	this->openPolylineList.clear();
 }
 
-MeshSetOperation::Node* MeshSetOperation::Graph::FindInitialOutsideNode(const Graph* otherGraph, BoundingBoxTree& tree)
+void MeshSetOperation::PolylineCollection::AddSegment(const Vector3& vertexA, const Vector3& vertexB)
 {
-	std::vector<MeshSetOperation::Node*> uncoloredNodesArray;
-	for (Node* node : *this->nodeArray)
-		if (((MeshSetOperation::Node*)node)->side == MeshSetOperation::Node::Side::UNKNOWN)
-			uncoloredNodesArray.push_back((MeshSetOperation::Node*)node);
+	this->segmentArray.push_back(LineSegment(vertexA, vertexB));
+}
+
+// Every segment end-point is welded into a vertex through the spatial hash, so that each segment
+// becomes an edge between two vertex indices.  A closed cut is then just a cycle in this graph.
+// We first walk from every vertex of odd degree, because those can only be the ends of open chains,
+// and then whatever edges remain must decompose into closed loops.  Each edge is visited once.
+bool MeshSetOperation::PolylineCollection::Stitch(double eps /*= MESH_NINJA_EPS*/)
+{
+	this->polylineList.clear();
+	this->openPolylineList.clear();
 
-	if (uncoloredNodesArray.size() == 0)
-		return nullptr;
+	SpatialHash spatialHash(eps);
+	std::unordered_set<uint64_t> edgeSet;
+	std::vector<MeshGraph::VertexPair<false>> edgeArray;
+	edgeArray.reserve(this->segmentArray.size());
 
-	for (MeshSetOperation::Node* node : uncoloredNodesArray)
+	for (const LineSegment& segment : this->segmentArray)
 	{
-		ConvexPolygon polygon;
-		node->facet->MakePolygon(polygon, this->mesh);
+		MeshGraph::VertexPair<false> pair;
 
-		Plane plane;
-		polygon.CalcPlane(plane);
+		pair.i = spatialHash.WeldPoint(segment.vertexA, eps);
+		pair.j = spatialHash.WeldPoint(segment.vertexB, eps);
+
+		// Degenerate segments and segments found twice (e.g., along an edge shared by two facets) contribute nothing.
+		if (pair.i == pair.j || !edgeSet.insert(pair.CalcKey()).second)
+			continue;
+
+		edgeArray.push_back(pair);
+	}
+
+	int numVertices = spatialHash.Size();
+	int numEdges = (int)edgeArray.size();
+
+	std::vector<int> offsetArray(numVertices + 1, 0);
+	for (const MeshGraph::VertexPair<false>& pair : edgeArray)
+	{
+		offsetArray[pair.i + 1]++;
+		offsetArray[pair.j + 1]++;
+	}
 
-		if (plane.AllPointsNotOnSide(*this->mesh->vertexArray, Plane::Side::FRONT) && plane.AllPointsNotOnSide(*otherGraph->mesh->vertexArray, Plane::Side::FRONT))
-			return node;
+	for (int i = 0; i < numVertices; i++)
+		offsetArray[i + 1] += offsetArray[i];
+
+	std::vector<int> cursorArray(offsetArray.begin(), offsetArray.end() - 1);
+	std::vector<int> adjacencyArray(2 * numEdges);
+	for (int e = 0; e < numEdges; e++)
+	{
+		adjacencyArray[cursorArray[edgeArray[e].i]++] = e;
+		adjacencyArray[cursorArray[edgeArray[e].j]++] = e;
 	}
 
-	// Okay, if we get here, that doesn't mean that there doesn't exist an
-	// outside polygon from which we can start the graph coloring algorithm.
-	// We just have to go about finding one a different way.
+	cursorArray.assign(offsetArray.begin(), offsetArray.end() - 1);
+	std::vector<bool> edgeUsedArray(numEdges, false);
 
-	class Entry : public BoundingBoxTree::Object
+	auto findUnusedEdge = [&](int i) -> int
 	{
-	public:
-		Entry(MeshSetOperation::Node* node, const Graph* graph)
+		while (cursorArray[i] < offsetArray[i + 1])
 		{
-			this->node = node;
-			this->node->facet->MakePolygon(this->polygon, graph->mesh);
-			this->polygon.CalcBox(this->box);
+			int e = adjacencyArray[cursorArray[i]++];
+			if (!edgeUsedArray[e])
+				return e;
 		}
 
-		virtual ~Entry()
+		return -1;
+	};
+
+	auto walk = [&](int i, Polyline& polyline)
+	{
+		polyline.vertexArray->push_back(spatialHash[i]);
+
+		while (true)
 		{
+			int e = findUnusedEdge(i);
+			if (e < 0)
+				break;
+
+			edgeUsedArray[e] = true;
+			i = (edgeArray[e].i == i) ? edgeArray[e].j : edgeArray[e].i;
+			polyline.vertexArray->push_back(spatialHash[i]);
 		}
+	};
 
-		virtual AxisAlignedBoundingBox GetBoundingBox() const override
+	for (int i = 0; i < numVertices; i++)
+	{
+		int degree = offsetArray[i + 1] - offsetArray[i];
+		if (degree % 2 == 1 && cursorArray[i] < offsetArray[i + 1])
 		{
-			return box;
+			Polyline polyline;
+			walk(i, polyline);
+			if (polyline.vertexArray->size() > 1)
+				this->openPolylineList.push_back(polyline);
 		}
+	}
 
-		virtual bool IsHitByRay(const Ray& ray, double& alpha) const override
+	for (int i = 0; i < numVertices; i++)
+	{
+		while (cursorArray[i] < offsetArray[i + 1])
 		{
-			return ray.CastAgainst(this->polygon, alpha);
+			Polyline polyline;
+			walk(i, polyline);
+			if (polyline.vertexArray->size() > 1)
+				this->polylineList.push_back(polyline);
 		}
+	}
 
-		MeshSetOperation::Node* node;
-		ConvexPolygon polygon;
-		AxisAlignedBoundingBox box;
-	};
+	return this->openPolylineList.size() == 0;
+}
 
-	if (tree.IsEmpty())
+void MeshSetOperation::PolylineCollection::DescribeOpenChains(std::string& description, int maxChains /*= 8*/) const
+{
+	description = std::format("Found {} open chain(s):", this->openPolylineList.size());
+
+	int count = 0;
+	for (const Polyline& polyline : this->openPolylineList)
 	{
-		std::vector<BoundingBoxTree::Object*> objectArray;
+		if (count++ == maxChains)
+		{
+			description += " ...";
+			break;
+		}
 
-		for (Node* node : *this->nodeArray)
-			objectArray.push_back(new Entry((MeshSetOperation::Node*)node, this));
+		std::string firstVertex, lastVertex;
+		polyline.GetFirstVertex().ToString(firstVertex);
+		polyline.GetLastVertex().ToString(lastVertex);
+		description += std::format(" [({}) to ({}), {} segment(s)]", firstVertex, lastVertex, polyline.vertexArray->size() - 1);
+	}
+}
 
-		for (Node* node : *otherGraph->nodeArray)
-			objectArray.push_back(new Entry((MeshSetOperation::Node*)node, otherGraph));
+//----------------------------------- MeshSetOperation::Node -----------------------------------
 
-		tree.Rebuild(objectArray);
+MeshSetOperation::Node::Node()
+{
+	this->side = Side::UNKNOWN;
+}
+
+/*virtual*/ MeshSetOperation::Node::~Node()
+{
+}
+
+/*virtual*/ Vector3 MeshSetOperation::Node::GetDebugColor() const
+{
+	switch (this->side)
+	{
+		case Side::INSIDE:
+		{
+			return Vector3(1.0, 0.0, 0.0);
+		}
+		case Side::OUTSIDE:
+		{
+			return Vector3(0.0, 0.0, 1.0);
+		}
 	}
 
-	AxisAlignedBoundingBox aabb;
-	tree.GetBoundingBox(aabb);
-	aabb.ScaleAboutCenter(1.5);
+	return Vector3(0.5, 0.5, 0.5);
+}
+
+//----------------------------------- MeshSetOperation::Graph -----------------------------------
+
+MeshSetOperation::Graph::Graph()
+{
+}
+
+/*virtual*/ MeshSetOperation::Graph::~Graph()
+{
+}
+
+/*virtual*/ MeshGraph::Node* MeshSetOperation::Graph::CreateNode()
+{
+	return new MeshSetOperation::Node();
+}
 
-	for (MeshSetOperation::Node* node : uncoloredNodesArray)
+// Every facet of a cut mesh should lie entirely inside or entirely outside of the other mesh, so we
+// can classify each one directly by its center.  We used to classify just one facet and flood-fill the
+// rest of the graph across cut edges, but then a single imperfect cut would spread a wrong answer to
+// everything beyond it.  Classifying every facet independently keeps such errors local.
+bool MeshSetOperation::Graph::ColorNodes(const MeshPointClassifier& classifier)
+{
+	if (!classifier.IsBuilt())
+		return false;
+
+	std::vector<Vector3> centerArray;
+	for (const Node* node : *this->nodeArray)
 	{
 		ConvexPolygon polygon;
 		node->facet->MakePolygon(polygon, this->mesh);
+		centerArray.push_back(polygon.CalcCenter());
+	}
 
-		Vector3 center = polygon.CalcCenter();
-
-		for (int i = 0; i < 6; i++)
-		{
-			Ray ray;
+	std::vector<MeshPointClassifier::Side> sideArray;
+	classifier.ClassifyPoints(centerArray, sideArray);
 
-			switch (i)
-			{
-				case 0: ray.origin = Vector3(center.x, center.y, aabb.max.z); break;
-				case 1: ray.origin = Vector3(center.x, center.y, aabb.min.z); break;
-				case 2: ray.origin = Vector3(center.x, aabb.max.y, center.z); break;
-				case 3: ray.origin = Vector3(center.x, aabb.min.y, center.z); break;
-				case 4: ray.origin = Vector3(aabb.max.x, center.y, center.z); break;
-				case 5: ray.origin = Vector3(aabb.min.x, center.y, center.z); break;
-			}
+	for (int i = 0; i < (signed)this->nodeArray->size(); i++)
+	{
+		MeshSetOperation::Node* node = (MeshSetOperation::Node*)(*this->nodeArray)[i];
 
-			ray.direction = center - ray.origin;
-			Entry* entry = (Entry*)tree.FindClosestHit(ray);
-			if (entry && entry->node == node)
-				return node;
-		}
+		if (sideArray[i] == MeshPointClassifier::Side::INSIDE)
+			node->side = MeshSetOperation::Node::Side::INSIDE;
+		else
+			node->side = MeshSetOperation::Node::Side::OUTSIDE;
 	}
 
-	// If we got here, then we may not have done enough to find the outside polygon.
-	// It's possible that a linear ray can't see it, but that it could be found with
-	// some kind of weaving-ray.  Or it could just be completely unreachable, and
-	// so detecting it would be even more non-trivial.
-	assert(0);
-	return nullptr;
+	return true;
 }
 
 void MeshSetOperation::Graph::PopulatePolygonLists(std::vector<ConvexPolygon>& insidePolygonList, std::vector<ConvexPolygon>& outsidePolygonList) const
@@ -633,17 +1131,46 @@ MeshUnion::MeshUnion()
 		return false;
 
 	std::vector<ConvexPolygon> polygonArray;
+	this->SelectPolygons(polygonLists, polygonArray);
+
+	resultingMesh.FromConvexPolygonArray(polygonArray);
+	return true;
+}
 
+/*virtual*/ std::string MeshUnion::GetCacheTag() const
+{
+	return std::format("union {}", (int)this->predicateMode);
+}
+
+/*virtual*/ void MeshUnion::SelectPolygons(const PolygonLists& polygonLists, std::vector<ConvexPolygon>& polygonArray) const
+{
 	for (const ConvexPolygon& polygon : polygonLists.meshA_outsidePolygonList)
 		polygonArray.push_back(polygon);
 
 	for (const ConvexPolygon& polygon : polygonLists.meshB_outsidePolygonList)
 		polygonArray.push_back(polygon);
+}
 
-	resultingMesh.FromConvexPolygonArray(polygonArray);
+/*virtual*/ bool MeshUnion::KeepsOutsideOfA() const
+{
 	return true;
 }
 
+/*virtual*/ MeshSetOperation* MeshUnion::CreateOperation() const
+{
+	return new MeshUnion();
+}
+
+/*virtual*/ void MeshUnion::CombineDisjoint(const std::vector<const ConvexPolygonMesh*>& meshArray, ConvexPolygonMesh& resultingMesh) const
+{
+	std::vector<ConvexPolygon> polygonArray;
+
+	for (const ConvexPolygonMesh* mesh : meshArray)
+		mesh->ToConvexPolygonArray(polygonArray);
+
+	resultingMesh.FromConvexPolygonArray(polygonArray);
+}
+
 //----------------------------------- MeshIntersection -----------------------------------
 
 MeshIntersection::MeshIntersection()
@@ -661,15 +1188,61 @@ MeshIntersection::MeshIntersection()
 		return false;
 
 	std::vector<ConvexPolygon> polygonArray;
+	this->SelectPolygons(polygonLists, polygonArray);
 
+	resultingMesh.FromConvexPolygonArray(polygonArray);
+	return true;
+}
+
+/*virtual*/ std::string MeshIntersection::GetCacheTag() const
+{
+	return std::format("intersection {}", (int)this->predicateMode);
+}
+
+/*virtual*/ void MeshIntersection::SelectPolygons(const PolygonLists& polygonLists, std::vector<ConvexPolygon>& polygonArray) const
+{
 	for (const ConvexPolygon& polygon : polygonLists.meshA_insidePolygonList)
 		polygonArray.push_back(polygon);
 
 	for (const ConvexPolygon& polygon : polygonLists.meshB_insidePolygonList)
 		polygonArray.push_back(polygon);
+}
 
-	resultingMesh.FromConvexPolygonArray(polygonArray);
-	return true;
+/*virtual*/ bool MeshIntersection::KeepsOutsideOfA() const
+{
+	return false;
+}
+
+/*virtual*/ bool MeshIntersection::PerformMany(const std::vector<const ConvexPolygonMesh*>& meshArray, ConvexPolygonMesh& resultingMesh, int threadCount /*= 0*/)
+{
+	// Everything must overlap everything else for the result to be anything at all.
+	AxisAlignedBoundingBox commonBox;
+	for (int i = 0; i < (signed)meshArray.size(); i++)
+	{
+		AxisAlignedBoundingBox box;
+		CalcBoundingBox(*meshArray[i], box);
+
+		if (i == 0)
+			commonBox = box;
+		else if (!commonBox.Intersect(commonBox, box))
+		{
+			resultingMesh.Clear();
+			return true;
+		}
+	}
+
+	return MeshSetOperation::PerformMany(meshArray, resultingMesh, threadCount);
+}
+
+/*virtual*/ MeshSetOperation* MeshIntersection::CreateOperation() const
+{
+	return new MeshIntersection();
+}
+
+// Meshes with nothing in common intersect in nothing, whatever they are.
+/*virtual*/ void MeshIntersection::CombineDisjoint(const std::vector<const ConvexPolygonMesh*>& /*meshArray*/, ConvexPolygonMesh& resultingMesh) const
+{
+	resultingMesh.Clear();
 }
 
 //----------------------------------- MeshSubtraction -----------------------------------
@@ -689,7 +1262,19 @@ MeshSubtraction::MeshSubtraction()
 		return false;
 
 	std::vector<ConvexPolygon> polygonArray;
+	this->SelectPolygons(polygonLists, polygonArray);
+
+	resultingMesh.FromConvexPolygonArray(polygonArray);
+	return true;
+}
+
+/*virtual*/ std::string MeshSubtraction::GetCacheTag() const
+{
+	return std::format("subtraction {}", (int)this->predicateMode);
+}
 
+/*virtual*/ void MeshSubtraction::SelectPolygons(const PolygonLists& polygonLists, std::vector<ConvexPolygon>& polygonArray) const
+{
 	for (const ConvexPolygon& polygon : polygonLists.meshA_outsidePolygonList)
 		polygonArray.push_back(polygon);
 
@@ -699,7 +1284,54 @@ MeshSubtraction::MeshSubtraction()
 		reversePolygon.MakeReverseOf(polygon);
 		polygonArray.push_back(reversePolygon);
 	}
+}
 
-	resultingMesh.FromConvexPolygonArray(polygonArray);
+/*virtual*/ bool MeshSubtraction::KeepsOutsideOfA() const
+{
 	return true;
+}
+
+/*virtual*/ bool MeshSubtraction::PerformMany(const std::vector<const ConvexPolygonMesh*>& meshArray, ConvexPolygonMesh& resultingMesh, int threadCount /*= 0*/)
+{
+	if (meshArray.size() == 0)
+	{
+		resultingMesh.Clear();
+		return true;
+	}
+
+	const ConvexPolygonMesh& minuendMesh = *meshArray[0];
+
+	AxisAlignedBoundingBox minuendBox;
+	CalcBoundingBox(minuendMesh, minuendBox);
+
+	// Anything not overlapping the first mesh can't take anything away from it.
+	std::vector<const ConvexPolygonMesh*> subtrahendMeshArray;
+	for (int i = 1; i < (signed)meshArray.size(); i++)
+	{
+		AxisAlignedBoundingBox box;
+		if (CalcBoundingBox(*meshArray[i], box) && box.OverlapsWith(minuendBox))
+			subtrahendMeshArray.push_back(meshArray[i]);
+	}
+
+	MeshUnion meshUnion;
+	meshUnion.predicateMode = this->predicateMode;
+
+	ConvexPolygonMesh subtrahendMesh;
+	if (!meshUnion.PerformMany(subtrahendMeshArray, subtrahendMesh, threadCount))
+	{
+		*this->error = *meshUnion.error;
+		return false;
+	}
+
+	return this->PerformIfOverlapping(minuendMesh, subtrahendMesh, resultingMesh);
+}
+
+/*virtual*/ MeshSetOperation* MeshSubtraction::CreateOperation() const
+{
+	return new MeshSubtraction();
+}
+
+/*virtual*/ void MeshSubtraction::CombineDisjoint(const std::vector<const ConvexPolygonMesh*>& meshArray, ConvexPolygonMesh& resultingMesh) const
+{
+	resultingMesh.Copy(*meshArray[0]);
 }
\ No newline at end of file
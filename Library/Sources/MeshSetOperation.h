@@ -3,14 +3,18 @@
 #include "MeshBinaryOperation.h"
 #include "ConvexPolygon.h"
 #include "Polyline.h"
+#include "LineSegment.h"
+#include "Plane.h"
 #include "MeshGraph.h"
 #include "DebugDraw.h"
+#include "Math/Predicates.h"
+#include "AxisAlignedBoundingBox.h"
 
 namespace MeshNinja
 {
 	class ConvexPolygonMesh;
-	class LineSegment;
-	class BoundingBoxTree;
+	class MeshPointClassifier;
+	class PreparedMesh;
 
 	class MESH_NINJA_API MeshSetOperation : public MeshBinaryOperation
 	{
@@ -18,8 +22,36 @@ namespace MeshNinja
 		MeshSetOperation();
 		virtual ~MeshSetOperation();
 
+		// This applies the operation to any number of meshes at once; for subtraction, everything after the first
+		// mesh is taken away from it.  The meshes are gathered into clusters by the overlaps of their bounding boxes.
+		// Disjoint meshes are just put together, so clusters are only ever operated on alone, and within a cluster,
+		// meshes that don't overlap one another are put together before anything else is done.  What remains is
+		// combined pairwise in a balanced tree, the pairs of each round being worked on by several threads.
+		virtual bool PerformMany(const std::vector<const ConvexPolygonMesh*>& meshArray, ConvexPolygonMesh& resultingMesh, int threadCount = 0);
+
+		// This is Perform with the first mesh prepared ahead of time.  Only the facets of that mesh near the second
+		// go through the operation, so the time taken depends on the size of the second mesh, not the first.
+		bool PerformPrepared(const PreparedMesh& preparedMeshA, const ConvexPolygonMesh& meshB, ConvexPolygonMesh& resultingMesh);
+
+		// Borderline inputs that defeat the usual epsilon comparisons may succeed with Predicates::Mode::ADAPTIVE.
+		Predicates::Mode predicateMode;
+
 	protected:
 
+		// Each thread of a reduction needs its own operation to work with.
+		virtual MeshSetOperation* CreateOperation() const = 0;
+
+		// This is what the operation gives for meshes that don't touch one another, which takes no real work to find.
+		virtual void CombineDisjoint(const std::vector<const ConvexPolygonMesh*>& meshArray, ConvexPolygonMesh& resultingMesh) const = 0;
+
+		bool PerformIfOverlapping(const ConvexPolygonMesh& meshA, const ConvexPolygonMesh& meshB, ConvexPolygonMesh& resultingMesh);
+		bool Reduce(std::vector<std::vector<const ConvexPolygonMesh*>>& groupArray, std::vector<ConvexPolygonMesh*>& ownedMeshArray, int threadCount);
+
+		static bool CalcBoundingBox(const ConvexPolygonMesh& mesh, AxisAlignedBoundingBox& boundingBox);
+		static void FindOverlaps(const std::vector<AxisAlignedBoundingBox>& boxArray, std::vector<std::vector<int>>& overlapArray);
+		static void FindClusters(const std::vector<std::vector<int>>& overlapArray, std::vector<std::vector<int>>& clusterArray);
+		static void OrderSpatially(const std::vector<AxisAlignedBoundingBox>& boxArray, std::vector<int>& indexArray, int begin, int end);
+
 		struct PolygonLists
 		{
 			std::vector<ConvexPolygon> meshA_outsidePolygonList;
@@ -29,20 +61,36 @@ namespace MeshNinja
 		};
 
 		bool CalculatePolygonLists(const ConvexPolygonMesh& meshA, const ConvexPolygonMesh& meshB, PolygonLists& polygonLists);
+		bool CalculatePolygonLists(std::vector<ConvexPolygon>& polygonArrayA, std::vector<ConvexPolygon>& polygonArrayB, PolygonLists& polygonLists, const MeshPointClassifier* classifierA, const MeshPointClassifier* classifierB, const std::vector<Plane>* planeArrayA = nullptr);
 
+		// This picks out the polygons making up the result from those found by CalculatePolygonLists.
+		virtual void SelectPolygons(const PolygonLists& polygonLists, std::vector<ConvexPolygon>& polygonArray) const = 0;
+
+		// This says whether the parts of the first mesh outside of the second are part of the result.
+		virtual bool KeepsOutsideOfA() const = 0;
+
+		// The cuts between two meshes come to us as an unordered soup of line segments.
+		// Here we weld their end-points together with a spatial hash and then walk the
+		// resulting vertex adjacency to link the segments up into polylines, all in time
+		// linear in the number of segments.
 		class PolylineCollection
 		{
 		public:
 			PolylineCollection();
 			virtual ~PolylineCollection();
 
-			void AddPolyline(const Polyline& givenPolyline);
+			void Clear();
+			void AddSegment(const Vector3& vertexA, const Vector3& vertexB);
+			bool Stitch(double eps = MESH_NINJA_EPS);
+			void DescribeOpenChains(std::string& description, int maxChains = 8) const;
 
+			std::vector<LineSegment> segmentArray;
 			std::list<Polyline> polylineList;
+			std::list<Polyline> openPolylineList;
 		};
 
-		void ChopupPolygonArray(std::vector<ConvexPolygon>& polygonArray, const std::vector<LineSegment>& lineSegmentArray);
-		bool ChopupPolygon(const ConvexPolygon& polygon, ConvexPolygon& polygonA, ConvexPolygon& polygonB, const std::vector<LineSegment>& lineSegmentArray);
+		void ChopupPolygonArray(std::vector<ConvexPolygon>& polygonArray, const std::vector<LineSegment>& lineSegmentArray, const std::vector<Plane>* planeArray = nullptr);
+		bool ChopupPolygon(const ConvexPolygon& polygon, const Plane& plane, ConvexPolygon& polygonA, ConvexPolygon& polygonB, const std::vector<LineSegment>& lineSegmentArray, const std::vector<int>& candidateArray, int& splitIndex);
 
 		class Node : public MeshGraph::Node
 		{
@@ -62,24 +110,6 @@ namespace MeshNinja
 			Side side;
 		};
 
-		class Edge : public MeshGraph::Edge
-		{
-		public:
-			Edge();
-			virtual ~Edge();
-
-			virtual Vector3 GetDebugColor() const override;
-
-			enum class Type
-			{
-				UNKNOWN,
-				NORMAL,
-				CUT_BOUNDARY
-			};
-
-			Type type;
-		};
-
 		class Graph : public MeshGraph
 		{
 		public:
@@ -87,12 +117,8 @@ namespace MeshNinja
 			virtual ~Graph();
 
 			virtual Node* CreateNode() override;
-			virtual Edge* CreateEdge() override;
-
-			bool ColorEdges(const std::vector<LineSegment>& lineSegmentArray, double eps = MESH_NINJA_EPS);
-			bool ColorNodes(const Graph* otherGraph);
 
-			MeshSetOperation::Node* FindInitialOutsideNode(const Graph* otherGraph, BoundingBoxTree& tree);
+			bool ColorNodes(const MeshPointClassifier& classifier);
 
 			void PopulatePolygonLists(std::vector<ConvexPolygon>& insidePolygonList, std::vector<ConvexPolygon>& outsidePolygonList) const;
 		};
@@ -105,6 +131,13 @@ namespace MeshNinja
 		virtual ~MeshUnion();
 
 		virtual bool Perform(const ConvexPolygonMesh& meshA, const ConvexPolygonMesh& meshB, ConvexPolygonMesh& resultingMesh) override;
+		virtual std::string GetCacheTag() const override;
+
+	protected:
+		virtual void SelectPolygons(const PolygonLists& polygonLists, std::vector<ConvexPolygon>& polygonArray) const override;
+		virtual bool KeepsOutsideOfA() const override;
+		virtual MeshSetOperation* CreateOperation() const override;
+		virtual void CombineDisjoint(const std::vector<const ConvexPolygonMesh*>& meshArray, ConvexPolygonMesh& resultingMesh) const override;
 	};
 
 	class MESH_NINJA_API MeshIntersection : public MeshSetOperation
@@ -114,6 +147,14 @@ namespace MeshNinja
 		virtual ~MeshIntersection();
 
 		virtual bool Perform(const ConvexPolygonMesh& meshA, const ConvexPolygonMesh& meshB, ConvexPolygonMesh& resultingMesh) override;
+		virtual std::string GetCacheTag() const override;
+		virtual bool PerformMany(const std::vector<const ConvexPolygonMesh*>& meshArray, ConvexPolygonMesh& resultingMesh, int threadCount = 0) override;
+
+	protected:
+		virtual void SelectPolygons(const PolygonLists& polygonLists, std::vector<ConvexPolygon>& polygonArray) const override;
+		virtual bool KeepsOutsideOfA() const override;
+		virtual MeshSetOperation* CreateOperation() const override;
+		virtual void CombineDisjoint(const std::vector<const ConvexPolygonMesh*>& meshArray, ConvexPolygonMesh& resultingMesh) const override;
 	};
 
 	class MESH_NINJA_API MeshSubtraction : public MeshSetOperation
@@ -123,5 +164,15 @@ namespace MeshNinja
 		virtual ~MeshSubtraction();
 
 		virtual bool Perform(const ConvexPolygonMesh& meshA, const ConvexPolygonMesh& meshB, ConvexPolygonMesh& resultingMesh) override;
+		virtual std::string GetCacheTag() const override;
+
+		// Rather than being taken away one at a time, the other meshes are first united and then taken away all at once.
+		virtual bool PerformMany(const std::vector<const ConvexPolygonMesh*>& meshArray, ConvexPolygonMesh& resultingMesh, int threadCount = 0) override;
+
+	protected:
+		virtual void SelectPolygons(const PolygonLists& polygonLists, std::vector<ConvexPolygon>& polygonArray) const override;
+		virtual bool KeepsOutsideOfA() const override;
+		virtual MeshSetOperation* CreateOperation() const override;
+		virtual void CombineDisjoint(const std::vector<const ConvexPolygonMesh*>& meshArray, ConvexPolygonMesh& resultingMesh) const override;
 	};
 }
\ No newline at end of file
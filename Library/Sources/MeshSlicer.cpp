@@ -0,0 +1,865 @@
+#include "MeshSlicer.h"
+#include "ConvexPolygonMesh.h"
+#include "MeshGraph.h"
+#include "Plane.h"
+#include "TaskScheduler.h"
+
+using namespace MeshNinja;
+
+static inline bool IsSamePoint(const Vector3& pointA, const Vector3& pointB)
+{
+	return pointA.x == pointB.x && pointA.y == pointB.y && pointA.z == pointB.z;
+}
+
+// Crossings computed for the same mesh edge are bit-for-bit the same, so repeats can be found exactly.
+static void AddVertex(ConvexPolygon& polygon, const Vector3& point)
+{
+	if (polygon.vertexArray->size() == 0 || !IsSamePoint(polygon.vertexArray->back(), point))
+		polygon.vertexArray->push_back(point);
+}
+
+static void AddVertex(Polyline& polyline, const Vector3& point)
+{
+	if (polyline.vertexArray->size() == 0 || !IsSamePoint(polyline.vertexArray->back(), point))
+		polyline.vertexArray->push_back(point);
+}
+
+//----------------------------------- MeshSlicer -----------------------------------
+
+MeshSlicer::MeshSlicer()
+{
+	this->capContours = false;
+	this->eps = MESH_NINJA_EPS;
+	this->layerArray = new std::vector<Layer>();
+	this->error = new std::string();
+	this->heightArray = new std::vector<double>();
+	this->mesh = nullptr;
+}
+
+/*virtual*/ MeshSlicer::~MeshSlicer()
+{
+	delete this->layerArray;
+	delete this->error;
+	delete this->heightArray;
+}
+
+void MeshSlicer::Clear()
+{
+	this->layerArray->clear();
+	this->error->clear();
+	this->heightArray->clear();
+	this->mesh = nullptr;
+}
+
+void MeshSlicer::Prepare(const ConvexPolygonMesh& mesh, const Vector3& normal)
+{
+	this->mesh = &mesh;
+	this->normal = normal;
+
+	Vector3 reference = (::fabs(normal.x) < 0.9) ? Vector3(1.0, 0.0, 0.0) : Vector3(0.0, 1.0, 0.0);
+	this->axisU = reference.Cross(normal).Normalized();
+	this->axisV = normal.Cross(this->axisU);
+
+	this->heightArray->resize(mesh.vertexArray->size());
+	for (int i = 0; i < (signed)mesh.vertexArray->size(); i++)
+		(*this->heightArray)[i] = (*mesh.vertexArray)[i].Dot(normal);
+}
+
+bool MeshSlicer::Slice(const ConvexPolygonMesh& mesh, const Vector3& normal, const std::vector<double>& offsetArray, int threadCount /*= 0*/)
+{
+	this->Clear();
+
+	Vector3 unitNormal(normal);
+	if (!unitNormal.Normalize())
+	{
+		*this->error = "The slicing direction can't be zero.";
+		return false;
+	}
+
+	this->Prepare(mesh, unitNormal);
+
+	const std::vector<double>& heights = *this->heightArray;
+	int numFacets = (signed)mesh.facetArray->size();
+
+	std::vector<double> lowArray(numFacets, DBL_MAX);
+	std::vector<double> highArray(numFacets, -DBL_MAX);
+	std::vector<int> facetOrderArray(numFacets);
+
+	for (int i = 0; i < numFacets; i++)
+	{
+		const ConvexPolygonMesh::Facet& facet = (*mesh.facetArray)[i];
+		for (int j = 0; j < (signed)facet.vertexArray->size(); j++)
+		{
+			lowArray[i] = MESH_NINJA_MIN(lowArray[i], heights[facet[j]]);
+			highArray[i] = MESH_NINJA_MAX(highArray[i], heights[facet[j]]);
+		}
+
+		facetOrderArray[i] = i;
+	}
+
+	std::sort(facetOrderArray.begin(), facetOrderArray.end(), [&lowArray](int i, int j) -> bool
+		{
+			return (lowArray[i] != lowArray[j]) ? (lowArray[i] < lowArray[j]) : (i < j);
+		});
+
+	int numLayers = (signed)offsetArray.size();
+	this->layerArray->resize(numLayers);
+	std::vector<int> layerOrderArray(numLayers);
+
+	for (int i = 0; i < numLayers; i++)
+	{
+		(*this->layerArray)[i].offset = offsetArray[i];
+		layerOrderArray[i] = i;
+	}
+
+	std::sort(layerOrderArray.begin(), layerOrderArray.end(), [&offsetArray](int i, int j) -> bool
+		{
+			return (offsetArray[i] != offsetArray[j]) ? (offsetArray[i] < offsetArray[j]) : (i < j);
+		});
+
+	// A facet crosses a layer when it has a vertex below the layer and one that isn't.  Facets become active as
+	// the sweep rises past their lowest vertex and are retired once it rises past their highest.  Retiring them in
+	// a stable way means that the facets are visited in the same order no matter which thread visits the layer.
+	auto sweep = [this, &facetOrderArray, &lowArray, &highArray, &layerOrderArray](int start, int stop)
+	{
+		std::vector<int> activeArray;
+		std::vector<Segment> segmentArray;
+		int next = 0;
+
+		for (int i = start; i < stop; i++)
+		{
+			Layer& layer = (*this->layerArray)[layerOrderArray[i]];
+			double threshold = layer.offset - this->eps;
+
+			while (next < (signed)facetOrderArray.size() && lowArray[facetOrderArray[next]] <= threshold)
+				activeArray.push_back(facetOrderArray[next++]);
+
+			std::erase_if(activeArray, [&highArray, threshold](int facet) -> bool
+				{
+					return highArray[facet] <= threshold;
+				});
+
+			segmentArray.clear();
+			for (int facet : activeArray)
+				this->CutFacet(facet, layer.offset, segmentArray);
+
+			this->BuildContours(layer, segmentArray, this->capContours);
+		}
+	};
+
+	// Each sweep has to find its active facets from scratch, so the layers are handed out in as few runs as
+	// there are threads, rather than a layer at a time.
+	if (threadCount <= 0)
+		threadCount = TaskScheduler::Get()->GetThreadCount();
+
+	int layersPerThread = (numLayers + threadCount - 1) / MESH_NINJA_MAX(threadCount, 1);
+	TaskScheduler::ParallelFor(0, numLayers, layersPerThread, sweep, threadCount);
+
+	int numOpenContours = 0;
+	for (const Layer& layer : *this->layerArray)
+		numOpenContours += (signed)layer.openContourArray.size();
+
+	if (numOpenContours > 0)
+	{
+		*this->error = std::format("Found {} open contour(s).  Is the mesh closed?", numOpenContours);
+		return false;
+	}
+
+	return true;
+}
+
+// The layers are placed half a spacing in from the extremes of the mesh so that none of them just grazes it.
+bool MeshSlicer::SliceEvenly(const ConvexPolygonMesh& mesh, const Vector3& normal, double spacing, int threadCount /*= 0*/)
+{
+	this->Clear();
+
+	Vector3 unitNormal(normal);
+	if (!unitNormal.Normalize() || spacing <= 0.0)
+	{
+		*this->error = "The slicing direction can't be zero and the spacing must be positive.";
+		return false;
+	}
+
+	double low = DBL_MAX, high = -DBL_MAX;
+	for (const Vector3& vertex : *mesh.vertexArray)
+	{
+		double height = vertex.Dot(unitNormal);
+		low = MESH_NINJA_MIN(low, height);
+		high = MESH_NINJA_MAX(high, height);
+	}
+
+	std::vector<double> offsetArray;
+	for (double offset = low + spacing / 2.0; offset < high; offset += spacing)
+		offsetArray.push_back(offset);
+
+	return this->Slice(mesh, unitNormal, offsetArray, threadCount);
+}
+
+bool MeshSlicer::Split(const ConvexPolygonMesh& mesh, const Plane& plane, ConvexPolygonMesh& frontMesh, ConvexPolygonMesh& backMesh)
+{
+	this->Clear();
+	this->Prepare(mesh, plane.normal);
+
+	double offset = plane.D;
+	const std::vector<double>& heights = *this->heightArray;
+
+	std::vector<ConvexPolygon> frontPolygonArray, backPolygonArray;
+	std::vector<Segment> segmentArray;
+	bool foundFacetInPlane = false;
+
+	for (const ConvexPolygonMesh::Facet& facet : *mesh.facetArray)
+	{
+		int numVertices = (signed)facet.vertexArray->size();
+		bool hasVertexBelow = false, hasVertexAbove = false, liesInPlane = true;
+
+		for (int i = 0; i < numVertices; i++)
+		{
+			if (this->IsBelow(facet[i], offset))
+				hasVertexBelow = true;
+			else
+				hasVertexAbove = true;
+
+			if (::fabs(heights[facet[i]] - offset) >= this->eps)
+				liesInPlane = false;
+		}
+
+		ConvexPolygon polygon;
+		facet.MakePolygon(polygon, &mesh);
+
+		// A facet in the plane goes with the half it bounds.  Such facets already close off the cut, so we won't cap it.
+		if (liesInPlane)
+		{
+			Plane facetPlane;
+			if (polygon.CalcPlane(facetPlane, this->eps) && facetPlane.normal.Dot(plane.normal) > 0.0)
+				backPolygonArray.push_back(polygon);
+			else
+				frontPolygonArray.push_back(polygon);
+
+			foundFacetInPlane = true;
+			continue;
+		}
+
+		if (!hasVertexBelow)
+		{
+			frontPolygonArray.push_back(polygon);
+			continue;
+		}
+
+		if (!hasVertexAbove)
+		{
+			backPolygonArray.push_back(polygon);
+			continue;
+		}
+
+		ConvexPolygon frontPolygon, backPolygon;
+		Segment segment;
+		int numCrossings = 0;
+
+		for (int i = 0; i < numVertices; i++)
+		{
+			int j = (i + 1) % numVertices;
+
+			const Vector3& vertex = (*mesh.vertexArray)[facet[i]];
+			bool isBelow = this->IsBelow(facet[i], offset);
+
+			if (isBelow)
+				AddVertex(backPolygon, vertex);
+			else
+				AddVertex(frontPolygon, vertex);
+
+			if (isBelow != this->IsBelow(facet[j], offset))
+			{
+				Crossing crossing = this->CalcCrossing(facet[i], facet[j], offset);
+				AddVertex(frontPolygon, crossing.point);
+				AddVertex(backPolygon, crossing.point);
+
+				if (numCrossings < 2)
+					segment.crossing[numCrossings] = crossing;
+
+				numCrossings++;
+			}
+		}
+
+		for (ConvexPolygon* splitPolygon : { &frontPolygon, &backPolygon })
+		{
+			std::vector<Vector3>& vertexArray = *splitPolygon->vertexArray;
+			if (vertexArray.size() > 1 && IsSamePoint(vertexArray.front(), vertexArray.back()))
+				vertexArray.pop_back();
+		}
+
+		if (frontPolygon.vertexArray->size() >= 3)
+			frontPolygonArray.push_back(frontPolygon);
+
+		if (backPolygon.vertexArray->size() >= 3)
+			backPolygonArray.push_back(backPolygon);
+
+		if (numCrossings == 2)
+			segmentArray.push_back(segment);
+	}
+
+	this->layerArray->push_back(Layer());
+	Layer& layer = this->layerArray->back();
+	layer.offset = offset;
+
+	this->BuildContours(layer, segmentArray, this->capContours && !foundFacetInPlane);
+
+	// The caps face the front, so they close off the back half as they are and the front half when reversed.
+	for (const ConvexPolygon& cap : layer.capArray)
+	{
+		backPolygonArray.push_back(cap);
+
+		ConvexPolygon reversedCap;
+		reversedCap.MakeReverseOf(cap);
+		frontPolygonArray.push_back(reversedCap);
+	}
+
+	frontMesh.FromConvexPolygonArray(frontPolygonArray);
+	backMesh.FromConvexPolygonArray(backPolygonArray);
+
+	if (layer.openContourArray.size() > 0)
+	{
+		*this->error = std::format("Found {} open contour(s).  Is the mesh closed?", layer.openContourArray.size());
+		return false;
+	}
+
+	return true;
+}
+
+bool MeshSlicer::IsBelow(int i, double offset) const
+{
+	return (*this->heightArray)[i] - offset <= -this->eps;
+}
+
+// The crossing is always calculated from the lower numbered vertex of the edge, so that both facets sharing
+// the edge get exactly the same point.  A vertex within tolerance of the plane is its own crossing.
+MeshSlicer::Crossing MeshSlicer::CalcCrossing(int i, int j, double offset) const
+{
+	if (i > j)
+		std::swap(i, j);
+
+	const Vector3& vertexA = (*this->mesh->vertexArray)[i];
+	const Vector3& vertexB = (*this->mesh->vertexArray)[j];
+
+	double heightA = (*this->heightArray)[i] - offset;
+	double heightB = (*this->heightArray)[j] - offset;
+
+	Crossing crossing;
+	crossing.key = MeshGraph::VertexPair<false>{ i, j }.CalcKey();
+
+	if (::fabs(heightA) < this->eps)
+		crossing.point = vertexA;
+	else if (::fabs(heightB) < this->eps)
+		crossing.point = vertexB;
+	else
+		crossing.point = vertexA + (vertexB - vertexA) * (heightA / (heightA - heightB));
+
+	return crossing;
+}
+
+void MeshSlicer::CutFacet(int facet, double offset, std::vector<Segment>& segmentArray) const
+{
+	const ConvexPolygonMesh::Facet& meshFacet = (*this->mesh->facetArray)[facet];
+	int numVertices = (signed)meshFacet.vertexArray->size();
+
+	Segment segment;
+	int numCrossings = 0;
+
+	for (int i = 0; i < numVertices; i++)
+	{
+		int j = (i + 1) % numVertices;
+
+		if (this->IsBelow(meshFacet[i], offset) != this->IsBelow(meshFacet[j], offset))
+		{
+			if (numCrossings < 2)
+				segment.crossing[numCrossings] = this->CalcCrossing(meshFacet[i], meshFacet[j], offset);
+
+			numCrossings++;
+		}
+	}
+
+	// A convex facet can only be crossed twice.  We leave it to the contours to complain about any that aren't.
+	if (numCrossings == 2)
+		segmentArray.push_back(segment);
+}
+
+// Each crossing is a vertex of a graph whose edges are the segments.  In a closed mesh, every crossing is shared by
+// exactly two facets, so every vertex has degree two and the graph is a set of cycles.  As when stitching the cuts of
+// a set operation, we walk from the vertices of odd degree first, since those can only be the ends of open chains.
+void MeshSlicer::BuildContours(Layer& layer, const std::vector<Segment>& segmentArray, bool cap) const
+{
+	layer.contourArray.clear();
+	layer.openContourArray.clear();
+	layer.capArray.clear();
+
+	std::unordered_map<uint64_t, int> vertexMap;
+	std::vector<Vector3> pointArray;
+	std::vector<MeshGraph::VertexPair<false>> edgeArray;
+	edgeArray.reserve(segmentArray.size());
+
+	for (const Segment& segment : segmentArray)
+	{
+		int vertex[2];
+
+		for (int i = 0; i < 2; i++)
+		{
+			const Crossing& crossing = segment.crossing[i];
+			std::unordered_map<uint64_t, int>::iterator iter = vertexMap.find(crossing.key);
+			if (iter != vertexMap.end())
+				vertex[i] = iter->second;
+			else
+			{
+				vertex[i] = (int)pointArray.size();
+				vertexMap.insert(std::pair<uint64_t, int>(crossing.key, vertex[i]));
+				pointArray.push_back(crossing.point);
+			}
+		}
+
+		edgeArray.push_back(MeshGraph::VertexPair<false>{ vertex[0], vertex[1] });
+	}
+
+	int numVertices = (int)pointArray.size();
+	int numEdges = (int)edgeArray.size();
+
+	std::vector<int> offsetArray(numVertices + 1, 0);
+	for (const MeshGraph::VertexPair<false>& pair : edgeArray)
+	{
+		offsetArray[pair.i + 1]++;
+		offsetArray[pair.j + 1]++;
+	}
+
+	for (int i = 0; i < numVertices; i++)
+		offsetArray[i + 1] += offsetArray[i];
+
+	std::vector<int> cursorArray(offsetArray.begin(), offsetArray.end() - 1);
+	std::vector<int> adjacencyArray(2 * numEdges);
+	for (int e = 0; e < numEdges; e++)
+	{
+		adjacencyArray[cursorArray[edgeArray[e].i]++] = e;
+		adjacencyArray[cursorArray[edgeArray[e].j]++] = e;
+	}
+
+	cursorArray.assign(offsetArray.begin(), offsetArray.end() - 1);
+	std::vector<bool> edgeUsedArray(numEdges, false);
+
+	auto walk = [&](int i, Polyline& polyline)
+	{
+		AddVertex(polyline, pointArray[i]);
+
+		while (cursorArray[i] < offsetArray[i + 1])
+		{
+			int e = adjacencyArray[cursorArray[i]++];
+			if (edgeUsedArray[e])
+				continue;
+
+			edgeUsedArray[e] = true;
+			i = (edgeArray[e].i == i) ? edgeArray[e].j : edgeArray[e].i;
+			AddVertex(polyline, pointArray[i]);
+		}
+	};
+
+	for (int i = 0; i < numVertices; i++)
+	{
+		int degree = offsetArray[i + 1] - offsetArray[i];
+		if (degree % 2 == 1 && cursorArray[i] < offsetArray[i + 1])
+		{
+			Polyline polyline;
+			walk(i, polyline);
+			if (polyline.vertexArray->size() > 1)
+				layer.openContourArray.push_back(polyline);
+		}
+	}
+
+	for (int i = 0; i < numVertices; i++)
+	{
+		while (cursorArray[i] < offsetArray[i + 1])
+		{
+			Polyline polyline;
+			walk(i, polyline);
+
+			// Anything short of a triangle (with its first vertex repeated) is just where the mesh grazes the plane.
+			if (polyline.vertexArray->size() >= 4)
+				layer.contourArray.push_back(polyline);
+		}
+	}
+
+	std::vector<int> parentArray;
+	this->OrientContours(layer, parentArray);
+
+	if (cap)
+		this->CapContours(layer, parentArray);
+}
+
+MeshSlicer::Point2D MeshSlicer::Project(const Vector3& point) const
+{
+	return Point2D{ point.Dot(this->axisU), point.Dot(this->axisV) };
+}
+
+// A contour nested inside an even number of others is an outer boundary, and the rest are holes.
+// The parent of a hole is the smallest contour around it, which is the outer boundary it's a hole in.
+void MeshSlicer::OrientContours(Layer& layer, std::vector<int>& parentArray) const
+{
+	int numContours = (signed)layer.contourArray.size();
+	parentArray.assign(numContours, -1);
+
+	std::vector<std::vector<Point2D>> pointArrayArray(numContours);
+	std::vector<std::vector<int>> ringArray(numContours);
+	std::vector<double> areaArray(numContours);
+	std::vector<Point2D> minArray(numContours), maxArray(numContours);
+
+	for (int i = 0; i < numContours; i++)
+	{
+		const std::vector<Vector3>& vertexArray = *layer.contourArray[i].vertexArray;
+
+		minArray[i] = Point2D{ DBL_MAX, DBL_MAX };
+		maxArray[i] = Point2D{ -DBL_MAX, -DBL_MAX };
+
+		for (int j = 0; j < (signed)vertexArray.size() - 1; j++)
+		{
+			Point2D point = this->Project(vertexArray[j]);
+			pointArrayArray[i].push_back(point);
+			ringArray[i].push_back(j);
+
+			minArray[i] = Point2D{ MESH_NINJA_MIN(minArray[i].u, point.u), MESH_NINJA_MIN(minArray[i].v, point.v) };
+			maxArray[i] = Point2D{ MESH_NINJA_MAX(maxArray[i].u, point.u), MESH_NINJA_MAX(maxArray[i].v, point.v) };
+		}
+
+		areaArray[i] = CalcSignedArea(pointArrayArray[i], ringArray[i]);
+	}
+
+	for (int i = 0; i < numContours; i++)
+	{
+		const Point2D& point = pointArrayArray[i][0];
+		int depth = 0;
+		int parent = -1;
+
+		for (int j = 0; j < numContours; j++)
+		{
+			if (j == i || point.u < minArray[j].u || point.u > maxArray[j].u || point.v < minArray[j].v || point.v > maxArray[j].v)
+				continue;
+
+			if (RingContainsPoint(pointArrayArray[j], ringArray[j], point))
+			{
+				depth++;
+				if (parent < 0 || ::fabs(areaArray[j]) < ::fabs(areaArray[parent]))
+					parent = j;
+			}
+		}
+
+		bool isHole = (depth % 2 == 1);
+		if ((areaArray[i] > 0.0) == isHole)
+			layer.contourArray[i].ReverseOrder();
+
+		if (isHole)
+			parentArray[i] = parent;
+	}
+}
+
+// Each outer boundary is joined to its holes by bridges to make a single simple (if self-touching) ring,
+// which is then triangulated by clipping ears.  See "Triangulation by Ear Clipping" by David Eberly.
+void MeshSlicer::CapContours(Layer& layer, const std::vector<int>& parentArray) const
+{
+	int numContours = (signed)layer.contourArray.size();
+
+	for (int i = 0; i < numContours; i++)
+	{
+		if (parentArray[i] >= 0)
+			continue;
+
+		std::vector<Vector3> vertexArray;
+		std::vector<Point2D> pointArray;
+		std::vector<int> ring;
+		std::vector<std::vector<int>> holeArray;
+
+		for (int j = 0; j < numContours; j++)
+		{
+			if (j != i && parentArray[j] != i)
+				continue;
+
+			const std::vector<Vector3>& contourVertexArray = *layer.contourArray[j].vertexArray;
+			std::vector<int> contourRing;
+
+			for (int k = 0; k < (signed)contourVertexArray.size() - 1; k++)
+			{
+				contourRing.push_back((int)vertexArray.size());
+				vertexArray.push_back(contourVertexArray[k]);
+				pointArray.push_back(this->Project(contourVertexArray[k]));
+			}
+
+			if (j == i)
+				ring = contourRing;
+			else
+				holeArray.push_back(contourRing);
+		}
+
+		// Bridging the holes from right to left means no bridge can cross a hole that isn't yet part of the ring.
+		std::vector<double> rightmostArray;
+		for (const std::vector<int>& hole : holeArray)
+		{
+			double rightmost = -DBL_MAX;
+			for (int j : hole)
+				rightmost = MESH_NINJA_MAX(rightmost, pointArray[j].u);
+
+			rightmostArray.push_back(rightmost);
+		}
+
+		std::vector<int> holeOrderArray(holeArray.size());
+		for (int j = 0; j < (signed)holeArray.size(); j++)
+			holeOrderArray[j] = j;
+
+		std::sort(holeOrderArray.begin(), holeOrderArray.end(), [&rightmostArray](int j, int k) -> bool
+			{
+				return rightmostArray[j] > rightmostArray[k];
+			});
+
+		for (int j : holeOrderArray)
+			BridgeHole(pointArray, ring, holeArray[j]);
+
+		std::vector<int> triangleArray;
+		ClipEars(pointArray, ring, triangleArray);
+
+		for (int j = 0; j + 2 < (signed)triangleArray.size(); j += 3)
+		{
+			ConvexPolygon triangle;
+			for (int k = 0; k < 3; k++)
+				triangle.vertexArray->push_back(vertexArray[triangleArray[j + k]]);
+
+			layer.capArray.push_back(triangle);
+		}
+	}
+}
+
+/*static*/ double MeshSlicer::CalcSignedArea(const std::vector<Point2D>& pointArray, const std::vector<int>& ring)
+{
+	double area = 0.0;
+
+	for (int i = 0; i < (signed)ring.size(); i++)
+	{
+		const Point2D& pointA = pointArray[ring[i]];
+		const Point2D& pointB = pointArray[ring[(i + 1) % ring.size()]];
+		area += pointA.u * pointB.v - pointA.v * pointB.u;
+	}
+
+	return area / 2.0;
+}
+
+/*static*/ bool MeshSlicer::RingContainsPoint(const std::vector<Point2D>& pointArray, const std::vector<int>& ring, const Point2D& point)
+{
+	bool inside = false;
+
+	for (int i = 0; i < (signed)ring.size(); i++)
+	{
+		const Point2D& pointA = pointArray[ring[i]];
+		const Point2D& pointB = pointArray[ring[(i + 1) % ring.size()]];
+
+		if ((pointA.v > point.v) != (pointB.v > point.v))
+		{
+			double u = pointA.u + (point.v - pointA.v) * (pointB.u - pointA.u) / (pointB.v - pointA.v);
+			if (point.u < u)
+				inside = !inside;
+		}
+	}
+
+	return inside;
+}
+
+// Positive if the points wind counter-clockwise.
+/*static*/ double MeshSlicer::Cross(const Point2D& pointA, const Point2D& pointB, const Point2D& pointC)
+{
+	return (pointB.u - pointA.u) * (pointC.v - pointA.v) - (pointB.v - pointA.v) * (pointC.u - pointA.u);
+}
+
+// This includes the boundary of the triangle, which may wind either way.
+/*static*/ bool MeshSlicer::TriangleContainsPoint(const Point2D& pointA, const Point2D& pointB, const Point2D& pointC, const Point2D& point)
+{
+	double crossA = Cross(pointA, pointB, point);
+	double crossB = Cross(pointB, pointC, point);
+	double crossC = Cross(pointC, pointA, point);
+
+	bool hasNegative = (crossA < 0.0 || crossB < 0.0 || crossC < 0.0);
+	bool hasPositive = (crossA > 0.0 || crossB > 0.0 || crossC > 0.0);
+
+	return !(hasNegative && hasPositive);
+}
+
+// The hole is joined to the ring through a vertex of the ring visible from the rightmost vertex of the hole.
+// We look for it along a ray cast rightward from the hole.  The ring vertex at the end of the edge the ray hits
+// is visible unless some reflex vertex of the ring is in the way, in which case the one of those making the
+// smallest angle with the ray is visible.
+/*static*/ void MeshSlicer::BridgeHole(const std::vector<Point2D>& pointArray, std::vector<int>& ring, const std::vector<int>& hole)
+{
+	int numRingVertices = (signed)ring.size();
+	int numHoleVertices = (signed)hole.size();
+
+	int rightmost = 0;
+	for (int i = 1; i < numHoleVertices; i++)
+		if (pointArray[hole[i]].u > pointArray[hole[rightmost]].u)
+			rightmost = i;
+
+	const Point2D& holePoint = pointArray[hole[rightmost]];
+
+	double closestU = DBL_MAX;
+	int closestEdge = -1;
+
+	for (int i = 0; i < numRingVertices; i++)
+	{
+		const Point2D& pointA = pointArray[ring[i]];
+		const Point2D& pointB = pointArray[ring[(i + 1) % numRingVertices]];
+
+		if ((pointA.v > holePoint.v) != (pointB.v > holePoint.v))
+		{
+			double u = pointA.u + (holePoint.v - pointA.v) * (pointB.u - pointA.u) / (pointB.v - pointA.v);
+			if (u >= holePoint.u && u < closestU)
+			{
+				closestU = u;
+				closestEdge = i;
+			}
+		}
+	}
+
+	// This can only happen if the hole wasn't inside the ring after all.
+	if (closestEdge < 0)
+		return;
+
+	int j = (closestEdge + 1) % numRingVertices;
+	int visible = (pointArray[ring[closestEdge]].u > pointArray[ring[j]].u) ? closestEdge : j;
+
+	Point2D hitPoint{ closestU, holePoint.v };
+	const Point2D& visiblePoint = pointArray[ring[visible]];
+
+	if (visiblePoint.u != hitPoint.u || visiblePoint.v != hitPoint.v)
+	{
+		double largestCosine = -DBL_MAX;
+		double smallestDistance = DBL_MAX;
+		int blocker = -1;
+
+		for (int i = 0; i < numRingVertices; i++)
+		{
+			if (i == visible)
+				continue;
+
+			const Point2D& point = pointArray[ring[i]];
+			const Point2D& previousPoint = pointArray[ring[(i + numRingVertices - 1) % numRingVertices]];
+			const Point2D& nextPoint = pointArray[ring[(i + 1) % numRingVertices]];
+
+			if (Cross(previousPoint, point, nextPoint) > 0.0 || !TriangleContainsPoint(holePoint, hitPoint, visiblePoint, point))
+				continue;
+
+			double deltaU = point.u - holePoint.u;
+			double deltaV = point.v - holePoint.v;
+			double distance = ::sqrt(deltaU * deltaU + deltaV * deltaV);
+			if (distance == 0.0)
+				continue;
+
+			double cosine = deltaU / distance;
+			if (cosine > largestCosine || (cosine == largestCosine && distance < smallestDistance))
+			{
+				largestCosine = cosine;
+				smallestDistance = distance;
+				blocker = i;
+			}
+		}
+
+		if (blocker >= 0)
+			visible = blocker;
+	}
+
+	// Go out along the bridge, around the hole, and back again.
+	std::vector<int> bridgedRing;
+	bridgedRing.reserve(numRingVertices + numHoleVertices + 2);
+
+	for (int i = 0; i <= visible; i++)
+		bridgedRing.push_back(ring[i]);
+
+	for (int i = 0; i <= numHoleVertices; i++)
+		bridgedRing.push_back(hole[(rightmost + i) % numHoleVertices]);
+
+	for (int i = visible; i < numRingVertices; i++)
+		bridgedRing.push_back(ring[i]);
+
+	ring = bridgedRing;
+}
+
+// The ring must wind counter-clockwise.  Only reflex vertices can be inside an ear, so only those are checked.
+// Bridges put the same point in the ring twice, so a vertex sitting on a corner of the ear doesn't count against it.
+/*static*/ void MeshSlicer::ClipEars(const std::vector<Point2D>& pointArray, const std::vector<int>& ring, std::vector<int>& triangleArray)
+{
+	int numVertices = (signed)ring.size();
+	if (numVertices < 3)
+		return;
+
+	std::vector<int> previousArray(numVertices), nextArray(numVertices);
+	for (int i = 0; i < numVertices; i++)
+	{
+		previousArray[i] = (i + numVertices - 1) % numVertices;
+		nextArray[i] = (i + 1) % numVertices;
+	}
+
+	auto point = [&pointArray, &ring](int i) -> const Point2D&
+	{
+		return pointArray[ring[i]];
+	};
+
+	auto isCorner = [](const Point2D& pointA, const Point2D& pointB)
+	{
+		return pointA.u == pointB.u && pointA.v == pointB.v;
+	};
+
+	int remaining = numVertices;
+	int misses = 0;
+	int i = 0;
+
+	while (remaining > 3)
+	{
+		int previous = previousArray[i];
+		int next = nextArray[i];
+
+		// A vertex in line with its neighbours is left for a later ear to take in, so that the cap
+		// still meets the facets cut along the same line at that vertex.
+		double area = Cross(point(previous), point(i), point(next));
+		bool isEar = (area > 0.0);
+
+		for (int j = nextArray[next]; isEar && j != previous; j = nextArray[j])
+		{
+			const Point2D& candidate = point(j);
+
+			if (isCorner(candidate, point(previous)) || isCorner(candidate, point(i)) || isCorner(candidate, point(next)))
+				continue;
+
+			if (Cross(point(previousArray[j]), candidate, point(nextArray[j])) > 0.0)
+				continue;
+
+			if (TriangleContainsPoint(point(previous), point(i), point(next), candidate))
+				isEar = false;
+		}
+
+		// If the ring is so degenerate that no ear can be found, we clip something anyway rather than go around forever.
+		if (!isEar && misses++ <= remaining)
+		{
+			i = next;
+			continue;
+		}
+
+		if (area > 0.0)
+		{
+			triangleArray.push_back(ring[previous]);
+			triangleArray.push_back(ring[i]);
+			triangleArray.push_back(ring[next]);
+		}
+
+		nextArray[previous] = next;
+		previousArray[next] = previous;
+		remaining--;
+		misses = 0;
+		i = previous;
+	}
+
+	int previous = previousArray[i];
+	int next = nextArray[i];
+
+	if (Cross(point(previous), point(i), point(next)) > 0.0)
+	{
+		triangleArray.push_back(ring[previous]);
+		triangleArray.push_back(ring[i]);
+		triangleArray.push_back(ring[next]);
+	}
+}
\ No newline at end of file
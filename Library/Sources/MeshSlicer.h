@@ -0,0 +1,95 @@
+#pragma once
+
+#include "Common.h"
+#include "Math/Vector3.h"
+#include "ConvexPolygon.h"
+#include "Polyline.h"
+
+namespace MeshNinja
+{
+	class ConvexPolygonMesh;
+	class Plane;
+
+	// This cuts a mesh with a family of parallel planes, as when preparing a model for additive manufacturing.
+	// The height of every vertex along the slicing direction is found once, the facets are sorted by the lowest
+	// of their heights, and then the layers are swept in order of height with only the facets spanning the
+	// current layer kept active.  Each thread sweeps its own contiguous range of layers.
+	//
+	// A vertex within tolerance of a slicing plane is always counted as being above it, so a facet crossing the
+	// plane does so through exactly two of its edges, and the facets on either side of an edge always agree on
+	// whether and where it's crossed.  The crossings are then linked into contours by the mesh edges they lie on
+	// rather than by their positions, so that the contours of a closed mesh are always closed.
+	class MESH_NINJA_API MeshSlicer
+	{
+	public:
+		MeshSlicer();
+		virtual ~MeshSlicer();
+
+		struct Layer
+		{
+			// The plane of this layer is the set of points whose dot product with the slicing direction is this.
+			double offset;
+
+			// Closed contours repeat their first vertex at the end.  Outer boundaries wind counter-clockwise
+			// about the slicing direction, and the boundaries of holes wind clockwise.
+			std::vector<Polyline> contourArray;
+
+			// A mesh that isn't closed can leave contours that don't close either.  These are left as found.
+			std::vector<Polyline> openContourArray;
+
+			// If capping was asked for, these triangles tile the region bounded by the closed contours,
+			// facing along the slicing direction.
+			std::vector<ConvexPolygon> capArray;
+		};
+
+		void Clear();
+		bool Slice(const ConvexPolygonMesh& mesh, const Vector3& normal, const std::vector<double>& offsetArray, int threadCount = 0);
+		bool SliceEvenly(const ConvexPolygonMesh& mesh, const Vector3& normal, double spacing, int threadCount = 0);
+		bool Split(const ConvexPolygonMesh& mesh, const Plane& plane, ConvexPolygonMesh& frontMesh, ConvexPolygonMesh& backMesh);
+
+		bool capContours;
+		double eps;
+		std::vector<Layer>* layerArray;
+		std::string* error;
+
+	protected:
+
+		struct Crossing
+		{
+			uint64_t key;
+			Vector3 point;
+		};
+
+		struct Segment
+		{
+			Crossing crossing[2];
+		};
+
+		struct Point2D
+		{
+			double u, v;
+		};
+
+		void Prepare(const ConvexPolygonMesh& mesh, const Vector3& normal);
+		bool IsBelow(int i, double offset) const;
+		Crossing CalcCrossing(int i, int j, double offset) const;
+		void CutFacet(int facet, double offset, std::vector<Segment>& segmentArray) const;
+		void BuildContours(Layer& layer, const std::vector<Segment>& segmentArray, bool cap) const;
+		void OrientContours(Layer& layer, std::vector<int>& parentArray) const;
+		void CapContours(Layer& layer, const std::vector<int>& parentArray) const;
+		Point2D Project(const Vector3& point) const;
+
+		static double Cross(const Point2D& pointA, const Point2D& pointB, const Point2D& pointC);
+		static bool TriangleContainsPoint(const Point2D& pointA, const Point2D& pointB, const Point2D& pointC, const Point2D& point);
+		static double CalcSignedArea(const std::vector<Point2D>& pointArray, const std::vector<int>& ring);
+		static bool RingContainsPoint(const std::vector<Point2D>& pointArray, const std::vector<int>& ring, const Point2D& point);
+		static void BridgeHole(const std::vector<Point2D>& pointArray, std::vector<int>& ring, const std::vector<int>& hole);
+		static void ClipEars(const std::vector<Point2D>& pointArray, const std::vector<int>& ring, std::vector<int>& triangleArray);
+
+		const ConvexPolygonMesh* mesh;
+		Vector3 normal;
+		Vector3 axisU;
+		Vector3 axisV;
+		std::vector<double>* heightArray;
+	};
+}
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "Plane.h"
+#include "Math/Predicates.h"
 
 using namespace MeshNinja;
 
@@ -42,6 +43,20 @@ Vector3 Plane::CalcCenter() const
 
 Plane::Side Plane::WhichSide(const Vector3& point, double eps /*= MESH_NINJA_EPS*/) const
 {
+	if (Predicates::GetMode() == Predicates::Mode::ADAPTIVE)
+	{
+		// Here the comparisons against the tolerance band are made exactly, so that a point is never
+		// classified one way by this test and the opposite way by another built on the same numbers.
+		// With a tolerance of zero, this is the exact side of the point.
+		if (Predicates::PlaneSide(this->normal, this->D, point, eps / 2.0) > 0.0)
+			return Side::FRONT;
+
+		if (Predicates::PlaneSide(this->normal, this->D, point, -eps / 2.0) < 0.0)
+			return Side::BACK;
+
+		return Side::NEITHER;
+	}
+
 	double signedDistance = this->SignedDistanceToPoint(point);
 	
 	if (signedDistance < -eps / 2.0)
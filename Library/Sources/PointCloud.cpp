@@ -1,227 +1,331 @@
 #include "PointCloud.h"
 #include "AxisAlignedBoundingBox.h"
+#include "TaskScheduler.h"
 
 using namespace MeshNinja;
 
+static inline double Component(const Vector3& vector, int axis)
+{
+	switch (axis)
+	{
+		case 0: return vector.x;
+		case 1: return vector.y;
+	}
+
+	return vector.z;
+}
+
 //----------------------------------- PointCloud -----------------------------------
 
 PointCloud::PointCloud()
 {
-	this->rootSpace = nullptr;
+	this->pointArray = new std::vector<Vector3>();
+	this->indexArray = new std::vector<int>();
+	this->nodeArray = new std::vector<Node>();
 }
 
 /*virtual*/ PointCloud::~PointCloud()
 {
-	this->Clear();
+	delete this->pointArray;
+	delete this->indexArray;
+	delete this->nodeArray;
 }
 
 void PointCloud::Clear()
 {
-	delete this->rootSpace;
-	this->rootSpace = nullptr;
+	this->pointArray->clear();
+	this->indexArray->clear();
+	this->nodeArray->clear();
 }
 
-void PointCloud::ToPointArray(std::vector<Vector3>& pointArray) const
+int PointCloud::Size() const
 {
-	if (this->rootSpace)
-		this->rootSpace->ToPointArray(pointArray);
+	return (int)this->pointArray->size();
 }
 
-void PointCloud::FromPointArray(const std::vector<Vector3>& pointArray, int maxPointsPerLeaf /*= 10*/)
+void PointCloud::ToPointArray(std::vector<Vector3>& pointArray) const
 {
-	this->Clear();
-
-	if ((signed)pointArray.size() > maxPointsPerLeaf)
-		this->rootSpace = new InternalNode();
-	else
-		this->rootSpace = new LeafNode();
-
-	this->rootSpace->FromPointArray(pointArray, maxPointsPerLeaf);
+	for (const Vector3& point : *this->pointArray)
+		pointArray.push_back(point);
 }
 
-const Vector3* PointCloud::FindNearestPoint(const Vector3& givenPoint, double& distance) const
+void PointCloud::FromPointArray(const std::vector<Vector3>& pointArray, int maxPointsPerLeaf /*= 10*/, int threadCount /*= 0*/)
 {
-	if (!this->rootSpace)
-		return nullptr;
+	this->Clear();
 
-	return this->rootSpace->FindNearestPoint(givenPoint, distance);
-}
+	*this->pointArray = pointArray;
 
-//----------------------------------- PointCloud::Node -----------------------------------
+	int numPoints = (int)pointArray.size();
+	this->indexArray->resize(numPoints);
+	for (int i = 0; i < numPoints; i++)
+		(*this->indexArray)[i] = i;
 
-PointCloud::Node::Node()
-{
-}
+	// Each level of the tree halves the ranges of the level above it, so all leaves are at the same depth.
+	int depth = 0;
+	maxPointsPerLeaf = MESH_NINJA_MAX(maxPointsPerLeaf, 1);
+	while (((int64_t)numPoints + (int64_t(1) << depth) - 1) >> depth > maxPointsPerLeaf)
+		depth++;
 
-/*virtual*/ PointCloud::Node::~Node()
-{
-}
+	this->nodeArray->resize((size_t(1) << (depth + 1)) - 1);
 
-//----------------------------------- PointCloud::InternalNode -----------------------------------
+	if (threadCount <= 0)
+		threadCount = TaskScheduler::Get()->GetThreadCount();
 
-PointCloud::InternalNode::InternalNode()
-{
-	this->backSpace = nullptr;
-	this->frontSpace = nullptr;
-}
+	int threadDepth = 0;
+	while ((1 << threadDepth) < threadCount && threadDepth < depth)
+		threadDepth++;
 
-/*virtual*/ PointCloud::InternalNode::~InternalNode()
-{
-	delete this->backSpace;
-	delete this->frontSpace;
+	this->Build(0, 0, numPoints, threadDepth);
 }
 
-/*virtual*/ void PointCloud::InternalNode::ToPointArray(std::vector<Vector3>& givenPointArray) const
+bool PointCloud::IsLeaf(int node) const
 {
-	if (this->backSpace)
-		this->backSpace->ToPointArray(givenPointArray);
-
-	if (this->frontSpace)
-		this->frontSpace->ToPointArray(givenPointArray);
+	return 2 * (size_t)node + 1 >= this->nodeArray->size();
 }
 
-void PointCloud::InternalNode::FromPointArray(const std::vector<Vector3>& givenPointArray, int maxPointsPerLeaf)
+void PointCloud::Build(int node, int begin, int end, int threadDepth)
 {
-	AxisAlignedBoundingBox box(givenPointArray[0]);
-	Vector3 averagePoint(0.0, 0.0, 0.0);
-	for (const Vector3& point : givenPointArray)
-	{
-		box.ExpandToIncludePoint(point);
-		averagePoint += point;
-	}
+	// Given how the depth was chosen, only leaves can ever have empty ranges.
+	if (this->IsLeaf(node))
+		return;
 
-	averagePoint /= double(givenPointArray.size());
+	const std::vector<Vector3>& points = *this->pointArray;
+	int* indices = this->indexArray->data();
 
-	double width = box.Width();
-	double height = box.Height();
-	double depth = box.Depth();
+	AxisAlignedBoundingBox box(points[indices[begin]]);
+	for (int i = begin + 1; i < end; i++)
+		box.ExpandToIncludePoint(points[indices[i]]);
 
-	double largestDimension = MESH_NINJA_MAX(width, MESH_NINJA_MAX(height, depth));
+	int axis = 0;
+	if (box.Height() > box.Width() && box.Height() >= box.Depth())
+		axis = 1;
+	else if (box.Depth() > box.Width() && box.Depth() > box.Height())
+		axis = 2;
 
-	if (largestDimension == width)
-		this->partitioningPlane = Plane(averagePoint, Vector3(1.0, 0.0, 0.0));
-	else if (largestDimension == height)
-		this->partitioningPlane = Plane(averagePoint, Vector3(0.0, 1.0, 0.0));
-	else if (largestDimension == depth)
-		this->partitioningPlane = Plane(averagePoint, Vector3(0.0, 0.0, 1.0));
+	int mid = (begin + end) / 2;
 
-	std::vector<Vector3> backPointArray, frontPointArray;
-
-	for (const Vector3& point : givenPointArray)
-	{
-		Plane::Side side = this->partitioningPlane.WhichSide(point, 0.0);
-		switch (side)
+	std::nth_element(indices + begin, indices + mid, indices + end, [&points, axis](int i, int j) -> bool
 		{
-			case Plane::Side::BACK:
-			{
-				backPointArray.push_back(point);
-				break;
-			}
-			case Plane::Side::FRONT:
-			case Plane::Side::NEITHER:
-			{
-				frontPointArray.push_back(point);
-				break;
-			}
-		}
-	}
+			return Component(points[i], axis) < Component(points[j], axis);
+		});
+
+	Node& treeNode = (*this->nodeArray)[node];
+	treeNode.axis = axis;
+	treeNode.split = Component(points[indices[mid]], axis);
 
-	if (backPointArray.size() > 0)
+	// The two halves don't share any nodes or indices, so they can be built at the same time.
+	if (threadDepth > 0)
 	{
-		this->backSpace = ((signed)backPointArray.size() < maxPointsPerLeaf) ? (Node*)new LeafNode() : (Node*)new InternalNode();
-		this->backSpace->FromPointArray(backPointArray, maxPointsPerLeaf);
+		TaskScheduler::TaskGroup taskGroup;
+		taskGroup.Run([this, node, begin, mid, threadDepth]()
+			{
+				this->Build(2 * node + 1, begin, mid, threadDepth - 1);
+			});
+		this->Build(2 * node + 2, mid, end, threadDepth - 1);
+		taskGroup.Wait();
 	}
-
-	if (frontPointArray.size() > 0)
+	else
 	{
-		this->frontSpace = ((signed)frontPointArray.size() < maxPointsPerLeaf) ? (Node*)new LeafNode() : (Node*)new InternalNode();
-		this->frontSpace->FromPointArray(frontPointArray, maxPointsPerLeaf);
+		this->Build(2 * node + 1, begin, mid, 0);
+		this->Build(2 * node + 2, mid, end, 0);
 	}
 }
 
-const Vector3* PointCloud::InternalNode::FindNearestPoint(const Vector3& givenPoint, double& distance) const
+// Visit the leaves of the tree nearest the given point first, skipping any whose region is further
+// away than the given bound.  The bound is re-evaluated as we go, since it typically shrinks.
+void PointCloud::ForNearbyLeaves(const Vector3& givenPoint, std::function<double()> boundSquared, std::function<void(int, int)> leafCallback, QueryStack& stack) const
 {
-	Plane::Side side = this->partitioningPlane.WhichSide(givenPoint);
+	if (this->nodeArray->size() == 0)
+		return;
 
-	Node* firstNode = nullptr;
-	Node* secondNode = nullptr;
+	std::vector<Range>& rangeStack = *stack.rangeArray;
+	rangeStack.clear();
+	rangeStack.push_back(Range{ 0, 0, (int)this->indexArray->size(), 0.0 });
 
-	switch (side)
+	while (rangeStack.size() > 0)
 	{
-		case Plane::Side::BACK:
+		Range range = rangeStack.back();
+		rangeStack.pop_back();
+
+		if (range.distanceSquared > boundSquared())
+			continue;
+
+		if (this->IsLeaf(range.node))
 		{
-			firstNode = this->backSpace;
-			secondNode = this->frontSpace;
-			break;
+			leafCallback(range.begin, range.end);
+			continue;
 		}
-		case Plane::Side::FRONT:
-		case Plane::Side::NEITHER:
+
+		const Node& node = (*this->nodeArray)[range.node];
+		int mid = (range.begin + range.end) / 2;
+		double delta = Component(givenPoint, node.axis) - node.split;
+
+		Range backRange{ 2 * range.node + 1, range.begin, mid, range.distanceSquared };
+		Range frontRange{ 2 * range.node + 2, mid, range.end, range.distanceSquared };
+
+		if (delta < 0.0)
 		{
-			firstNode = this->frontSpace;
-			secondNode = this->backSpace;
-			break;
+			frontRange.distanceSquared = MESH_NINJA_MAX(range.distanceSquared, delta * delta);
+			rangeStack.push_back(frontRange);
+			rangeStack.push_back(backRange);
 		}
-	}
-
-	double firstDistance = 0.0;
-	const Vector3* firstNearestPoint = firstNode->FindNearestPoint(givenPoint, firstDistance);
-	if (firstNearestPoint)
-	{
-		double distanceToPlane = ::abs(this->partitioningPlane.SignedDistanceToPoint(givenPoint));
-		if (distanceToPlane > firstDistance)
+		else
 		{
-			distance = firstDistance;
-			return firstNearestPoint;
+			backRange.distanceSquared = MESH_NINJA_MAX(range.distanceSquared, delta * delta);
+			rangeStack.push_back(backRange);
+			rangeStack.push_back(frontRange);
 		}
 	}
+}
 
-	double secondDistance = 0.0;
-	const Vector3* secondNearestPoint = secondNode->FindNearestPoint(givenPoint, secondDistance);
-	if (!secondNearestPoint || firstDistance < secondDistance)
-	{
-		distance = firstDistance;
-		return firstNearestPoint;
-	}
+const Vector3* PointCloud::FindNearestPoint(const Vector3& givenPoint, double& distance) const
+{
+	std::vector<int> foundIndexArray;
+	std::vector<double> distanceArray;
+
+	if (this->FindNearestPoints(givenPoint, 1, foundIndexArray, &distanceArray) == 0)
+		return nullptr;
 
-	distance = secondDistance;
-	return secondNearestPoint;
+	distance = distanceArray[0];
+	return &(*this->pointArray)[foundIndexArray[0]];
 }
 
-//----------------------------------- PointCloud::LeafNode -----------------------------------
+int PointCloud::FindNearestPoints(const Vector3& givenPoint, int k, std::vector<int>& foundIndexArray, std::vector<double>* distanceArray /*= nullptr*/) const
+{
+	QueryStack stack;
+	return this->FindNearestPoints(givenPoint, k, foundIndexArray, distanceArray, stack);
+}
 
-PointCloud::LeafNode::LeafNode()
+int PointCloud::FindNearestPoints(const Vector3& givenPoint, int k, std::vector<int>& foundIndexArray, std::vector<double>* distanceArray, QueryStack& stack) const
 {
+	foundIndexArray.clear();
+	if (distanceArray)
+		distanceArray->clear();
+
+	if (k <= 0)
+		return 0;
+
+	// This is a max-heap on distance, so that the furthest of the k nearest found so far is always on top.
+	std::vector<std::pair<double, int>>& heap = *stack.heap;
+	heap.clear();
+
+	const std::vector<Vector3>& points = *this->pointArray;
+	const std::vector<int>& indices = *this->indexArray;
+
+	this->ForNearbyLeaves(givenPoint,
+		[&heap, k]() -> double
+		{
+			return ((signed)heap.size() < k) ? DBL_MAX : heap.front().first;
+		},
+		[&heap, &points, &indices, &givenPoint, k](int begin, int end)
+		{
+			for (int i = begin; i < end; i++)
+			{
+				Vector3 delta = points[indices[i]] - givenPoint;
+				double distanceSquared = delta.Dot(delta);
+
+				if ((signed)heap.size() < k)
+				{
+					heap.push_back(std::pair<double, int>(distanceSquared, indices[i]));
+					std::push_heap(heap.begin(), heap.end());
+				}
+				else if (distanceSquared < heap.front().first)
+				{
+					std::pop_heap(heap.begin(), heap.end());
+					heap.back() = std::pair<double, int>(distanceSquared, indices[i]);
+					std::push_heap(heap.begin(), heap.end());
+				}
+			}
+		}, stack);
+
+	std::sort_heap(heap.begin(), heap.end());
+
+	for (const std::pair<double, int>& entry : heap)
+	{
+		foundIndexArray.push_back(entry.second);
+		if (distanceArray)
+			distanceArray->push_back(::sqrt(entry.first));
+	}
+
+	return (int)foundIndexArray.size();
 }
 
-/*virtual*/ PointCloud::LeafNode::~LeafNode()
+int PointCloud::FindPointsWithinRadius(const Vector3& givenPoint, double radius, std::vector<int>& foundIndexArray) const
 {
+	QueryStack stack;
+	return this->FindPointsWithinRadius(givenPoint, radius, foundIndexArray, stack);
 }
 
-/*virtual*/ void PointCloud::LeafNode::ToPointArray(std::vector<Vector3>& givenPointArray) const
+int PointCloud::FindPointsWithinRadius(const Vector3& givenPoint, double radius, std::vector<int>& foundIndexArray, QueryStack& stack) const
 {
-	for (const Vector3& point : this->pointArray)
-		givenPointArray.push_back(point);
+	foundIndexArray.clear();
+
+	double radiusSquared = radius * radius;
+
+	const std::vector<Vector3>& points = *this->pointArray;
+	const std::vector<int>& indices = *this->indexArray;
+
+	this->ForNearbyLeaves(givenPoint,
+		[radiusSquared]() -> double
+		{
+			return radiusSquared;
+		},
+		[&foundIndexArray, &points, &indices, &givenPoint, radiusSquared](int begin, int end)
+		{
+			for (int i = begin; i < end; i++)
+			{
+				Vector3 delta = points[indices[i]] - givenPoint;
+				if (delta.Dot(delta) <= radiusSquared)
+					foundIndexArray.push_back(indices[i]);
+			}
+		}, stack);
+
+	return (int)foundIndexArray.size();
 }
 
-/*virtual*/ void PointCloud::LeafNode::FromPointArray(const std::vector<Vector3>& givenPointArray, int maxPointsPerLeaf)
+void PointCloud::FindNearestPointsBatch(const std::vector<Vector3>& queryPointArray, int k, std::vector<int>& foundIndexArray, int threadCount /*= 0*/) const
 {
-	this->pointArray = givenPointArray;
+	foundIndexArray.assign(queryPointArray.size() * MESH_NINJA_MAX(k, 0), -1);
+
+	// It isn't worth handing out just a handful of queries at a time.
+	TaskScheduler::ParallelFor(0, (int)queryPointArray.size(), 64, [this, &queryPointArray, &foundIndexArray, k](int start, int stop)
+		{
+			std::vector<int> nearestIndexArray;
+			QueryStack stack;
+
+			for (int i = start; i < stop; i++)
+			{
+				this->FindNearestPoints(queryPointArray[i], k, nearestIndexArray, nullptr, stack);
+
+				for (int j = 0; j < (signed)nearestIndexArray.size(); j++)
+					foundIndexArray[i * k + j] = nearestIndexArray[j];
+			}
+		}, threadCount);
 }
 
-/*virtual*/ const Vector3* PointCloud::LeafNode::FindNearestPoint(const Vector3& givenPoint, double& distance) const
+void PointCloud::FindPointsWithinRadiusBatch(const std::vector<Vector3>& queryPointArray, double radius, std::vector<std::vector<int>>& foundIndexArrayArray, int threadCount /*= 0*/) const
 {
-	distance = DBL_MAX;
-	const Vector3* closestPoint = nullptr;
+	foundIndexArrayArray.resize(queryPointArray.size());
 
-	for (const Vector3& point : this->pointArray)
-	{
-		double otherDistance = (point - givenPoint).Length();
-		if (otherDistance < distance)
+	TaskScheduler::ParallelFor(0, (int)queryPointArray.size(), 64, [this, &queryPointArray, &foundIndexArrayArray, radius](int start, int stop)
 		{
-			distance = otherDistance;
-			closestPoint = &point;
-		}
-	}
+			QueryStack stack;
+
+			for (int i = start; i < stop; i++)
+				this->FindPointsWithinRadius(queryPointArray[i], radius, foundIndexArrayArray[i], stack);
+		}, threadCount);
+}
 
-	return closestPoint;
+//----------------------------------- PointCloud::QueryStack -----------------------------------
+
+PointCloud::QueryStack::QueryStack()
+{
+	this->rangeArray = new std::vector<Range>();
+	this->heap = new std::vector<std::pair<double, int>>();
+}
+
+/*virtual*/ PointCloud::QueryStack::~QueryStack()
+{
+	delete this->rangeArray;
+	delete this->heap;
 }
\ No newline at end of file
@@ -1,10 +1,15 @@
 #pragma once
 
 #include "Common.h"
-#include "Plane.h"
+#include "Math/Vector3.h"
 
 namespace MeshNinja
 {
+	// This is a k-d tree over a set of points.  It is built in place over a single array of point indices,
+	// each node splitting its range of that array at the median along the axis of greatest spread.  Since
+	// every split is at the median, the tree is balanced and can be stored implicitly: the children of node
+	// i are nodes 2i + 1 and 2i + 2, and a node's range of indices follows from its position in the tree.
+	// Queries refer to points by their index in the array originally given to FromPointArray.
 	class MESH_NINJA_API PointCloud
 	{
 	public:
@@ -12,52 +17,68 @@ namespace MeshNinja
 		virtual ~PointCloud();
 
 		void Clear();
+		int Size() const;
 		void ToPointArray(std::vector<Vector3>& pointArray) const;
-		void FromPointArray(const std::vector<Vector3>& pointArray, int maxPointsPerLeaf = 10);
+		// The tree is built by the given number of threads, or all hardware threads if zero.
+		void FromPointArray(const std::vector<Vector3>& pointArray, int maxPointsPerLeaf = 10, int threadCount = 0);
 
 		const Vector3* FindNearestPoint(const Vector3& givenPoint, double& distance) const;
+		int FindNearestPoints(const Vector3& givenPoint, int k, std::vector<int>& foundIndexArray, std::vector<double>* distanceArray = nullptr) const;
+		int FindPointsWithinRadius(const Vector3& givenPoint, double radius, std::vector<int>& foundIndexArray) const;
 
-		class Node
-		{
-		public:
-			Node();
-			virtual ~Node();
+		// The queries don't change anything, so the cloud can be queried from any number of threads at once, so long as
+		// nobody rebuilds it while they do.  These take a stack of the caller's own to keep the regions yet to be visited,
+		// so that a thread making many queries doesn't allocate once that stack has grown to size.
+		class QueryStack;
 
-			virtual void ToPointArray(std::vector<Vector3>& givenPointArray) const = 0;
-			virtual void FromPointArray(const std::vector<Vector3>& givenPointArray, int maxPointsPerLeaf) = 0;
-			virtual const Vector3* FindNearestPoint(const Vector3& givenPoint, double& distance) const = 0;
-		};
+		int FindNearestPoints(const Vector3& givenPoint, int k, std::vector<int>& foundIndexArray, std::vector<double>* distanceArray, QueryStack& stack) const;
+		int FindPointsWithinRadius(const Vector3& givenPoint, double radius, std::vector<int>& foundIndexArray, QueryStack& stack) const;
+
+		// These answer many queries at once, divided among the given number of threads (or all hardware threads if zero.)
+		// For k-nearest queries, the results for query i occupy entries [i * k, (i + 1) * k) of the returned array, nearest
+		// first, padded with -1 if there are fewer than k points in the cloud.
+		void FindNearestPointsBatch(const std::vector<Vector3>& queryPointArray, int k, std::vector<int>& foundIndexArray, int threadCount = 0) const;
+		void FindPointsWithinRadiusBatch(const std::vector<Vector3>& queryPointArray, double radius, std::vector<std::vector<int>>& foundIndexArrayArray, int threadCount = 0) const;
 
-		class InternalNode : public Node
+		const Vector3& operator[](int i) const
 		{
-		public:
-			InternalNode();
-			virtual ~InternalNode();
+			return (*this->pointArray)[i];
+		}
 
-			virtual void ToPointArray(std::vector<Vector3>& givenPointArray) const override;
-			virtual void FromPointArray(const std::vector<Vector3>& givenPointArray, int maxPointsPerLeaf) override;
-			virtual const Vector3* FindNearestPoint(const Vector3& givenPoint, double& distance) const override;
+	protected:
 
-			Plane partitioningPlane;
-			Node* backSpace;
-			Node* frontSpace;
+		struct Node
+		{
+			double split;
+			int axis;
 		};
 
-		class LeafNode : public Node
+		struct Range
 		{
-		public:
-			LeafNode();
-			virtual ~LeafNode();
+			int node;
+			int begin;
+			int end;
+			double distanceSquared;
+		};
 
-			virtual void ToPointArray(std::vector<Vector3>& givenPointArray) const override;
-			virtual void FromPointArray(const std::vector<Vector3>& givenPointArray, int maxPointsPerLeaf) override;
-			virtual const Vector3* FindNearestPoint(const Vector3& givenPoint, double& distance) const override;
+		void Build(int node, int begin, int end, int threadDepth);
+		bool IsLeaf(int node) const;
+		void ForNearbyLeaves(const Vector3& givenPoint, std::function<double()> boundSquared, std::function<void(int, int)> leafCallback, QueryStack& stack) const;
 
-			std::vector<Vector3> pointArray;
-		};
+		std::vector<Vector3>* pointArray;
+		std::vector<int>* indexArray;
+		std::vector<Node>* nodeArray;
 
-	protected:
+	public:
 
-		Node* rootSpace;
+		class MESH_NINJA_API QueryStack
+		{
+		public:
+			QueryStack();
+			virtual ~QueryStack();
+
+			std::vector<Range>* rangeArray;
+			std::vector<std::pair<double, int>>* heap;
+		};
 	};
 }
\ No newline at end of file
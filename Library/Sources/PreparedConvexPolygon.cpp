@@ -0,0 +1,354 @@
+#include "PreparedConvexPolygon.h"
+#include "Ray.h"
+
+using namespace MeshNinja;
+
+PreparedConvexPolygon::PreparedConvexPolygon()
+{
+	this->polygon = new ConvexPolygon();
+	this->vertexUArray = new std::vector<double>();
+	this->vertexVArray = new std::vector<double>();
+	this->edgeNormalUArray = new std::vector<double>();
+	this->edgeNormalVArray = new std::vector<double>();
+	this->edgeOffsetArray = new std::vector<double>();
+	this->eps = MESH_NINJA_EPS;
+	this->prepared = false;
+}
+
+PreparedConvexPolygon::PreparedConvexPolygon(const ConvexPolygon& polygon, double eps /*= MESH_NINJA_EPS*/) : PreparedConvexPolygon()
+{
+	this->Prepare(polygon, eps);
+}
+
+/*virtual*/ PreparedConvexPolygon::~PreparedConvexPolygon()
+{
+	delete this->polygon;
+	delete this->vertexUArray;
+	delete this->vertexVArray;
+	delete this->edgeNormalUArray;
+	delete this->edgeNormalVArray;
+	delete this->edgeOffsetArray;
+}
+
+void PreparedConvexPolygon::Clear()
+{
+	this->polygon->Clear();
+	this->vertexUArray->clear();
+	this->vertexVArray->clear();
+	this->edgeNormalUArray->clear();
+	this->edgeNormalVArray->clear();
+	this->edgeOffsetArray->clear();
+	this->plane = Plane();
+	this->prepared = false;
+}
+
+// If the polygon is degenerate, then we can still be queried, but every query just goes to the polygon itself.
+bool PreparedConvexPolygon::Prepare(const ConvexPolygon& polygon, double eps /*= MESH_NINJA_EPS*/)
+{
+	this->Clear();
+
+	*this->polygon->vertexArray = *polygon.vertexArray;
+	this->eps = eps;
+
+	if (!polygon.CalcPlane(this->plane, eps))
+		return false;
+
+	const std::vector<Vector3>& vertices = *polygon.vertexArray;
+	int numVertices = (signed)vertices.size();
+
+	bool foundAxis = false;
+	for (int i = 0; i < numVertices && !foundAxis; i++)
+	{
+		Vector3 edgeVector = vertices[(i + 1) % numVertices] - vertices[i];
+		this->axisU = edgeVector - this->plane.normal * edgeVector.Dot(this->plane.normal);
+		foundAxis = this->axisU.Normalize();
+	}
+
+	if (!foundAxis)
+		return false;
+
+	// With the basis right-handed about the normal, the vertices wind counter-clockwise in the plane.
+	this->axisV = this->plane.normal.Cross(this->axisU);
+
+	for (const Vector3& vertex : vertices)
+	{
+		double u = 0.0, v = 0.0;
+		this->Project(vertex, u, v);
+		this->vertexUArray->push_back(u);
+		this->vertexVArray->push_back(v);
+	}
+
+	for (int i = 0; i < numVertices; i++)
+	{
+		int j = (i + 1) % numVertices;
+
+		double deltaU = (*this->vertexUArray)[j] - (*this->vertexUArray)[i];
+		double deltaV = (*this->vertexVArray)[j] - (*this->vertexVArray)[i];
+		double length = ::sqrt(deltaU * deltaU + deltaV * deltaV);
+
+		if (length == 0.0)
+		{
+			// A degenerate edge shouldn't ever be the one that decides anything.
+			this->edgeNormalUArray->push_back(0.0);
+			this->edgeNormalVArray->push_back(0.0);
+			this->edgeOffsetArray->push_back(DBL_MAX);
+			continue;
+		}
+
+		double normalU = deltaV / length;
+		double normalV = -deltaU / length;
+
+		this->edgeNormalUArray->push_back(normalU);
+		this->edgeNormalVArray->push_back(normalV);
+		this->edgeOffsetArray->push_back(normalU * (*this->vertexUArray)[i] + normalV * (*this->vertexVArray)[i]);
+	}
+
+	this->prepared = true;
+	return true;
+}
+
+bool PreparedConvexPolygon::IsPrepared() const
+{
+	return this->prepared;
+}
+
+double PreparedConvexPolygon::GetTolerance() const
+{
+	return this->eps;
+}
+
+const ConvexPolygon& PreparedConvexPolygon::GetPolygon() const
+{
+	return *this->polygon;
+}
+
+const Plane& PreparedConvexPolygon::GetPlane() const
+{
+	return this->plane;
+}
+
+void PreparedConvexPolygon::Project(const Vector3& point, double& u, double& v) const
+{
+	Vector3 delta = point - (*this->polygon->vertexArray)[0];
+	u = delta.Dot(this->axisU);
+	v = delta.Dot(this->axisV);
+}
+
+double PreparedConvexPolygon::EdgeDistance(int i, double u, double v) const
+{
+	return (*this->edgeNormalUArray)[i] * u + (*this->edgeNormalVArray)[i] * v - (*this->edgeOffsetArray)[i];
+}
+
+// The diagonals from the first vertex cut the polygon into a fan of triangles, and the directions of
+// those diagonals are in order of angle, so we can binary search for the wedge of the fan holding the
+// given point.  The edge closing off that wedge is the one the point is most likely to be outside of.
+int PreparedConvexPolygon::FindFanEdge(double u, double v) const
+{
+	const std::vector<double>& vertexU = *this->vertexUArray;
+	const std::vector<double>& vertexV = *this->vertexVArray;
+	int numVertices = (signed)vertexU.size();
+
+	if (vertexU[1] * v - vertexV[1] * u < 0.0)
+		return 0;
+
+	if (vertexU[numVertices - 1] * v - vertexV[numVertices - 1] * u > 0.0)
+		return numVertices - 1;
+
+	int low = 1;
+	int high = numVertices - 1;
+	while (high - low > 1)
+	{
+		int mid = (low + high) / 2;
+		if (vertexU[mid] * v - vertexV[mid] * u >= 0.0)
+			low = mid;
+		else
+			high = mid;
+	}
+
+	return low;
+}
+
+// Every edge line of a convex polygon has the whole polygon behind it, so being well in front of any one
+// of them puts a point well away from the polygon.  Most points are decided by the wedge of the fan they
+// fall in: being well in front of its edge puts a point outside, and being well inside its triangle puts
+// a point well inside the polygon, since the triangle is part of the polygon.  Only points near the
+// diagonals or the first vertex have to be checked against every edge.
+PreparedConvexPolygon::Verdict PreparedConvexPolygon::Classify(double u, double v) const
+{
+	double margin = 2.0 * this->eps;
+	int numEdges = (signed)this->edgeOffsetArray->size();
+
+	int i = this->FindFanEdge(u, v);
+	double fanEdgeDistance = this->EdgeDistance(i, u, v);
+	if (fanEdgeDistance > margin)
+		return Verdict::OUTSIDE;
+
+	if (0 < i && i < numEdges - 1 && fanEdgeDistance < -margin)
+	{
+		// The wedge is bounded by the diagonals to vertices i and i + 1, and is to the left of the first and
+		// to the right of the second.
+		double lengthA = ::sqrt((*this->vertexUArray)[i] * (*this->vertexUArray)[i] + (*this->vertexVArray)[i] * (*this->vertexVArray)[i]);
+		double lengthB = ::sqrt((*this->vertexUArray)[i + 1] * (*this->vertexUArray)[i + 1] + (*this->vertexVArray)[i + 1] * (*this->vertexVArray)[i + 1]);
+
+		if (lengthA > 0.0 && lengthB > 0.0)
+		{
+			double depthA = ((*this->vertexUArray)[i] * v - (*this->vertexVArray)[i] * u) / lengthA;
+			double depthB = ((*this->vertexVArray)[i + 1] * u - (*this->vertexUArray)[i + 1] * v) / lengthB;
+
+			if (depthA > margin && depthB > margin)
+				return Verdict::INTERIOR;
+		}
+	}
+
+	double largestDistance = -DBL_MAX;
+	for (int j = 0; j < numEdges; j++)
+		largestDistance = MESH_NINJA_MAX(largestDistance, this->EdgeDistance(j, u, v));
+
+	if (largestDistance > margin)
+		return Verdict::OUTSIDE;
+
+	if (largestDistance < -margin)
+		return Verdict::INTERIOR;
+
+	return Verdict::UNDECIDED;
+}
+
+bool PreparedConvexPolygon::ResolveVerdict(Verdict verdict, const Vector3& point, bool* isInteriorPoint) const
+{
+	switch (verdict)
+	{
+		case Verdict::OUTSIDE:
+		{
+			if (isInteriorPoint)
+				*isInteriorPoint = false;
+
+			return false;
+		}
+		case Verdict::INTERIOR:
+		{
+			if (isInteriorPoint)
+				*isInteriorPoint = true;
+
+			return true;
+		}
+		case Verdict::UNDECIDED:
+		{
+			break;
+		}
+	}
+
+	return this->polygon->ContainsPoint(point, this->plane, isInteriorPoint, this->eps);
+}
+
+bool PreparedConvexPolygon::ContainsPoint(const Vector3& point, bool* isInteriorPoint /*= nullptr*/) const
+{
+	if (!this->prepared)
+		return this->polygon->ContainsPoint(point, isInteriorPoint, this->eps);
+
+	if (isInteriorPoint)
+		*isInteriorPoint = false;
+
+	if (this->plane.WhichSide(point, this->eps) != Plane::Side::NEITHER)
+		return false;
+
+	double u = 0.0, v = 0.0;
+	this->Project(point, u, v);
+
+	return this->ResolveVerdict(this->Classify(u, v), point, isInteriorPoint);
+}
+
+bool PreparedConvexPolygon::ContainsPointOnBoundary(const Vector3& point) const
+{
+	if (!this->prepared)
+		return this->polygon->ContainsPointOnBoundary(point, this->eps);
+
+	// The boundary is in the plane, so a point far from the plane is far from the boundary.
+	if (::fabs(this->plane.SignedDistanceToPoint(point)) > 2.0 * this->eps)
+		return false;
+
+	double u = 0.0, v = 0.0;
+	this->Project(point, u, v);
+
+	if (this->Classify(u, v) != Verdict::UNDECIDED)
+		return false;
+
+	return this->polygon->ContainsPointOnBoundary(point, this->eps);
+}
+
+bool PreparedConvexPolygon::IntersectWithLineSegment(const Vector3& pointA, const Vector3& pointB, Vector3& intersectionPoint) const
+{
+	if (!this->prepared)
+		return this->polygon->IntersectWithLineSegment(pointA, pointB, intersectionPoint, this->eps);
+
+	double alpha = 0.0;
+	Ray ray(pointA, pointB - pointA);
+	if (!ray.CastAgainst(this->plane, alpha))
+		return false;
+
+	if (-this->eps < alpha && alpha < 1.0 + this->eps)
+	{
+		intersectionPoint = ray.Lerp(alpha);
+		return true;
+	}
+
+	return false;
+}
+
+void PreparedConvexPolygon::ContainsPoints(const std::vector<Vector3>& pointArray, std::vector<bool>& containedArray, std::vector<bool>* interiorArray /*= nullptr*/) const
+{
+	int numPoints = (signed)pointArray.size();
+
+	containedArray.assign(numPoints, false);
+	if (interiorArray)
+		interiorArray->assign(numPoints, false);
+
+	std::vector<double> uArray(numPoints), vArray(numPoints);
+	std::vector<double> largestDistanceArray(numPoints, -DBL_MAX);
+
+	if (this->prepared)
+	{
+		for (int i = 0; i < numPoints; i++)
+			this->Project(pointArray[i], uArray[i], vArray[i]);
+
+		const double* u = uArray.data();
+		const double* v = vArray.data();
+		double* largestDistance = largestDistanceArray.data();
+
+		for (int i = 0; i < (signed)this->edgeOffsetArray->size(); i++)
+		{
+			double normalU = (*this->edgeNormalUArray)[i];
+			double normalV = (*this->edgeNormalVArray)[i];
+			double offset = (*this->edgeOffsetArray)[i];
+
+			for (int j = 0; j < numPoints; j++)
+			{
+				double distance = normalU * u[j] + normalV * v[j] - offset;
+				largestDistance[j] = (distance > largestDistance[j]) ? distance : largestDistance[j];
+			}
+		}
+	}
+
+	double margin = 2.0 * this->eps;
+
+	for (int i = 0; i < numPoints; i++)
+	{
+		const Vector3& point = pointArray[i];
+		bool isInteriorPoint = false;
+
+		if (!this->prepared)
+			containedArray[i] = this->polygon->ContainsPoint(point, &isInteriorPoint, this->eps);
+		else if (this->plane.WhichSide(point, this->eps) == Plane::Side::NEITHER)
+		{
+			Verdict verdict = Verdict::UNDECIDED;
+			if (largestDistanceArray[i] > margin)
+				verdict = Verdict::OUTSIDE;
+			else if (largestDistanceArray[i] < -margin)
+				verdict = Verdict::INTERIOR;
+
+			containedArray[i] = this->ResolveVerdict(verdict, point, &isInteriorPoint);
+		}
+
+		if (interiorArray)
+			(*interiorArray)[i] = isInteriorPoint;
+	}
+}
\ No newline at end of file
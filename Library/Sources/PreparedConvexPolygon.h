@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Common.h"
+#include "ConvexPolygon.h"
+#include "Plane.h"
+
+namespace MeshNinja
+{
+	// This answers the same queries as a ConvexPolygon does, but with everything those queries need
+	// worked out just once: the polygon's plane, an orthonormal basis for that plane, and the outward
+	// facing half-plane of each edge expressed in that basis.  Use it when one polygon is queried over
+	// and over again.  Points are classified against the half-planes with a margin of a couple of
+	// tolerances, and the few that fall within that margin are handed to the very same tests that
+	// ConvexPolygon uses, so the answers given here are always those it would give.
+	class MESH_NINJA_API PreparedConvexPolygon
+	{
+	public:
+		PreparedConvexPolygon();
+		PreparedConvexPolygon(const ConvexPolygon& polygon, double eps = MESH_NINJA_EPS);
+		virtual ~PreparedConvexPolygon();
+
+		void Clear();
+		bool Prepare(const ConvexPolygon& polygon, double eps = MESH_NINJA_EPS);
+		bool IsPrepared() const;
+		double GetTolerance() const;
+		const ConvexPolygon& GetPolygon() const;
+		const Plane& GetPlane() const;
+
+		// These all use the tolerance the polygon was prepared with.
+		bool ContainsPoint(const Vector3& point, bool* isInteriorPoint = nullptr) const;
+		bool ContainsPointOnBoundary(const Vector3& point) const;
+		bool IntersectWithLineSegment(const Vector3& pointA, const Vector3& pointB, Vector3& intersectionPoint) const;
+
+		// This is ContainsPoint for many points at once.  The points are projected into the plane once, and are
+		// then tested against one edge at a time.
+		void ContainsPoints(const std::vector<Vector3>& pointArray, std::vector<bool>& containedArray, std::vector<bool>* interiorArray = nullptr) const;
+
+	protected:
+
+		enum class Verdict
+		{
+			OUTSIDE,
+			INTERIOR,
+			UNDECIDED
+		};
+
+		void Project(const Vector3& point, double& u, double& v) const;
+		double EdgeDistance(int i, double u, double v) const;
+		int FindFanEdge(double u, double v) const;
+		Verdict Classify(double u, double v) const;
+		bool ResolveVerdict(Verdict verdict, const Vector3& point, bool* isInteriorPoint) const;
+
+		ConvexPolygon* polygon;
+		Plane plane;
+		Vector3 axisU;
+		Vector3 axisV;
+		double eps;
+		bool prepared;
+
+		// The vertices are given relative to the first vertex.  The signed distance of a point from
+		// edge i is edgeNormalU[i] * u + edgeNormalV[i] * v - edgeOffset[i], positive outside.
+		std::vector<double>* vertexUArray;
+		std::vector<double>* vertexVArray;
+		std::vector<double>* edgeNormalUArray;
+		std::vector<double>* edgeNormalVArray;
+		std::vector<double>* edgeOffsetArray;
+	};
+}
\ No newline at end of file
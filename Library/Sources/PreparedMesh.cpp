@@ -0,0 +1,141 @@
+#include "PreparedMesh.h"
+#include "ConvexPolygonMesh.h"
+#include "BoundingBoxTree.h"
+#include "MeshPointClassifier.h"
+
+using namespace MeshNinja;
+
+PreparedMesh::PreparedMesh()
+{
+	this->mesh = new ConvexPolygonMesh();
+	this->tree = new BoundingBoxTree();
+	this->classifier = new MeshPointClassifier();
+	this->vertexFacetArray = new std::vector<std::vector<int>>();
+	this->facetPlaneArray = new std::vector<Plane>();
+	this->prepared = false;
+}
+
+PreparedMesh::PreparedMesh(const ConvexPolygonMesh& mesh) : PreparedMesh()
+{
+	this->Prepare(mesh);
+}
+
+/*virtual*/ PreparedMesh::~PreparedMesh()
+{
+	delete this->mesh;
+	delete this->tree;
+	delete this->classifier;
+	delete this->vertexFacetArray;
+	delete this->facetPlaneArray;
+}
+
+void PreparedMesh::Clear()
+{
+	delete this->mesh;
+	this->mesh = new ConvexPolygonMesh();
+	this->tree->Clear();
+	this->classifier->Clear();
+	this->vertexFacetArray->clear();
+	this->facetPlaneArray->clear();
+	this->boundingBox = AxisAlignedBoundingBox();
+	this->prepared = false;
+}
+
+bool PreparedMesh::Prepare(const ConvexPolygonMesh& mesh)
+{
+	this->Clear();
+
+	delete this->mesh;
+	this->mesh = new ConvexPolygonMesh(mesh);
+
+	if (!this->classifier->Build(*this->mesh))
+		return false;
+
+	const std::vector<Vector3>& vertexArray = *this->mesh->vertexArray;
+	std::vector<BoundingBoxTree::Object*> objectArray;
+
+	this->vertexFacetArray->resize(vertexArray.size());
+	this->facetPlaneArray->resize(this->mesh->facetArray->size());
+
+	this->boundingBox = AxisAlignedBoundingBox(vertexArray[0]);
+	for (const Vector3& vertex : vertexArray)
+		this->boundingBox.ExpandToIncludePoint(vertex);
+
+	for (int i = 0; i < (signed)this->mesh->facetArray->size(); i++)
+	{
+		const ConvexPolygonMesh::Facet& facet = (*this->mesh->facetArray)[i];
+
+		AxisAlignedBoundingBox box(vertexArray[facet[0]]);
+		for (int j = 1; j < (signed)facet.vertexArray->size(); j++)
+			box.ExpandToIncludePoint(vertexArray[facet[j]]);
+
+		objectArray.push_back(new BoundingBoxTree::IndexedObject(i, box));
+
+		for (int j = 0; j < (signed)facet.vertexArray->size(); j++)
+			(*this->vertexFacetArray)[facet[j]].push_back(i);
+
+		ConvexPolygon polygon;
+		facet.MakePolygon(polygon, this->mesh);
+		polygon.CalcPlane((*this->facetPlaneArray)[i]);
+	}
+
+	this->tree->Rebuild(objectArray);
+
+	this->prepared = true;
+	return true;
+}
+
+bool PreparedMesh::IsPrepared() const
+{
+	return this->prepared;
+}
+
+const ConvexPolygonMesh& PreparedMesh::GetMesh() const
+{
+	return *this->mesh;
+}
+
+const MeshPointClassifier& PreparedMesh::GetClassifier() const
+{
+	return *this->classifier;
+}
+
+const AxisAlignedBoundingBox& PreparedMesh::GetBoundingBox() const
+{
+	return this->boundingBox;
+}
+
+const Plane& PreparedMesh::GetFacetPlane(int i) const
+{
+	return (*this->facetPlaneArray)[i];
+}
+
+void PreparedMesh::FindFacetsOverlapping(const AxisAlignedBoundingBox& box, std::vector<int>& facetArray) const
+{
+	facetArray.clear();
+
+	this->tree->ForOverlappingObjects(box, [&facetArray](BoundingBoxTree::Object* object) -> bool
+		{
+			facetArray.push_back(((BoundingBoxTree::IndexedObject*)object)->index);
+			return true;
+		});
+
+	std::sort(facetArray.begin(), facetArray.end());
+}
+
+void PreparedMesh::AddNeighboringFacets(std::vector<int>& facetArray) const
+{
+	int numFacets = (int)facetArray.size();
+
+	for (int i = 0; i < numFacets; i++)
+	{
+		const ConvexPolygonMesh::Facet& facet = (*this->mesh->facetArray)[facetArray[i]];
+
+		for (int j = 0; j < (signed)facet.vertexArray->size(); j++)
+			for (int k : (*this->vertexFacetArray)[facet[j]])
+				facetArray.push_back(k);
+	}
+
+	std::sort(facetArray.begin(), facetArray.end());
+	facetArray.erase(std::unique(facetArray.begin(), facetArray.end()), facetArray.end());
+}
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "Common.h"
+#include "AxisAlignedBoundingBox.h"
+#include "Plane.h"
+
+namespace MeshNinja
+{
+	class ConvexPolygonMesh;
+	class BoundingBoxTree;
+	class MeshPointClassifier;
+
+	// This holds what a set operation needs to know about one of its operands that doesn't change from one
+	// operation to the next, such as a large part that a small cutter is moved around and subtracted from.
+	// The facets of the mesh are put in a bounding-box tree, so that an operation can find those near the
+	// other operand without looking at the rest, the facets around each vertex are listed, the plane of each
+	// facet is found, and the mesh is made ready for inside/outside queries.  Only what's near the other
+	// operand then goes through the full operation, and everything else is just copied over.
+	class MESH_NINJA_API PreparedMesh
+	{
+	public:
+		PreparedMesh();
+		PreparedMesh(const ConvexPolygonMesh& mesh);
+		virtual ~PreparedMesh();
+
+		void Clear();
+		bool Prepare(const ConvexPolygonMesh& mesh);
+		bool IsPrepared() const;
+
+		const ConvexPolygonMesh& GetMesh() const;
+		const MeshPointClassifier& GetClassifier() const;
+		const AxisAlignedBoundingBox& GetBoundingBox() const;
+		const Plane& GetFacetPlane(int i) const;
+
+		// The facets are listed in the order they have in the mesh.
+		void FindFacetsOverlapping(const AxisAlignedBoundingBox& box, std::vector<int>& facetArray) const;
+
+		// This adds to the given facets every facet sharing a vertex with one of them, keeping them in order.
+		void AddNeighboringFacets(std::vector<int>& facetArray) const;
+
+	protected:
+		// This is only ever read through a const pointer, so that queries from many threads at once never
+		// count as writes to the arrays it shares with the mesh it was prepared from.
+		const ConvexPolygonMesh* mesh;
+		BoundingBoxTree* tree;
+		MeshPointClassifier* classifier;
+		std::vector<std::vector<int>>* vertexFacetArray;
+		std::vector<Plane>* facetPlaneArray;
+		AxisAlignedBoundingBox boundingBox;
+		bool prepared;
+	};
+}
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "Ray.h"
 #include "Plane.h"
 #include "ConvexPolygon.h"
+#include "PreparedConvexPolygon.h"
 #include "LineSegment.h"
 #include "AlgebraicSurface.h"
 #include "ConvexPolygonMesh.h"
@@ -70,14 +71,51 @@ bool Ray::CastAgainst(const ConvexPolygon& polygon, double& alpha, double eps /*
 
 	Plane plane;
 	polygon.CalcPlane(plane, eps);
-	if (this->direction.Dot(plane.normal) < eps && plane.WhichSide(this->origin) == Plane::Side::NEITHER)
+
+	bool hitEdge = false;
+	if (!this->CastAgainstPolygonPlane(*polygon.vertexArray, plane, alpha, hitEdge, eps))
+		return false;
+
+	if (hitEdge)
+		return true;
+
+	Vector3 hitPoint = this->Lerp(alpha);
+	return polygon.ContainsPoint(hitPoint, nullptr, eps);
+}
+
+bool Ray::CastAgainst(const PreparedConvexPolygon& polygon, double& alpha, double eps /*= MESH_NINJA_EPS*/) const
+{
+	if (polygon.ContainsPoint(this->origin))
+	{
+		alpha = 0.0;
+		return true;
+	}
+
+	bool hitEdge = false;
+	if (!this->CastAgainstPolygonPlane(*polygon.GetPolygon().vertexArray, polygon.GetPlane(), alpha, hitEdge, eps))
+		return false;
+
+	if (hitEdge)
+		return true;
+
+	Vector3 hitPoint = this->Lerp(alpha);
+	return polygon.ContainsPoint(hitPoint);
+}
+
+// A ray in the plane of a polygon hits it where it first crosses one of its edges, if it does.  Otherwise, this gives
+// where the ray hits the plane, and it's up to the caller to see if that's in the polygon.
+bool Ray::CastAgainstPolygonPlane(const std::vector<Vector3>& vertexArray, const Plane& plane, double& alpha, bool& hitEdge, double eps) const
+{
+	hitEdge = false;
+
+	if (this->direction.Dot(plane.normal) < eps && plane.WhichSide(this->origin, eps) == Plane::Side::NEITHER)
 	{
 		double smallestAlpha = DBL_MAX;
-		for (int i = 0; i < (signed)polygon.vertexArray->size(); i++)
+		for (int i = 0; i < (signed)vertexArray.size(); i++)
 		{
-			int j = (i + 1) % polygon.vertexArray->size();
-			const Vector3& vertexA = (*polygon.vertexArray)[i];
-			const Vector3& vertexB = (*polygon.vertexArray)[j];
+			int j = (i + 1) % vertexArray.size();
+			const Vector3& vertexA = vertexArray[i];
+			const Vector3& vertexB = vertexArray[j];
 			LineSegment line(vertexA, vertexB);
 			if (this->CastAgainst(line, alpha, eps) && alpha < smallestAlpha)
 				smallestAlpha = alpha;
@@ -86,15 +124,12 @@ bool Ray::CastAgainst(const ConvexPolygon& polygon, double& alpha, double eps /*
 		if (smallestAlpha != DBL_MAX)
 		{
 			alpha = smallestAlpha;
+			hitEdge = true;
 			return true;
 		}
 	}
-	
-	if (!this->CastAgainst(plane, alpha))
-		return false;
 
-	Vector3 hitPoint = this->Lerp(alpha);
-	return polygon.ContainsPoint(hitPoint, nullptr, eps);
+	return this->CastAgainst(plane, alpha, eps);
 }
 
 bool Ray::CastAgainst(const AlgebraicSurface& algebraicSurface, double& alpha,
@@ -103,30 +138,7 @@ bool Ray::CastAgainst(const AlgebraicSurface& algebraicSurface, double& alpha,
 								double initialStepSize /*= 1.0*/,
 								bool forwardOrBackward /*= false*/) const
 {
-	Vector3 unitDirection = this->direction.Normalized();
-	double signedStepSize = initialStepSize;
-	int iterationCount = 0;
-	Vector3 currentPoint(this->origin);
-
-	while (iterationCount++ < maxIterations)
-	{
-		double currentValue = algebraicSurface.Evaluate(currentPoint);
-		if (::fabs(currentValue) < eps)
-		{
-			alpha = this->LerpInverse(currentPoint);
-			return forwardOrBackward || alpha >= 0.0;
-		}
-
-		double currentDerivativeValue = algebraicSurface.EvaluateDirectionalDerivative(currentPoint, unitDirection * MESH_NINJA_SIGN(signedStepSize));
-		if (MESH_NINJA_SIGN(currentValue) == MESH_NINJA_SIGN(currentDerivativeValue))
-		{
-			signedStepSize = -signedStepSize / 2.0;
-		}
-
-		currentPoint += unitDirection * signedStepSize;
-	}
-
-	return false;
+	return algebraicSurface.CastRay(*this, alpha, eps, maxIterations, initialStepSize, forwardOrBackward);
 }
 
 // Of course, if the polygons of a mesh were thrown into a spacial sorting data-structure first,
@@ -8,6 +8,7 @@ namespace MeshNinja
 	class Vector3;
 	class Plane;
 	class ConvexPolygon;
+	class PreparedConvexPolygon;
 	class LineSegment;
 	class AlgebraicSurface;
 	class ConvexPolygonMesh;
@@ -23,6 +24,7 @@ namespace MeshNinja
 
 		bool CastAgainst(const Plane& plane, double& alpha, double eps = MESH_NINJA_EPS) const;
 		bool CastAgainst(const ConvexPolygon& polygon, double& alpha, double eps = MESH_NINJA_EPS) const;
+		bool CastAgainst(const PreparedConvexPolygon& polygon, double& alpha, double eps = MESH_NINJA_EPS) const;
 		bool CastAgainst(const LineSegment& lineSegment, double& alpha, double eps = MESH_NINJA_EPS) const;
 		bool CastAgainst(const AlgebraicSurface& algebraicSurface, double& alpha, double eps = MESH_NINJA_EPS, int maxIterations = 100, double initialStepSize = 1.0, bool forwardOrBackward = false) const;
 		bool CastAgainst(const ConvexPolygonMesh& mesh, double& alpha, double eps = MESH_NINJA_EPS) const;
@@ -34,5 +36,9 @@ namespace MeshNinja
 
 		Vector3 origin;
 		Vector3 direction;
+
+	protected:
+
+		bool CastAgainstPolygonPlane(const std::vector<Vector3>& vertexArray, const Plane& plane, double& alpha, bool& hitEdge, double eps) const;
 	};
 }
\ No newline at end of file
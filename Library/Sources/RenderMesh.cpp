@@ -2,44 +2,35 @@
 #include "Plane.h"
 #include "ConvexPolygonMesh.h"
 #include "AxisAlignedBoundingBox.h"
+#include "FacetTriangulator.h"
+#include "TaskScheduler.h"
 
 using namespace MeshNinja;
 
 RenderMesh::RenderMesh()
 {
-	this->facetArray = new std::vector<Facet>();
-	this->vertexArray = new std::vector<Vertex>();
 }
 
 RenderMesh::RenderMesh(const RenderMesh& renderMesh)
 {
-	this->facetArray = new std::vector<Facet>();
-	this->vertexArray = new std::vector<Vertex>();
-
 	this->Copy(renderMesh);
 }
 
 /*virtual*/ RenderMesh::~RenderMesh()
 {
-	delete this->facetArray;
-	delete this->vertexArray;
 }
 
+// The arrays are shared with the given mesh until one or the other of us changes them.
 void RenderMesh::Copy(const RenderMesh& renderMesh)
 {
-	this->Clear();
-
-	for (const Vertex& vertex : *renderMesh.vertexArray)
-		this->vertexArray->push_back(vertex);
-
-	for (const Facet& facet : *renderMesh.facetArray)
-		this->facetArray->push_back(facet);
+	this->facetArray = renderMesh.facetArray;
+	this->vertexArray = renderMesh.vertexArray;
 }
 
 void RenderMesh::Clear()
 {
-	this->facetArray->clear();
-	this->vertexArray->clear();
+	this->facetArray.Clear();
+	this->vertexArray.Clear();
 }
 
 bool RenderMesh::IsTriangleMesh() const
@@ -109,6 +100,12 @@ void RenderMesh::FromConvexPolygonMesh(const ConvexPolygonMesh& mesh, const Opti
 {
 	this->Clear();
 
+	if (options.triangulate)
+	{
+		this->FromTriangulatedConvexPolygonMesh(mesh, options);
+		return;
+	}
+
 	int vertexCounter = 0;
 
 	for (const ConvexPolygonMesh::Facet& facet : *mesh.facetArray)
@@ -191,6 +188,94 @@ void RenderMesh::FromConvexPolygonMesh(const ConvexPolygonMesh& mesh, const Opti
 	}
 }
 
+// This gives what tessellating the mesh first would, with the default tolerance, without making the tessellated mesh.
+// The triangles all go into a single index array, and since the place of each facet's triangles in it is known, and so
+// that of their render facets and vertices, the facets are all gone through in parallel, each writing only its own.
+void RenderMesh::FromTriangulatedConvexPolygonMesh(const ConvexPolygonMesh& mesh, const Options& options)
+{
+	FacetTriangulator triangulator;
+	std::vector<uint32_t> indexArray;
+	std::vector<int> triangleOffsetArray;
+	triangulator.Triangulate(mesh, indexArray, &triangleOffsetArray, options.threadCount);
+	FacetTriangulator::RemoveSmallTriangles(*mesh.vertexArray, indexArray, &triangleOffsetArray);
+
+	int numFacets = (int)mesh.facetArray->size();
+	int numTriangles = triangleOffsetArray[numFacets];
+	bool vertexBased = (options.normalType == Options::NormalType::VERTEX_BASED);
+
+	this->facetArray->resize(numTriangles);
+	this->vertexArray->resize(vertexBased ? mesh.vertexArray->size() : 3 * numTriangles);
+
+	std::vector<Facet>& renderFacetArray = *this->facetArray;
+	std::vector<Vertex>& renderVertexArray = *this->vertexArray;
+
+	TaskScheduler::ParallelFor(0, numFacets, 256, [&mesh, &options, &indexArray, &triangleOffsetArray, &renderFacetArray, &renderVertexArray, vertexBased](int start, int stop)
+		{
+			for (int i = start; i < stop; i++)
+			{
+				if (triangleOffsetArray[i] == triangleOffsetArray[i + 1])
+					continue;
+
+				ConvexPolygon polygon;
+				(*mesh.facetArray)[i].MakePolygon(polygon, &mesh);
+
+				Plane plane;
+				polygon.CalcPlane(plane);
+
+				for (int j = triangleOffsetArray[i]; j < triangleOffsetArray[i + 1]; j++)
+				{
+					const uint32_t* triangle = &indexArray[3 * j];
+					Facet& renderFacet = renderFacetArray[j];
+
+					renderFacet.normal = plane.normal;
+					renderFacet.color = Vector3(1.0, 1.0, 1.0);
+					renderFacet.center = Vector3(0.0, 0.0, 0.0);
+					renderFacet.vertexArray->resize(3);
+
+					for (int k = 0; k < 3; k++)
+					{
+						const Vector3& vertex = (*mesh.vertexArray)[triangle[k]];
+						renderFacet.center += vertex;
+
+						if (vertexBased)
+							(*renderFacet.vertexArray)[k] = int(triangle[k]);
+						else
+						{
+							(*renderFacet.vertexArray)[k] = 3 * j + k;
+
+							Vertex& renderVertex = renderVertexArray[3 * j + k];
+							renderVertex.position = vertex;
+							renderVertex.normal = plane.normal;
+							renderVertex.color = options.color;
+							renderVertex.texCoords = Vector3(0.0, 0.0, 0.0);
+						}
+					}
+
+					renderFacet.center /= 3.0;
+				}
+			}
+		}, options.threadCount);
+
+	if (vertexBased)
+	{
+		for (int i = 0; i < (signed)renderVertexArray.size(); i++)
+		{
+			Vertex& renderVertex = renderVertexArray[i];
+			renderVertex.position = (*mesh.vertexArray)[i];
+			renderVertex.normal = Vector3(0.0, 0.0, 0.0);
+			renderVertex.color = options.color;
+			renderVertex.texCoords = Vector3(0.0, 0.0, 0.0);
+		}
+
+		for (const Facet& facet : renderFacetArray)
+			for (int i = 0; i < 3; i++)
+				renderVertexArray[facet[i]].normal += facet.normal;
+
+		for (Vertex& renderVertex : renderVertexArray)
+			renderVertex.normal.Normalize();
+	}
+}
+
 void RenderMesh::ToConvexPolygonMesh(ConvexPolygonMesh& mesh) const
 {
 	// TODO: Write this.
@@ -198,16 +283,10 @@ void RenderMesh::ToConvexPolygonMesh(ConvexPolygonMesh& mesh) const
 
 RenderMesh::Facet::Facet()
 {
-	this->vertexArray = new std::vector<int>();
 }
 
-RenderMesh::Facet::Facet(const Facet& facet)
+RenderMesh::Facet::Facet(const Facet& facet) : vertexArray(facet.vertexArray)
 {
-	this->vertexArray = new std::vector<int>();
-
-	for (int i : *facet.vertexArray)
-		this->vertexArray->push_back(i);
-
 	this->color = facet.color;
 	this->normal = facet.normal;
 	this->center = facet.center;
@@ -215,7 +294,14 @@ RenderMesh::Facet::Facet(const Facet& facet)
 
 /*virtual*/ RenderMesh::Facet::~Facet()
 {
-	delete this->vertexArray;
+}
+
+void RenderMesh::Facet::operator=(const Facet& facet)
+{
+	this->vertexArray = facet.vertexArray;
+	this->color = facet.color;
+	this->normal = facet.normal;
+	this->center = facet.center;
 }
 
 RenderMesh::Vertex::Vertex()
@@ -3,6 +3,7 @@
 #include "Common.h"
 #include "Math/Vector3.h"
 #include "Math/Transform.h"
+#include "SharedBuffer.h"
 
 namespace MeshNinja
 {
@@ -32,10 +33,16 @@ namespace MeshNinja
 			{
 				this->normalType = NormalType::FACET_BASED;
 				this->color = Vector3(1.0, 0.0, 0.0);
+				this->triangulate = false;
+				this->threadCount = 0;
 			}
 
 			NormalType normalType;
 			Vector3 color;
+
+			// If this is set, each facet is cut into triangles, which are made into render facets of their own.
+			bool triangulate;
+			int threadCount;
 		};
 
 		void Clear();
@@ -54,12 +61,14 @@ namespace MeshNinja
 			Facet(const Facet& facet);
 			virtual ~Facet();
 
+			void operator=(const Facet& facet);
+
 			int operator[](int i) const
 			{
 				return (*this->vertexArray)[i];
 			}
 
-			std::vector<int>* vertexArray;
+			SharedBuffer<int> vertexArray;
 			Vector3 color;
 			Vector3 normal;
 			Vector3 center;
@@ -77,7 +86,11 @@ namespace MeshNinja
 			Vector3 texCoords;
 		};
 
-		std::vector<Facet>* facetArray;
-		std::vector<Vertex>* vertexArray;
+		SharedBuffer<Facet> facetArray;
+		SharedBuffer<Vertex> vertexArray;
+
+	protected:
+
+		void FromTriangulatedConvexPolygonMesh(const ConvexPolygonMesh& mesh, const Options& options);
 	};
 }
\ No newline at end of file
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "Common.h"
+#include <atomic>
+
+namespace MeshNinja
+{
+	// This is an array that copies of it share until one of them is written to, at which point that copy gets an
+	// array of its own.  It's used just like a pointer to a std::vector, so that copying whatever holds one is cheap
+	// no matter how big the array is.  Any access through a non-const buffer counts as a write, since there's no
+	// telling what will be done with it, so code that only reads should do so through a const reference.
+	//
+	// The count of sharers is atomic, so different buffers sharing an array may be copied, released and written on
+	// different threads.  A single buffer, though, must only be read through const access by threads running at the
+	// same time, since non-const access may detach it, which is a write to the buffer itself.  Also, a reference into
+	// the array mustn't be written through after the buffer has been copied, because the array would then still be
+	// shared.
+	template<typename T>
+	class SharedBuffer
+	{
+	public:
+		SharedBuffer()
+		{
+			this->block = new Block();
+		}
+
+		SharedBuffer(const SharedBuffer& buffer)
+		{
+			this->block = buffer.block;
+			this->block->shareCount++;
+		}
+
+		~SharedBuffer()
+		{
+			this->Release();
+		}
+
+		void operator=(const SharedBuffer& buffer)
+		{
+			if (this->block != buffer.block)
+			{
+				buffer.block->shareCount++;
+				this->Release();
+				this->block = buffer.block;
+			}
+		}
+
+		const std::vector<T>* operator->() const
+		{
+			return &this->block->array;
+		}
+
+		const std::vector<T>& operator*() const
+		{
+			return this->block->array;
+		}
+
+		std::vector<T>* operator->()
+		{
+			this->Detach();
+			return &this->block->array;
+		}
+
+		std::vector<T>& operator*()
+		{
+			this->Detach();
+			return this->block->array;
+		}
+
+		// This trades arrays with the given buffer without touching either's count of sharers.
+		void Swap(SharedBuffer& buffer)
+		{
+			std::swap(this->block, buffer.block);
+		}
+
+		bool IsShared() const
+		{
+			return this->block->shareCount.load(std::memory_order_acquire) > 1;
+		}
+
+		// Rather than copying a shared array only to empty it, this just lets go of it.
+		void Clear()
+		{
+			if (this->IsShared())
+			{
+				this->Release();
+				this->block = new Block();
+			}
+			else
+				this->block->array.clear();
+		}
+
+	private:
+
+		struct Block
+		{
+			std::vector<T> array;
+			std::atomic<int> shareCount = 1;
+		};
+
+		void Detach()
+		{
+			if (this->IsShared())
+			{
+				Block* block = new Block();
+				block->array = this->block->array;
+				this->Release();
+				this->block = block;
+			}
+		}
+
+		void Release()
+		{
+			if (this->block->shareCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				delete this->block;
+		}
+
+		Block* block;
+	};
+}
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "SpaceCurve.h"
 #include "ConvexPolygonMesh.h"
+#include "TubeSweeper.h"
 
 using namespace MeshNinja;
 
@@ -7,65 +8,158 @@ using namespace MeshNinja;
 
 SpaceCurve::SpaceCurve()
 {
+	this->arcLengthTable = new ArcLengthTable();
 }
 
 /*virtual*/ SpaceCurve::~SpaceCurve()
 {
+	delete this->arcLengthTable;
 }
 
+// This finds where the length of the curve from the given parameter reaches the given length, by Newton's method, where
+// the derivative of the length is the speed of the curve.  If that's past the end of the curve, we stop at the end.
 /*virtual*/ double SpaceCurve::AdvanceByCurveLength(double t, double length, double eps /*= MESH_NINJA_EPS*/) const
 {
-	Vector3 startingPoint = this->Evaluate(t);
-	double dt = length / 2.0;
-	while (true)
+	if (this->arcLengthTable->IsBuilt())
 	{
-		t += dt;
-		Vector3 endingPoint = this->Evaluate(t);
-		double currentLength = (endingPoint - startingPoint).Length();
-		if (::fabs(currentLength - length) < eps)
+		double targetLength = this->arcLengthTable->LengthAt(t) + length;
+		if (targetLength >= this->arcLengthTable->GetLength())
+			return 1.0;
+
+		return this->arcLengthTable->ParameterAt(targetLength);
+	}
+
+	double speed = this->CalculateSpeed(t);
+	if (speed == 0.0)
+		return t;
+
+	double tA = t;
+	double tB = MESH_NINJA_MIN(t + length / speed, 1.0);
+
+	for (int i = 0; i < 32; i++)
+	{
+		double error = this->IntegrateSpeed(tA, tB) - length;
+		if (::fabs(error) < eps)
 			break;
 
-		if (currentLength > length)
-		{
-			t -= dt;
-			dt *= 0.5;
-		}
-		else if (t > 1.0)
-		{
-			t = 1.0;
+		if (tB == 1.0 && error < 0.0)
 			break;
-		}
+
+		speed = this->CalculateSpeed(tB);
+		if (speed == 0.0)
+			break;
+
+		tB = MESH_NINJA_CLAMP(tB - error / speed, tA, 1.0);
 	}
 
-	return t;
+	return tB;
 }
 
+// The step is small enough to be accurate, but not so small that rounding takes over.  At the ends of the curve,
+// we can't look past the end, so the difference is one-sided there.
 /*virtual*/ Vector3 SpaceCurve::EvaluateDerivative(double t) const
 {
-	double dt = MESH_NINJA_EPS;
-	return (this->Evaluate(t + dt) - this->Evaluate(t - dt)) / (2.0 * dt);
+	double dt = 1e-5;
+	double tA = MESH_NINJA_MAX(t - dt, 0.0);
+	double tB = MESH_NINJA_MIN(t + dt, 1.0);
+	return (this->Evaluate(tB) - this->Evaluate(tA)) / (tB - tA);
 }
 
 /*virtual*/ Vector3 SpaceCurve::EvaluateSecondDerivative(double t) const
 {
-	double dt = MESH_NINJA_EPS;
-	return (this->EvaluateDerivative(t + dt) - this->EvaluateDerivative(t - dt)) / (2.0 * dt);
+	double dt = 1e-4;
+	double tA = MESH_NINJA_MAX(t - dt, 0.0);
+	double tB = MESH_NINJA_MIN(t + dt, 1.0);
+	return (this->EvaluateDerivative(tB) - this->EvaluateDerivative(tA)) / (tB - tA);
 }
 
-double SpaceCurve::CalculateLength() const
+/*virtual*/ void SpaceCurve::EvaluateBatch(const double* t, double* x, double* y, double* z, int count) const
+{
+	for (int i = 0; i < count; i++)
+	{
+		Vector3 point = this->Evaluate(t[i]);
+		x[i] = point.x;
+		y[i] = point.y;
+		z[i] = point.z;
+	}
+}
+
+/*virtual*/ void SpaceCurve::EvaluateDerivativeBatch(const double* t, double* x, double* y, double* z, int count) const
 {
-	// A more accurate algorithm here would have an adaptive step size.
-	double length = 0.0;
-	double dt = 0.001;
-	Vector3 pointA = this->Evaluate(0.0);
-	for (double t = dt; t <= 1.0; t += dt)
+	for (int i = 0; i < count; i++)
 	{
-		Vector3 pointB = this->Evaluate(t);
-		length += (pointB - pointA).Length();
-		pointA = pointB;
+		Vector3 derivative = this->EvaluateDerivative(t[i]);
+		x[i] = derivative.x;
+		y[i] = derivative.y;
+		z[i] = derivative.z;
 	}
+}
+
+double SpaceCurve::CalculateSpeed(double t) const
+{
+	return this->EvaluateDerivative(t).Length();
+}
+
+// This is five-point Gauss-Legendre quadrature, which is exact for polynomials up to degree nine.
+double SpaceCurve::IntegrateSpeed(double tA, double tB) const
+{
+	static const double nodeArray[5] = { 0.0, -0.5384693101056831, 0.5384693101056831, -0.9061798459386640, 0.9061798459386640 };
+	static const double weightArray[5] = { 0.5688888888888889, 0.4786286704993665, 0.4786286704993665, 0.2369268850561891, 0.2369268850561891 };
+
+	double halfWidth = (tB - tA) / 2.0;
+	double middle = (tA + tB) / 2.0;
+
+	double t[5], x[5], y[5], z[5];
+	for (int i = 0; i < 5; i++)
+		t[i] = middle + halfWidth * nodeArray[i];
+
+	this->EvaluateDerivativeBatch(t, x, y, z, 5);
+
+	double sum = 0.0;
+	for (int i = 0; i < 5; i++)
+		sum += weightArray[i] * ::sqrt(x[i] * x[i] + y[i] * y[i] + z[i] * z[i]);
+
+	return sum * halfWidth;
+}
+
+double SpaceCurve::CalculateLength() const
+{
+	if (this->arcLengthTable->IsBuilt())
+		return this->arcLengthTable->GetLength();
+
+	ArcLengthTable arcLengthTable;
+	arcLengthTable.Build(this);
+	return arcLengthTable.GetLength();
+}
+
+void SpaceCurve::BuildArcLengthTable(double eps /*= 1e-8*/)
+{
+	this->arcLengthTable->Build(this, eps);
+}
+
+void SpaceCurve::ClearArcLengthTable()
+{
+	this->arcLengthTable->Clear();
+}
+
+double SpaceCurve::CalculateLengthAt(double t) const
+{
+	if (this->arcLengthTable->IsBuilt())
+		return this->arcLengthTable->LengthAt(t);
 
-	return length;
+	ArcLengthTable arcLengthTable;
+	arcLengthTable.Build(this);
+	return arcLengthTable.LengthAt(t);
+}
+
+double SpaceCurve::CalculateParameterAt(double length) const
+{
+	if (this->arcLengthTable->IsBuilt())
+		return this->arcLengthTable->ParameterAt(length);
+
+	ArcLengthTable arcLengthTable;
+	arcLengthTable.Build(this);
+	return arcLengthTable.ParameterAt(length);
 }
 
 void SpaceCurve::CalculateFrame(double t, Vector3& tangent, Vector3& normal, Vector3& binormal) const
@@ -80,80 +174,195 @@ void SpaceCurve::CalculateFrame(double t, Vector3& tangent, Vector3& normal, Vec
 	binormal = tangent.Cross(normal);
 }
 
+// The ends of the tube are left open.
 void SpaceCurve::GenerateTubeMesh(ConvexPolygonMesh& mesh, double stepLength, int sides, std::function<double(double)> radiusFunction) const
 {
-	std::vector<std::vector<Vector3>> vertexData;
+	TubeSweeper tubeSweeper;
+	tubeSweeper.capEnds = false;
 
-	double t = 0.0;
-	while (t <= 1.0)
+	if (this->AddTubePath(tubeSweeper, stepLength, sides, radiusFunction))
+		tubeSweeper.GenerateMesh(mesh);
+	else
+		mesh.Clear();
+}
+
+// The rings go at even steps of length along the curve, and then at the very end, the step before that being left
+// out if it would be less than half a step from the end.  Each ring is at right angles to the curve where it is, so
+// this gives the tangents there along with the points.
+bool SpaceCurve::AddTubePath(TubeSweeper& tubeSweeper, double stepLength, int sides, std::function<double(double)> radiusFunction) const
+{
+	const ArcLengthTable* table = this->arcLengthTable;
+	ArcLengthTable localTable;
+	if (!table->IsBuilt())
 	{
-		double radius = radiusFunction(t);	// Should probably have passed in 'lengthCovered', not 't'.
+		localTable.Build(this);
+		table = &localTable;
+	}
 
-		Vector3 curvePoint = this->Evaluate(t);
-		Vector3 xAxis, yAxis, zAxis;
-		this->CalculateFrame(t, zAxis, yAxis, xAxis);
-		xAxis.Normalize();
-		yAxis.Normalize();
+	std::vector<double> parameterArray;
+	parameterArray.push_back(0.0);
+	double totalLength = table->GetLength();
+	for (double length = stepLength; length < totalLength - 0.5 * stepLength && stepLength > 0.0; length += stepLength)
+		parameterArray.push_back(table->ParameterAt(length));
+	parameterArray.push_back(1.0);
 
-		vertexData.push_back(std::vector<Vector3>());
-		std::vector<Vector3>& vertexArray = vertexData.back();
+	int numRings = (int)parameterArray.size();
+	std::vector<double> xArray(numRings), yArray(numRings), zArray(numRings);
+	std::vector<double> dxArray(numRings), dyArray(numRings), dzArray(numRings);
+	this->EvaluateBatch(parameterArray.data(), xArray.data(), yArray.data(), zArray.data(), numRings);
+	this->EvaluateDerivativeBatch(parameterArray.data(), dxArray.data(), dyArray.data(), dzArray.data(), numRings);
 
-		for (int i = 0; i < sides; i++)
-		{
-			double angle = -(double(i) / double(sides)) * MESH_NINJA_TWO_PI;
-			Vector3 vertex = curvePoint + xAxis * radius * ::cos(angle) + yAxis * radius * ::sin(angle);
-			vertexArray.push_back(vertex);
-		}
+	std::vector<Vector3> pointArray(numRings), tangentArray(numRings);
+	std::vector<double> radiusArray(numRings);
 
-		if (t == 1.0)
-			break;
+	for (int k = 0; k < numRings; k++)
+	{
+		pointArray[k] = Vector3(xArray[k], yArray[k], zArray[k]);
+		tangentArray[k] = Vector3(dxArray[k], dyArray[k], dzArray[k]);
+		radiusArray[k] = radiusFunction(parameterArray[k]);	// Should probably have passed in 'lengthCovered', not 't'.
+	}
+
+	return tubeSweeper.AddPath(pointArray, tangentArray, radiusArray, sides);
+}
+
+//------------------------------------ SpaceCurve::ArcLengthTable ------------------------------------
+
+SpaceCurve::ArcLengthTable::ArcLengthTable()
+{
+	this->curve = nullptr;
+	this->sampleArray = new std::vector<Sample>();
+}
 
-		t = this->AdvanceByCurveLength(t, stepLength);
+/*virtual*/ SpaceCurve::ArcLengthTable::~ArcLengthTable()
+{
+	delete this->sampleArray;
+}
+
+void SpaceCurve::ArcLengthTable::Clear()
+{
+	this->curve = nullptr;
+	this->sampleArray->clear();
+}
+
+bool SpaceCurve::ArcLengthTable::IsBuilt() const
+{
+	return this->sampleArray->size() > 0;
+}
+
+// We start from a handful of even pieces, so that no feature of the curve is missed by sheer bad luck, and split those
+// that need it.  The last sample is the end of the curve, and so holds its total length.
+void SpaceCurve::ArcLengthTable::Build(const SpaceCurve* curve, double eps /*= 1e-8*/)
+{
+	this->Clear();
+	this->curve = curve;
+
+	const int numPieces = 16;
+
+	double lengthArray[numPieces];
+	double totalLength = 0.0;
+	for (int i = 0; i < numPieces; i++)
+	{
+		lengthArray[i] = curve->IntegrateSpeed(double(i) / double(numPieces), double(i + 1) / double(numPieces));
+		totalLength += lengthArray[i];
 	}
 
-	std::vector<ConvexPolygon> polygonArray;
+	double tolerance = eps * MESH_NINJA_MAX(totalLength, 1e-12) / double(numPieces);
+
+	this->sampleArray->push_back(Sample{ 0.0, 0.0 });
+
+	for (int i = 0; i < numPieces; i++)
+		this->BuildPiece(double(i) / double(numPieces), double(i + 1) / double(numPieces), lengthArray[i], tolerance, 0);
+}
+
+void SpaceCurve::ArcLengthTable::BuildPiece(double tA, double tB, double length, double tolerance, int depth)
+{
+	double tM = (tA + tB) / 2.0;
+	double lengthA = this->curve->IntegrateSpeed(tA, tM);
+	double lengthB = this->curve->IntegrateSpeed(tM, tB);
 
-	for (int i = 0; i < (signed)vertexData.size() - 1; i++)
+	if (::fabs(lengthA + lengthB - length) <= tolerance || depth >= 20)
 	{
-		std::vector<Vector3>& vertexArrayA = vertexData[i];
-		std::vector<Vector3>& vertexArrayB = vertexData[i + 1];
+		double startLength = this->sampleArray->back().length;
+		this->sampleArray->push_back(Sample{ tM, startLength + lengthA });
+		this->sampleArray->push_back(Sample{ tB, startLength + lengthA + lengthB });
+		return;
+	}
 
-		auto calculateLength = [&vertexArrayA, &vertexArrayB, &sides](int shift) -> double
-		{
-			double length = 0.0;
-			for (int j = 0; j < sides; j++)
-			{
-				length += (vertexArrayB[(j + shift) % sides] - vertexArrayA[j]).Length();
-			}
-			return length;
-		};
-
-		int shift = 0;
-		double minimumLength = FLT_MAX;
-		for (int j = 0; j < sides; j++)
+	this->BuildPiece(tA, tM, lengthA, tolerance / 2.0, depth + 1);
+	this->BuildPiece(tM, tB, lengthB, tolerance / 2.0, depth + 1);
+}
+
+double SpaceCurve::ArcLengthTable::GetLength() const
+{
+	if (this->sampleArray->size() == 0)
+		return 0.0;
+
+	return this->sampleArray->back().length;
+}
+
+double SpaceCurve::ArcLengthTable::LengthAt(double t) const
+{
+	if (this->sampleArray->size() == 0)
+		return 0.0;
+
+	t = MESH_NINJA_CLAMP(t, 0.0, 1.0);
+
+	std::vector<Sample>::const_iterator iter = std::upper_bound(this->sampleArray->begin(), this->sampleArray->end(), t, [](double t, const Sample& sample) -> bool
 		{
-			double length = calculateLength(j);
-			if (length < minimumLength)
-			{
-				minimumLength = length;
-				shift = j;
-			}
-		}
+			return t < sample.t;
+		});
+
+	if (iter == this->sampleArray->end())
+		return this->GetLength();
+
+	const Sample& sample = *(iter - 1);
+	return sample.length + this->curve->IntegrateSpeed(sample.t, t);
+}
+
+double SpaceCurve::ArcLengthTable::ParameterAt(double length) const
+{
+	if (this->sampleArray->size() == 0)
+		return 0.0;
+
+	length = MESH_NINJA_CLAMP(length, 0.0, this->GetLength());
 
-		for (int j = 0; j < sides; j++)
+	std::vector<Sample>::const_iterator iter = std::upper_bound(this->sampleArray->begin(), this->sampleArray->end(), length, [](double length, const Sample& sample) -> bool
 		{
-			ConvexPolygon polygon;
+			return length < sample.length;
+		});
 
-			polygon.vertexArray->push_back(vertexArrayA[j]);
-			polygon.vertexArray->push_back(vertexArrayA[(j + 1) % sides]);
-			polygon.vertexArray->push_back(vertexArrayB[(j + 1 + shift) % sides]);
-			polygon.vertexArray->push_back(vertexArrayB[(j + shift) % sides]);
+	if (iter == this->sampleArray->end())
+		return 1.0;
 
-			polygonArray.push_back(polygon);
-		}
+	const Sample& sampleA = *(iter - 1);
+	const Sample& sampleB = *iter;
+
+	// We start from where the length would be if the curve had a constant speed over the piece, which is nearly true.
+	double tA = sampleA.t;
+	double tB = sampleB.t;
+	double t = tA + (tB - tA) * (length - sampleA.length) / (sampleB.length - sampleA.length);
+	double tolerance = 1e-12 * MESH_NINJA_MAX(this->GetLength(), 1.0);
+
+	for (int i = 0; i < 16; i++)
+	{
+		double error = sampleA.length + this->curve->IntegrateSpeed(sampleA.t, t) - length;
+		if (::fabs(error) <= tolerance)
+			break;
+
+		if (error > 0.0)
+			tB = t;
+		else
+			tA = t;
+
+		double speed = this->curve->CalculateSpeed(t);
+		double nextT = (speed > 0.0) ? t - error / speed : tA;
+		if (!(tA < nextT && nextT < tB))
+			nextT = (tA + tB) / 2.0;
+
+		t = nextT;
 	}
 
-	mesh.FromConvexPolygonArray(polygonArray);
+	return t;
 }
 
 //------------------------------------ SpaceCurve::ControlPointCurve ------------------------------------
@@ -226,6 +435,8 @@ bool CompositeBezierCurve::CalculateBezierData(BezierData& data, double t) const
 	return result;
 }
 
+// Each segment's own parameter runs as many times faster than ours as there are segments, so its derivatives are scaled
+// up to match, or lengths found by integrating the speed of the curve would come out short.
 /*virtual*/ Vector3 CompositeBezierCurve::EvaluateDerivative(double t) const
 {
 	Vector3 result(0.0, 0.0, 0.0);
@@ -237,6 +448,7 @@ bool CompositeBezierCurve::CalculateBezierData(BezierData& data, double t) const
 		result += (3.0 - 12.0 * data.t + 9.0 * MESH_NINJA_SQUARED(data.t)) * data.pointB;
 		result += (6.0 * data.t - 9.0 * MESH_NINJA_SQUARED(data.t)) * data.pointC;
 		result += 3.0 * MESH_NINJA_SQUARED(data.t) * data.pointD;
+		result *= double(this->controlPointArray->size() - 1);
 	}
 
 	return result;
@@ -253,7 +465,88 @@ bool CompositeBezierCurve::CalculateBezierData(BezierData& data, double t) const
 		result += (-12.0 + 18.0 * data.t) * data.pointB;
 		result += (6.0 - 18.0 * data.t) * data.pointC;
 		result += 6.0 * data.t * data.pointD;
+		result *= MESH_NINJA_SQUARED(double(this->controlPointArray->size() - 1));
 	}
 
 	return result;
+}
+
+// The control points of the segment of each parameter are gathered into separate arrays of coordinates, one entry per
+// parameter, so that the work is in proportion to the number of parameters and not the number of segments, and then
+// each parameter is run through de Casteljau's algorithm on those.  Apart from the gathering, this is a loop of
+// straight-line arithmetic, which the compiler can vectorize.
+/*virtual*/ void CompositeBezierCurve::EvaluateBatch(const double* t, double* x, double* y, double* z, int count) const
+{
+	this->EvaluateBatchInternal(t, x, y, z, count, false);
+}
+
+/*virtual*/ void CompositeBezierCurve::EvaluateDerivativeBatch(const double* t, double* x, double* y, double* z, int count) const
+{
+	this->EvaluateBatchInternal(t, x, y, z, count, true);
+}
+
+void CompositeBezierCurve::EvaluateBatchInternal(const double* t, double* x, double* y, double* z, int count, bool derivative) const
+{
+	int numSegments = (int)this->controlPointArray->size() - 1;
+	if (numSegments < 1)
+	{
+		for (int i = 0; i < count; i++)
+			x[i] = y[i] = z[i] = 0.0;
+
+		return;
+	}
+
+	std::vector<double> controlArray(12 * count);
+	double* controlX[4], * controlY[4], * controlZ[4];
+	for (int j = 0; j < 4; j++)
+	{
+		controlX[j] = &controlArray[(3 * j + 0) * count];
+		controlY[j] = &controlArray[(3 * j + 1) * count];
+		controlZ[j] = &controlArray[(3 * j + 2) * count];
+	}
+
+	std::vector<double> localArray(count);
+	for (int i = 0; i < count; i++)
+	{
+		double alpha = double(numSegments) * MESH_NINJA_CLAMP(t[i], 0.0, 1.0);
+		int segment = MESH_NINJA_MIN(int(alpha), numSegments - 1);
+		localArray[i] = alpha - double(segment);
+
+		const ControlPoint& pointA = (*this)[segment];
+		const ControlPoint& pointB = (*this)[segment + 1];
+
+		Vector3 segmentArray[4] = { pointA.point, pointA.point + pointA.tangent, pointB.point - pointB.tangent, pointB.point };
+		for (int j = 0; j < 4; j++)
+		{
+			controlX[j][i] = segmentArray[j].x;
+			controlY[j][i] = segmentArray[j].y;
+			controlZ[j][i] = segmentArray[j].z;
+		}
+	}
+
+	double scale = derivative ? 3.0 * double(numSegments) : 1.0;
+
+	for (int i = 0; i < count; i++)
+	{
+		double u = localArray[i];
+		double v = 1.0 - u;
+
+		double* result[3] = { x, y, z };
+		double** control[3] = { controlX, controlY, controlZ };
+
+		for (int c = 0; c < 3; c++)
+		{
+			double p0 = control[c][0][i], p1 = control[c][1][i], p2 = control[c][2][i], p3 = control[c][3][i];
+
+			double q0 = v * p0 + u * p1;
+			double q1 = v * p1 + u * p2;
+			double q2 = v * p2 + u * p3;
+
+			double r0 = v * q0 + u * q1;
+			double r1 = v * q1 + u * q2;
+
+			// The derivative of a cubic is three times the difference of the last two points of the algorithm.
+			result[c][i] = derivative ? scale * (r1 - r0) : (v * r0 + u * r1);
+		}
+	}
 }
\ No newline at end of file
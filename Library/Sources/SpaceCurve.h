@@ -5,6 +5,7 @@
 namespace MeshNinja
 {
 	class ConvexPolygonMesh;
+	class TubeSweeper;
 
 	// These are always parameterized from 0 to 1.
 	class MESH_NINJA_API SpaceCurve
@@ -18,9 +19,61 @@ namespace MeshNinja
 		virtual Vector3 EvaluateSecondDerivative(double t) const;
 		virtual double AdvanceByCurveLength(double t, double length, double eps = MESH_NINJA_EPS) const;
 
+		// These evaluate the curve or its derivative at many parameters with one call, giving back separate arrays of the
+		// coordinates of the results.  By default they just evaluate one parameter at a time, but curves that can do better should.
+		virtual void EvaluateBatch(const double* t, double* x, double* y, double* z, int count) const;
+		virtual void EvaluateDerivativeBatch(const double* t, double* x, double* y, double* z, int count) const;
+
 		double CalculateLength() const;
 		void CalculateFrame(double t, Vector3& tangent, Vector3& normal, Vector3& binormal) const;
 		void GenerateTubeMesh(ConvexPolygonMesh& mesh, double stepLength, int sides, std::function<double(double)> radiusFunction) const;
+		bool AddTubePath(TubeSweeper& tubeSweeper, double stepLength, int sides, std::function<double(double)> radiusFunction) const;
+
+		// The arc-length table, once built, answers all questions of length along the curve, until it's cleared.
+		// It must be rebuilt if the curve changes.  Without it, these questions are answered from scratch each time.
+		void BuildArcLengthTable(double eps = 1e-8);
+		void ClearArcLengthTable();
+		double CalculateLengthAt(double t) const;
+		double CalculateParameterAt(double length) const;
+
+		// This maps parameters to lengths along a curve and back again.  The curve is cut into pieces small enough that
+		// integrating its speed over each with Gauss-Legendre quadrature is accurate to the given tolerance, relative
+		// to the length of the curve, and the length up to the start of each piece is kept.  A length within a piece is
+		// found by integrating from its start, and a parameter by Newton's method on that, after a binary search for
+		// the piece.
+		class MESH_NINJA_API ArcLengthTable
+		{
+		public:
+			ArcLengthTable();
+			virtual ~ArcLengthTable();
+
+			void Clear();
+			bool IsBuilt() const;
+			void Build(const SpaceCurve* curve, double eps = 1e-8);
+			double GetLength() const;
+			double LengthAt(double t) const;
+			double ParameterAt(double length) const;
+
+		protected:
+
+			struct Sample
+			{
+				double t;
+				double length;
+			};
+
+			void BuildPiece(double tA, double tB, double length, double tolerance, int depth);
+
+			const SpaceCurve* curve;
+			std::vector<Sample>* sampleArray;
+		};
+
+	protected:
+
+		double IntegrateSpeed(double tA, double tB) const;
+		double CalculateSpeed(double t) const;
+
+		ArcLengthTable* arcLengthTable;
 	};
 
 	class MESH_NINJA_API ControlPointCurve : public SpaceCurve
@@ -52,6 +105,8 @@ namespace MeshNinja
 		virtual Vector3 Evaluate(double t) const override;
 		virtual Vector3 EvaluateDerivative(double t) const override;
 		virtual Vector3 EvaluateSecondDerivative(double t) const override;
+		virtual void EvaluateBatch(const double* t, double* x, double* y, double* z, int count) const override;
+		virtual void EvaluateDerivativeBatch(const double* t, double* x, double* y, double* z, int count) const override;
 
 		struct BezierData
 		{
@@ -60,5 +115,9 @@ namespace MeshNinja
 		};
 
 		bool CalculateBezierData(BezierData& data, double t) const;
+
+	protected:
+
+		void EvaluateBatchInternal(const double* t, double* x, double* y, double* z, int count, bool derivative) const;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,141 @@
+#include "SpatialHash.h"
+
+using namespace MeshNinja;
+
+SpatialHash::SpatialHash(double cellSize /*= MESH_NINJA_EPS*/)
+{
+	this->pointArray = new std::vector<Vector3>();
+	this->cellMap = new std::unordered_map<uint64_t, int>();
+	this->nextArray = new std::vector<int>();
+	this->cellSize = cellSize;
+}
+
+/*virtual*/ SpatialHash::~SpatialHash()
+{
+	delete this->pointArray;
+	delete this->cellMap;
+	delete this->nextArray;
+}
+
+void SpatialHash::Clear()
+{
+	this->pointArray->clear();
+	this->cellMap->clear();
+	this->nextArray->clear();
+}
+
+void SpatialHash::SetCellSize(double cellSize)
+{
+	this->Clear();
+	this->cellSize = cellSize;
+}
+
+double SpatialHash::GetCellSize() const
+{
+	return this->cellSize;
+}
+
+int SpatialHash::Size() const
+{
+	return (int)this->pointArray->size();
+}
+
+void SpatialHash::CalcCell(const Vector3& point, int64_t& i, int64_t& j, int64_t& k) const
+{
+	i = (int64_t)::floor(point.x / this->cellSize);
+	j = (int64_t)::floor(point.y / this->cellSize);
+	k = (int64_t)::floor(point.z / this->cellSize);
+}
+
+/*static*/ uint64_t SpatialHash::CalcKey(int64_t i, int64_t j, int64_t k)
+{
+	// Distinct cells may collide here, but that only costs us a few extra distance checks.
+	return uint64_t(i) * 0x9E3779B97F4A7C15ULL ^ uint64_t(j) * 0xC2B2AE3D27D4EB4FULL ^ uint64_t(k) * 0x165667B19E3779F9ULL;
+}
+
+int SpatialHash::AddPoint(const Vector3& point)
+{
+	int64_t i, j, k;
+	this->CalcCell(point, i, j, k);
+	uint64_t key = CalcKey(i, j, k);
+
+	int index = (int)this->pointArray->size();
+	this->pointArray->push_back(point);
+
+	std::unordered_map<uint64_t, int>::iterator iter = this->cellMap->find(key);
+	if (iter == this->cellMap->end())
+	{
+		this->nextArray->push_back(-1);
+		this->cellMap->insert(std::pair<uint64_t, int>(key, index));
+	}
+	else
+	{
+		this->nextArray->push_back(iter->second);
+		iter->second = index;
+	}
+
+	return index;
+}
+
+void SpatialHash::ForPointsNear(const Vector3& point, double radius, std::function<bool(int)> callback) const
+{
+	int64_t i, j, k;
+	this->CalcCell(point, i, j, k);
+
+	int64_t reach = (int64_t)::ceil(radius / this->cellSize);
+	if (reach < 1)
+		reach = 1;
+
+	double radiusSquared = radius * radius;
+
+	for (int64_t di = -reach; di <= reach; di++)
+	{
+		for (int64_t dj = -reach; dj <= reach; dj++)
+		{
+			for (int64_t dk = -reach; dk <= reach; dk++)
+			{
+				std::unordered_map<uint64_t, int>::const_iterator iter = this->cellMap->find(CalcKey(i + di, j + dj, k + dk));
+				if (iter == this->cellMap->end())
+					continue;
+
+				for (int index = iter->second; index >= 0; index = (*this->nextArray)[index])
+				{
+					Vector3 delta = (*this->pointArray)[index] - point;
+					if (delta.Dot(delta) <= radiusSquared)
+					{
+						if (!callback(index))
+							return;
+					}
+				}
+			}
+		}
+	}
+}
+
+int SpatialHash::FindPoint(const Vector3& point, double eps /*= MESH_NINJA_EPS*/) const
+{
+	int foundIndex = -1;
+	double smallestDistance = DBL_MAX;
+
+	this->ForPointsNear(point, eps, [this, &point, &foundIndex, &smallestDistance](int index) -> bool
+		{
+			double distance = ((*this->pointArray)[index] - point).Length();
+			if (distance < smallestDistance)
+			{
+				smallestDistance = distance;
+				foundIndex = index;
+			}
+			return true;
+		});
+
+	return foundIndex;
+}
+
+int SpatialHash::WeldPoint(const Vector3& point, double eps /*= MESH_NINJA_EPS*/)
+{
+	int index = this->FindPoint(point, eps);
+	if (index < 0)
+		index = this->AddPoint(point);
+
+	return index;
+}
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "Common.h"
+#include "Math/Vector3.h"
+
+namespace MeshNinja
+{
+	// A spatial hash buckets points into a uniform grid of cubic cells so that all points
+	// within a given distance of a query point can be found in expected constant time.
+	// Queries with a radius no larger than the cell size only ever have to look at the
+	// 3x3x3 block of cells around the query point.  Points are referred to by the index
+	// they were given when added, which makes this handy for welding vertices together.
+	class MESH_NINJA_API SpatialHash
+	{
+	public:
+		SpatialHash(double cellSize = MESH_NINJA_EPS);
+		virtual ~SpatialHash();
+
+		void Clear();
+		void SetCellSize(double cellSize);
+		double GetCellSize() const;
+		int Size() const;
+		int AddPoint(const Vector3& point);
+		int FindPoint(const Vector3& point, double eps = MESH_NINJA_EPS) const;
+		int WeldPoint(const Vector3& point, double eps = MESH_NINJA_EPS);
+		void ForPointsNear(const Vector3& point, double radius, std::function<bool(int)> callback) const;
+
+		const Vector3& operator[](int i) const
+		{
+			return (*this->pointArray)[i];
+		}
+
+		std::vector<Vector3>* pointArray;
+
+	protected:
+
+		void CalcCell(const Vector3& point, int64_t& i, int64_t& j, int64_t& k) const;
+		static uint64_t CalcKey(int64_t i, int64_t j, int64_t k);
+
+		double cellSize;
+		std::unordered_map<uint64_t, int>* cellMap;
+		std::vector<int>* nextArray;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,407 @@
+#include "SurfacePolygonizer.h"
+#include "AlgebraicSurface.h"
+#include "ConvexPolygonMesh.h"
+#include "TaskScheduler.h"
+#include "Math/Matrix3x3.h"
+
+using namespace MeshNinja;
+
+SurfacePolygonizer::SurfacePolygonizer()
+{
+	this->placeVerticesOnFeatures = true;
+	this->blockSize = 16;
+	this->gridCellSize = 0.0;
+	this->gridCellCount[0] = 0;
+	this->gridCellCount[1] = 0;
+	this->gridCellCount[2] = 0;
+}
+
+/*virtual*/ SurfacePolygonizer::~SurfacePolygonizer()
+{
+}
+
+bool SurfacePolygonizer::GenerateMesh(ConvexPolygonMesh& mesh, const AxisAlignedBoundingBox& aabb, double cellSize, const AlgebraicSurface& surface, int threadCount /*= 0*/)
+{
+	mesh.Clear();
+
+	if (!aabb.IsValid() || cellSize <= 0.0 || this->blockSize <= 0)
+		return false;
+
+	this->gridOrigin = aabb.min;
+	this->gridCellSize = cellSize;
+	this->gridCellCount[0] = MESH_NINJA_MAX((int64_t)::ceil(aabb.Width() / cellSize), 1);
+	this->gridCellCount[1] = MESH_NINJA_MAX((int64_t)::ceil(aabb.Height() / cellSize), 1);
+	this->gridCellCount[2] = MESH_NINJA_MAX((int64_t)::ceil(aabb.Depth() / cellSize), 1);
+
+	int64_t minBlock[3] = { 0, 0, 0 };
+	int64_t maxBlock[3];
+	for (int i = 0; i < 3; i++)
+		maxBlock[i] = (this->gridCellCount[i] + this->blockSize - 1) / this->blockSize;
+
+	std::vector<Block*> blockArray;
+	this->FindBlocks(minBlock, maxBlock, surface, blockArray);
+
+	TaskScheduler::ParallelFor(0, (int)blockArray.size(), 1, [this, &blockArray, &surface](int start, int stop)
+		{
+			for (int i = start; i < stop; i++)
+				this->SampleBlock(blockArray[i], surface);
+		}, threadCount);
+
+	// Now that we know how many vertices each block has, we can give them all their final indices.
+	std::unordered_map<uint64_t, Block*> blockMap;
+	int numVertices = 0;
+	for (Block* block : blockArray)
+	{
+		block->vertexOffset = numVertices;
+		numVertices += (int)block->vertexArray.size();
+		blockMap.insert(std::pair<uint64_t, Block*>(CalcBlockKey(block->blockCoord), block));
+	}
+
+	TaskScheduler::ParallelFor(0, (int)blockArray.size(), 1, [this, &blockArray, &blockMap](int start, int stop)
+		{
+			for (int i = start; i < stop; i++)
+				this->TriangulateBlock(blockArray[i], blockMap);
+		}, threadCount);
+
+	mesh.vertexArray->resize(numVertices);
+
+	for (Block* block : blockArray)
+	{
+		std::copy(block->vertexArray.begin(), block->vertexArray.end(), mesh.vertexArray->begin() + block->vertexOffset);
+
+		for (int i = 0; i < (signed)block->triangleArray.size(); i += 3)
+		{
+			ConvexPolygonMesh::Facet facet;
+			facet.vertexArray->push_back(block->triangleArray[i]);
+			facet.vertexArray->push_back(block->triangleArray[i + 1]);
+			facet.vertexArray->push_back(block->triangleArray[i + 2]);
+			mesh.facetArray->push_back(facet);
+		}
+
+		delete block;
+	}
+
+	return true;
+}
+
+Vector3 SurfacePolygonizer::CalcGridPoint(int64_t i, int64_t j, int64_t k) const
+{
+	return Vector3(
+		this->gridOrigin.x + double(i) * this->gridCellSize,
+		this->gridOrigin.y + double(j) * this->gridCellSize,
+		this->gridOrigin.z + double(k) * this->gridCellSize);
+}
+
+/*static*/ uint64_t SurfacePolygonizer::CalcBlockKey(const int64_t* blockCoord)
+{
+	return uint64_t(blockCoord[0]) | (uint64_t(blockCoord[1]) << 21) | (uint64_t(blockCoord[2]) << 42);
+}
+
+// The blocks in the given range are skipped together if the surface can't reach into their box from its center,
+// and are otherwise split in half along their longest side until we're down to single blocks.
+void SurfacePolygonizer::FindBlocks(const int64_t* minBlock, const int64_t* maxBlock, const AlgebraicSurface& surface, std::vector<Block*>& blockArray) const
+{
+	int64_t minCell[3], maxCell[3];
+	for (int i = 0; i < 3; i++)
+	{
+		minCell[i] = minBlock[i] * this->blockSize;
+		maxCell[i] = MESH_NINJA_MIN(maxBlock[i] * this->blockSize, this->gridCellCount[i]);
+	}
+
+	AxisAlignedBoundingBox box(this->CalcGridPoint(minCell[0], minCell[1], minCell[2]), this->CalcGridPoint(maxCell[0], maxCell[1], maxCell[2]));
+
+	double lipschitzBound = surface.CalcLipschitzBound(box);
+	if (lipschitzBound > 0.0)
+	{
+		double radius = (box.max - box.min).Length() / 2.0;
+		if (::fabs(surface.Evaluate(box.Center())) > lipschitzBound * radius)
+			return;
+	}
+
+	int longestAxis = 0;
+	for (int i = 1; i < 3; i++)
+		if (maxBlock[i] - minBlock[i] > maxBlock[longestAxis] - minBlock[longestAxis])
+			longestAxis = i;
+
+	if (maxBlock[longestAxis] - minBlock[longestAxis] == 1)
+	{
+		Block* block = new Block();
+		for (int i = 0; i < 3; i++)
+			block->blockCoord[i] = minBlock[i];
+		block->vertexOffset = 0;
+		blockArray.push_back(block);
+		return;
+	}
+
+	int64_t middleBlock = (minBlock[longestAxis] + maxBlock[longestAxis]) / 2;
+
+	int64_t splitMaxBlock[3] = { maxBlock[0], maxBlock[1], maxBlock[2] };
+	splitMaxBlock[longestAxis] = middleBlock;
+	this->FindBlocks(minBlock, splitMaxBlock, surface, blockArray);
+
+	int64_t splitMinBlock[3] = { minBlock[0], minBlock[1], minBlock[2] };
+	splitMinBlock[longestAxis] = middleBlock;
+	this->FindBlocks(splitMinBlock, maxBlock, surface, blockArray);
+}
+
+// The surface is evaluated at the corners of every cell of the block, which includes those on the far sides of the block,
+// shared with the next blocks over.  Those are evaluated at exactly the same points by both blocks, and so agree.
+// A cell gets a vertex if the surface passes between its corners, and this is placed using the gradient of the surface
+// where it crosses the edges of the cell, all of which are evaluated together.
+void SurfacePolygonizer::SampleBlock(Block* block, const AlgebraicSurface& surface) const
+{
+	static const int cornerArray[8][3] =
+	{
+		{0, 0, 0}, {1, 0, 0}, {0, 1, 0}, {1, 1, 0},
+		{0, 0, 1}, {1, 0, 1}, {0, 1, 1}, {1, 1, 1}
+	};
+
+	static const int edgeArray[12][2] =
+	{
+		{0, 1}, {2, 3}, {4, 5}, {6, 7},
+		{0, 2}, {1, 3}, {4, 6}, {5, 7},
+		{0, 4}, {1, 5}, {2, 6}, {3, 7}
+	};
+
+	int size = this->blockSize;
+	int sampleSize = size + 1;
+	int numSamples = sampleSize * sampleSize * sampleSize;
+
+	int64_t firstCell[3];
+	for (int i = 0; i < 3; i++)
+		firstCell[i] = block->blockCoord[i] * size;
+
+	std::vector<double> xArray(numSamples), yArray(numSamples), zArray(numSamples);
+	for (int k = 0; k < sampleSize; k++)
+	{
+		for (int j = 0; j < sampleSize; j++)
+		{
+			for (int i = 0; i < sampleSize; i++)
+			{
+				int sample = i + sampleSize * (j + sampleSize * k);
+				Vector3 point = this->CalcGridPoint(firstCell[0] + i, firstCell[1] + j, firstCell[2] + k);
+				xArray[sample] = point.x;
+				yArray[sample] = point.y;
+				zArray[sample] = point.z;
+			}
+		}
+	}
+
+	block->valueArray.resize(numSamples);
+	surface.EvaluateBatch(xArray.data(), yArray.data(), zArray.data(), block->valueArray.data(), numSamples);
+
+	block->cellVertexArray.resize(size * size * size);
+
+	std::vector<int> crossingStartArray;
+	std::vector<double> crossingXArray, crossingYArray, crossingZArray;
+
+	for (int k = 0; k < size; k++)
+	{
+		for (int j = 0; j < size; j++)
+		{
+			for (int i = 0; i < size; i++)
+			{
+				int cell = i + size * (j + size * k);
+				block->cellVertexArray[cell] = -1;
+
+				if (firstCell[0] + i >= this->gridCellCount[0] || firstCell[1] + j >= this->gridCellCount[1] || firstCell[2] + k >= this->gridCellCount[2])
+					continue;
+
+				double valueArray[8];
+				int insideMask = 0;
+				for (int l = 0; l < 8; l++)
+				{
+					valueArray[l] = block->valueArray[(i + cornerArray[l][0]) + sampleSize * ((j + cornerArray[l][1]) + sampleSize * (k + cornerArray[l][2]))];
+					if (valueArray[l] < 0.0)
+						insideMask |= 1 << l;
+				}
+
+				if (insideMask == 0 || insideMask == 0xFF)
+					continue;
+
+				block->cellVertexArray[cell] = (int)block->vertexArray.size();
+				block->vertexArray.push_back(Vector3(i, j, k));
+				crossingStartArray.push_back((int)crossingXArray.size());
+
+				for (int l = 0; l < 12; l++)
+				{
+					int cornerA = edgeArray[l][0];
+					int cornerB = edgeArray[l][1];
+					if (((insideMask >> cornerA) & 1) == ((insideMask >> cornerB) & 1))
+						continue;
+
+					double t = valueArray[cornerA] / (valueArray[cornerA] - valueArray[cornerB]);
+					Vector3 pointA = this->CalcGridPoint(firstCell[0] + i + cornerArray[cornerA][0], firstCell[1] + j + cornerArray[cornerA][1], firstCell[2] + k + cornerArray[cornerA][2]);
+					Vector3 pointB = this->CalcGridPoint(firstCell[0] + i + cornerArray[cornerB][0], firstCell[1] + j + cornerArray[cornerB][1], firstCell[2] + k + cornerArray[cornerB][2]);
+					Vector3 crossing = pointA + (pointB - pointA) * t;
+
+					crossingXArray.push_back(crossing.x);
+					crossingYArray.push_back(crossing.y);
+					crossingZArray.push_back(crossing.z);
+				}
+			}
+		}
+	}
+
+	int numCrossings = (int)crossingXArray.size();
+	crossingStartArray.push_back(numCrossings);
+
+	std::vector<double> normalXArray, normalYArray, normalZArray;
+	if (this->placeVerticesOnFeatures)
+	{
+		normalXArray.resize(numCrossings);
+		normalYArray.resize(numCrossings);
+		normalZArray.resize(numCrossings);
+		surface.EvaluateGradientBatch(crossingXArray.data(), crossingYArray.data(), crossingZArray.data(), normalXArray.data(), normalYArray.data(), normalZArray.data(), numCrossings);
+	}
+
+	for (int v = 0; v < (signed)block->vertexArray.size(); v++)
+	{
+		Vector3& vertex = block->vertexArray[v];
+		Vector3 cellMin = this->CalcGridPoint(firstCell[0] + (int64_t)vertex.x, firstCell[1] + (int64_t)vertex.y, firstCell[2] + (int64_t)vertex.z);
+		Vector3 cellMax = cellMin + Vector3(this->gridCellSize, this->gridCellSize, this->gridCellSize);
+
+		Vector3 massPoint(0.0, 0.0, 0.0);
+		int start = crossingStartArray[v];
+		int stop = crossingStartArray[v + 1];
+		for (int l = start; l < stop; l++)
+			massPoint += Vector3(crossingXArray[l], crossingYArray[l], crossingZArray[l]);
+		massPoint /= double(stop - start);
+
+		vertex = massPoint;
+
+		// We minimize the sum of the squared distances to the planes of the crossings, plus a little of the squared distance
+		// to the mass point, which settles where the vertex goes along any direction the planes don't pin down.
+		if (this->placeVerticesOnFeatures)
+		{
+			const double regularization = 0.05;
+
+			Matrix3x3 matrix;
+			Vector3 vector = massPoint * regularization;
+			for (int r = 0; r < 3; r++)
+				for (int c = 0; c < 3; c++)
+					matrix.ele[r][c] = (r == c) ? regularization : 0.0;
+
+			for (int l = start; l < stop; l++)
+			{
+				Vector3 normal(normalXArray[l], normalYArray[l], normalZArray[l]);
+				if (!normal.Normalize())
+					continue;
+
+				double n[3] = { normal.x, normal.y, normal.z };
+				for (int r = 0; r < 3; r++)
+					for (int c = 0; c < 3; c++)
+						matrix.ele[r][c] += n[r] * n[c];
+
+				vector += normal * normal.Dot(Vector3(crossingXArray[l], crossingYArray[l], crossingZArray[l]));
+			}
+
+			Matrix3x3 inverse;
+			if (matrix.GetInverse(inverse))
+			{
+				vertex = inverse * vector;
+				vertex.Max(vertex, cellMin);
+				vertex.Min(vertex, cellMax);
+			}
+		}
+	}
+}
+
+// Each block makes the triangles for the edges of the grid starting at its own grid points.  The cells around an edge
+// on the near sides of a block belong to the blocks next to it, but those blocks must have been sampled, since the surface
+// crosses the edge, which is on their boxes too.
+void SurfacePolygonizer::TriangulateBlock(Block* block, const std::unordered_map<uint64_t, Block*>& blockMap) const
+{
+	int size = this->blockSize;
+	int sampleSize = size + 1;
+
+	for (int k = 0; k < size; k++)
+	{
+		for (int j = 0; j < size; j++)
+		{
+			for (int i = 0; i < size; i++)
+			{
+				int64_t point[3] = { block->blockCoord[0] * size + i, block->blockCoord[1] * size + j, block->blockCoord[2] * size + k };
+				if (point[0] > this->gridCellCount[0] || point[1] > this->gridCellCount[1] || point[2] > this->gridCellCount[2])
+					continue;
+
+				int local[3] = { i, j, k };
+				double valueA = block->valueArray[i + sampleSize * (j + sampleSize * k)];
+
+				for (int axis = 0; axis < 3; axis++)
+				{
+					int u = (axis + 1) % 3;
+					int v = (axis + 2) % 3;
+
+					if (point[axis] + 1 > this->gridCellCount[axis] || point[u] < 1 || point[v] < 1 || point[u] >= this->gridCellCount[u] || point[v] >= this->gridCellCount[v])
+						continue;
+
+					int next[3] = { local[0], local[1], local[2] };
+					next[axis]++;
+					double valueB = block->valueArray[next[0] + sampleSize * (next[1] + sampleSize * next[2])];
+
+					bool insideA = valueA < 0.0;
+					bool insideB = valueB < 0.0;
+					if (insideA == insideB)
+						continue;
+
+					// These go counter-clockwise about the positive direction of the axis.
+					static const int offsetArray[4][2] = { {-1, -1}, {0, -1}, {0, 0}, {-1, 0} };
+
+					int vertexArray[4];
+					bool found = true;
+					for (int l = 0; l < 4 && found; l++)
+					{
+						int64_t cell[3] = { point[0], point[1], point[2] };
+						cell[u] += offsetArray[l][0];
+						cell[v] += offsetArray[l][1];
+						vertexArray[l] = this->FindCellVertex(block, cell, blockMap);
+						found = (vertexArray[l] >= 0);
+					}
+
+					if (!found)
+						continue;
+
+					// The quad faces the way the function increases, which is along the axis if we start inside.
+					if (!insideA)
+						std::swap(vertexArray[1], vertexArray[3]);
+
+					block->triangleArray.push_back(vertexArray[0]);
+					block->triangleArray.push_back(vertexArray[1]);
+					block->triangleArray.push_back(vertexArray[2]);
+					block->triangleArray.push_back(vertexArray[0]);
+					block->triangleArray.push_back(vertexArray[2]);
+					block->triangleArray.push_back(vertexArray[3]);
+				}
+			}
+		}
+	}
+}
+
+int SurfacePolygonizer::FindCellVertex(const Block* block, const int64_t* cell, const std::unordered_map<uint64_t, Block*>& blockMap) const
+{
+	int size = this->blockSize;
+
+	int64_t blockCoord[3];
+	for (int i = 0; i < 3; i++)
+		blockCoord[i] = cell[i] / size;
+
+	if (blockCoord[0] != block->blockCoord[0] || blockCoord[1] != block->blockCoord[1] || blockCoord[2] != block->blockCoord[2])
+	{
+		std::unordered_map<uint64_t, Block*>::const_iterator iter = blockMap.find(CalcBlockKey(blockCoord));
+		if (iter == blockMap.end())
+			return -1;
+
+		block = iter->second;
+	}
+
+	int i = int(cell[0] - blockCoord[0] * size);
+	int j = int(cell[1] - blockCoord[1] * size);
+	int k = int(cell[2] - blockCoord[2] * size);
+
+	int vertex = block->cellVertexArray[i + size * (j + size * k)];
+	if (vertex < 0)
+		return -1;
+
+	return block->vertexOffset + vertex;
+}
\ No newline at end of file
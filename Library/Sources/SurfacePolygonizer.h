@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Common.h"
+#include "Math/Vector3.h"
+#include "AxisAlignedBoundingBox.h"
+
+namespace MeshNinja
+{
+	class ConvexPolygonMesh;
+	class AlgebraicSurface;
+
+	// This meshes the zero set of an algebraic surface within a given box by dual contouring over a grid of cubic
+	// cells.  Every cell the surface passes through gets a vertex, and every edge of the grid the surface crosses gets
+	// a pair of triangles joining the vertices of the four cells around it, so that, unlike the mesh fitter, this needs
+	// no starting point on the surface and handles surfaces in many pieces, or cut off by the box, just as well.
+	//
+	// The grid is cut into blocks, and any block that the surface can be shown to miss, by a Lipschitz bound on the
+	// surface over the block, is never looked at.  The remaining blocks are done in parallel.  Each vertex is made once,
+	// by the block containing its cell, and every triangle refers to it by index, so the blocks meet without cracks.
+	class MESH_NINJA_API SurfacePolygonizer
+	{
+	public:
+		SurfacePolygonizer();
+		virtual ~SurfacePolygonizer();
+
+		// The mesh is made of triangles, with normals pointing the way the surface function increases.
+		bool GenerateMesh(ConvexPolygonMesh& mesh, const AxisAlignedBoundingBox& aabb, double cellSize, const AlgebraicSurface& surface, int threadCount = 0);
+
+		// Each vertex goes where it best fits the planes of the surface at the crossings of its cell's edges, which keeps
+		// sharp features sharp.  Otherwise, it just goes at the average of those crossings, which is smoother.
+		bool placeVerticesOnFeatures;
+
+		// This is the number of cells along each side of a block.
+		int blockSize;
+
+	protected:
+
+		struct Block
+		{
+			int64_t blockCoord[3];
+			int vertexOffset;
+			std::vector<double> valueArray;
+			std::vector<int> cellVertexArray;
+			std::vector<Vector3> vertexArray;
+			std::vector<int> triangleArray;
+		};
+
+		void FindBlocks(const int64_t* minBlock, const int64_t* maxBlock, const AlgebraicSurface& surface, std::vector<Block*>& blockArray) const;
+		void SampleBlock(Block* block, const AlgebraicSurface& surface) const;
+		void TriangulateBlock(Block* block, const std::unordered_map<uint64_t, Block*>& blockMap) const;
+		int FindCellVertex(const Block* block, const int64_t* cell, const std::unordered_map<uint64_t, Block*>& blockMap) const;
+		Vector3 CalcGridPoint(int64_t i, int64_t j, int64_t k) const;
+		static uint64_t CalcBlockKey(const int64_t* blockCoord);
+
+		// These describe the grid while a mesh is being generated.
+		Vector3 gridOrigin;
+		double gridCellSize;
+		int64_t gridCellCount[3];
+	};
+}
\ No newline at end of file
@@ -0,0 +1,256 @@
+#include "TaskScheduler.h"
+#include "Math/Predicates.h"
+
+using namespace MeshNinja;
+
+// A thread knows which queue is its own by these.  Threads outside of any pool have none.
+static thread_local TaskScheduler* currentScheduler = nullptr;
+static thread_local int currentWorker = -1;
+
+TaskScheduler* TaskScheduler::globalScheduler = nullptr;
+int TaskScheduler::globalThreadCount = 0;
+std::mutex TaskScheduler::globalMutex;
+
+//----------------------------------- TaskScheduler -----------------------------------
+
+TaskScheduler::TaskScheduler(int threadCount /*= 0*/)
+{
+	if (threadCount <= 0)
+		threadCount = (int)std::thread::hardware_concurrency();
+
+	int numWorkers = MESH_NINJA_MAX(threadCount, 1) - 1;
+
+	this->queueArray = new std::vector<Queue*>();
+	this->threadArray = new std::vector<std::thread>();
+	this->queuedCount = 0;
+	this->stopping = false;
+
+	for (int i = 0; i <= numWorkers; i++)
+		this->queueArray->push_back(new Queue());
+
+	for (int i = 0; i < numWorkers; i++)
+		this->threadArray->push_back(std::thread(&TaskScheduler::WorkerLoop, this, i));
+}
+
+/*virtual*/ TaskScheduler::~TaskScheduler()
+{
+	{
+		std::lock_guard<std::mutex> lock(this->sleepMutex);
+		this->stopping = true;
+	}
+
+	this->sleepCondition.notify_all();
+
+	for (std::thread& thread : *this->threadArray)
+		thread.join();
+
+	for (Queue* queue : *this->queueArray)
+		delete queue;
+
+	delete this->queueArray;
+	delete this->threadArray;
+}
+
+int TaskScheduler::GetThreadCount() const
+{
+	return (int)this->threadArray->size() + 1;
+}
+
+// The pool is never torn down, since joining threads while the process is exiting isn't safe everywhere.
+/*static*/ TaskScheduler* TaskScheduler::Get()
+{
+	std::lock_guard<std::mutex> lock(globalMutex);
+
+	if (!globalScheduler)
+		globalScheduler = new TaskScheduler(globalThreadCount);
+
+	return globalScheduler;
+}
+
+/*static*/ void TaskScheduler::SetThreadCount(int threadCount)
+{
+	std::lock_guard<std::mutex> lock(globalMutex);
+
+	globalThreadCount = threadCount;
+
+	delete globalScheduler;
+	globalScheduler = nullptr;
+}
+
+void TaskScheduler::Push(Task&& task)
+{
+	int i = (currentScheduler == this) ? currentWorker : (int)this->queueArray->size() - 1;
+	Queue* queue = (*this->queueArray)[i];
+
+	{
+		std::lock_guard<std::mutex> lock(queue->mutex);
+		queue->taskDeque.push_back(std::move(task));
+	}
+
+	// Taking the lock here makes sure a worker can't miss this between checking for work and going to sleep.
+	{
+		std::lock_guard<std::mutex> lock(this->sleepMutex);
+		this->queuedCount++;
+	}
+
+	this->sleepCondition.notify_one();
+}
+
+bool TaskScheduler::Pop(int i, bool back, Task& task)
+{
+	Queue* queue = (*this->queueArray)[i];
+	std::lock_guard<std::mutex> lock(queue->mutex);
+
+	if (queue->taskDeque.size() == 0)
+		return false;
+
+	if (back)
+	{
+		task = std::move(queue->taskDeque.back());
+		queue->taskDeque.pop_back();
+	}
+	else
+	{
+		task = std::move(queue->taskDeque.front());
+		queue->taskDeque.pop_front();
+	}
+
+	this->queuedCount--;
+	return true;
+}
+
+// A worker looks in its own queue first.  Everyone else's are looked through starting with the one after its own,
+// so that the workers don't all pile onto the same victim.
+bool TaskScheduler::TryRunTask()
+{
+	if (this->queuedCount == 0)
+		return false;
+
+	int numQueues = (int)this->queueArray->size();
+	int self = (currentScheduler == this) ? currentWorker : numQueues - 1;
+
+	Task task;
+	bool found = this->Pop(self, true, task);
+
+	for (int i = 1; i < numQueues && !found; i++)
+		found = this->Pop((self + i) % numQueues, false, task);
+
+	if (!found)
+		return false;
+
+	task.func();
+	(*task.pendingCount)--;
+	return true;
+}
+
+void TaskScheduler::WorkerLoop(int i)
+{
+	currentScheduler = this;
+	currentWorker = i;
+
+	while (true)
+	{
+		if (this->TryRunTask())
+			continue;
+
+		std::unique_lock<std::mutex> lock(this->sleepMutex);
+		this->sleepCondition.wait(lock, [this]() -> bool
+			{
+				return this->stopping || this->queuedCount > 0;
+			});
+
+		if (this->stopping)
+			break;
+	}
+}
+
+/*static*/ void TaskScheduler::ParallelFor(int begin, int end, int grainSize, std::function<void(int, int)> rangeFunc, int threadCount /*= 0*/)
+{
+	grainSize = MESH_NINJA_MAX(grainSize, 1);
+	int numChunks = (end > begin) ? (end - begin + grainSize - 1) / grainSize : 0;
+
+	ForChunks(numChunks, threadCount, [begin, end, grainSize, &rangeFunc](int chunk)
+		{
+			int start = begin + chunk * grainSize;
+			rangeFunc(start, MESH_NINJA_MIN(start + grainSize, end));
+		});
+}
+
+// Rather than a task for every chunk, there's a task for every thread we're allowed, and each of those takes
+// the next chunk not yet taken until there are none left.  The calling thread is one of them.
+/*static*/ void TaskScheduler::ForChunks(int numChunks, int threadCount, std::function<void(int)> chunkFunc)
+{
+	TaskScheduler* scheduler = Get();
+
+	if (threadCount <= 0)
+		threadCount = scheduler->GetThreadCount();
+
+	int numRunners = MESH_NINJA_MIN(threadCount, numChunks);
+
+	if (numRunners <= 1)
+	{
+		for (int i = 0; i < numChunks; i++)
+			chunkFunc(i);
+
+		return;
+	}
+
+	std::atomic<int> nextChunk = 0;
+
+	auto runner = [&nextChunk, &chunkFunc, numChunks]()
+	{
+		for (int i = nextChunk++; i < numChunks; i = nextChunk++)
+			chunkFunc(i);
+	};
+
+	TaskGroup taskGroup(scheduler);
+
+	for (int i = 1; i < numRunners; i++)
+		taskGroup.Run(runner);
+
+	runner();
+	taskGroup.Wait();
+}
+
+//----------------------------------- TaskScheduler::TaskGroup -----------------------------------
+
+TaskScheduler::TaskGroup::TaskGroup(TaskScheduler* scheduler /*= nullptr*/)
+{
+	this->scheduler = scheduler ? scheduler : TaskScheduler::Get();
+	this->pendingCount = 0;
+}
+
+/*virtual*/ TaskScheduler::TaskGroup::~TaskGroup()
+{
+	this->Wait();
+}
+
+void TaskScheduler::TaskGroup::Run(std::function<void()> task)
+{
+	// With no workers, there's nobody else to run the task, so we might as well run it now.
+	if (this->scheduler->GetThreadCount() <= 1)
+	{
+		task();
+		return;
+	}
+
+	Predicates::Mode mode = Predicates::GetMode();
+
+	this->pendingCount++;
+	this->scheduler->Push(Task{ [task, mode]()
+		{
+			Predicates::ModeScope modeScope(mode);
+			task();
+		}, &this->pendingCount });
+}
+
+// The tasks of this group may have been stolen, in which case there's no telling what we'll run while we wait, but
+// whatever it is needs doing anyway.
+void TaskScheduler::TaskGroup::Wait()
+{
+	while (this->pendingCount > 0)
+	{
+		if (!this->scheduler->TryRunTask())
+			std::this_thread::yield();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "Common.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <deque>
+
+namespace MeshNinja
+{
+	// This is a pool of worker threads shared by everything in the library that does work in parallel.  Each
+	// worker has its own deque of tasks.  A worker pushes the tasks it spawns onto the back of its own deque
+	// and takes its next task from there too, so that it keeps working on what's freshest in its cache, and a
+	// worker with nothing to do steals from the front of someone else's deque, where the biggest pieces of work
+	// usually are.  A thread waiting on a group of tasks runs tasks itself until they're done, rather than
+	// blocking, so tasks can spawn and wait on tasks of their own without ever tying up the pool.
+	//
+	// Tasks run under the predicate mode of the thread that spawned them.
+	class MESH_NINJA_API TaskScheduler
+	{
+	public:
+		// The thread count includes the thread waiting on the work, so a count of one means no workers at all.
+		TaskScheduler(int threadCount = 0);
+		virtual ~TaskScheduler();
+
+		int GetThreadCount() const;
+
+		// This is the pool used by default.  Its size can be changed, but not while anything is using it.
+		static TaskScheduler* Get();
+		static void SetThreadCount(int threadCount);
+
+		// Tasks are run as a group, so that we can wait on them all.  A group has to be waited on before it goes away.
+		class MESH_NINJA_API TaskGroup
+		{
+		public:
+			TaskGroup(TaskScheduler* scheduler = nullptr);
+			virtual ~TaskGroup();
+
+			void Run(std::function<void()> task);
+			void Wait();
+
+		private:
+			TaskScheduler* scheduler;
+			std::atomic<int> pendingCount;
+		};
+
+		// The range is cut into pieces of the given size, and these are handed out to as many as the given number
+		// of threads at a time, a piece at a time, to whoever's free.  A count of zero means that of the pool.
+		static void ParallelFor(int begin, int end, int grainSize, std::function<void(int, int)> rangeFunc, int threadCount = 0);
+
+		// This is like ParallelFor, but each piece gives a value, and these are combined in the order of their pieces,
+		// so the result is the same however the pieces are scheduled.
+		template<typename T>
+		static T ParallelReduce(int begin, int end, int grainSize, const T& identity, std::function<T(int, int)> rangeFunc, std::function<T(const T&, const T&)> combineFunc, int threadCount = 0)
+		{
+			grainSize = MESH_NINJA_MAX(grainSize, 1);
+			int numChunks = (end > begin) ? (end - begin + grainSize - 1) / grainSize : 0;
+
+			std::vector<T> partialArray(numChunks, identity);
+
+			ForChunks(numChunks, threadCount, [begin, end, grainSize, &partialArray, &rangeFunc](int chunk)
+				{
+					int start = begin + chunk * grainSize;
+					partialArray[chunk] = rangeFunc(start, MESH_NINJA_MIN(start + grainSize, end));
+				});
+
+			T result = identity;
+			for (const T& partial : partialArray)
+				result = combineFunc(result, partial);
+
+			return result;
+		}
+
+	protected:
+
+		struct Task
+		{
+			std::function<void()> func;
+			std::atomic<int>* pendingCount;
+		};
+
+		struct Queue
+		{
+			std::deque<Task> taskDeque;
+			std::mutex mutex;
+		};
+
+		static void ForChunks(int numChunks, int threadCount, std::function<void(int)> chunkFunc);
+
+		void Push(Task&& task);
+		bool TryRunTask();
+		bool Pop(int i, bool back, Task& task);
+		void WorkerLoop(int i);
+
+		// There's a queue for each worker, and one more at the end for tasks spawned by threads outside the pool.
+		std::vector<Queue*>* queueArray;
+		std::vector<std::thread>* threadArray;
+		std::atomic<int> queuedCount;
+		std::atomic<bool> stopping;
+		std::mutex sleepMutex;
+		std::condition_variable sleepCondition;
+
+		static TaskScheduler* globalScheduler;
+		static int globalThreadCount;
+		static std::mutex globalMutex;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,323 @@
+#include "TubeSweeper.h"
+#include "ConvexPolygonMesh.h"
+#include "Polyline.h"
+#include "TaskScheduler.h"
+
+using namespace MeshNinja;
+
+TubeSweeper::TubeSweeper()
+{
+	this->capEnds = true;
+	this->miterJoints = true;
+	this->pathArray = new std::vector<Path>();
+}
+
+/*virtual*/ TubeSweeper::~TubeSweeper()
+{
+	delete this->pathArray;
+}
+
+void TubeSweeper::Clear()
+{
+	this->pathArray->clear();
+}
+
+int TubeSweeper::GetPathCount() const
+{
+	return (int)this->pathArray->size();
+}
+
+bool TubeSweeper::AddPath(const std::vector<Vector3>& pointArray, double radius, int numSides, bool closed /*= false*/, double eps /*= MESH_NINJA_EPS*/)
+{
+	std::vector<Vector3> tangentArray;
+	std::vector<double> radiusArray(pointArray.size(), radius);
+	return this->AddPath(pointArray, tangentArray, radiusArray, numSides, closed, eps);
+}
+
+bool TubeSweeper::AddPath(const Polyline& polyline, double radius, int numSides, double eps /*= MESH_NINJA_EPS*/)
+{
+	return this->AddPath(*polyline.vertexArray, radius, numSides, polyline.IsLineLoop(eps), eps);
+}
+
+bool TubeSweeper::AddPath(const std::vector<Vector3>& pointArray, const std::vector<Vector3>& tangentArray, const std::vector<double>& radiusArray, int numSides, bool closed /*= false*/, double eps /*= MESH_NINJA_EPS*/)
+{
+	if (numSides < 2 || radiusArray.size() != pointArray.size())
+		return false;
+
+	if (tangentArray.size() > 0 && tangentArray.size() != pointArray.size())
+		return false;
+
+	Path path;
+	path.numSides = numSides;
+	path.closed = closed;
+
+	for (int i = 0; i < (signed)pointArray.size(); i++)
+	{
+		if (path.pointArray.size() > 0 && (pointArray[i] - path.pointArray.back()).Length() < eps)
+			continue;
+
+		path.pointArray.push_back(pointArray[i]);
+		path.radiusArray.push_back(radiusArray[i]);
+		if (tangentArray.size() > 0)
+			path.tangentArray.push_back(tangentArray[i]);
+	}
+
+	if (closed && path.pointArray.size() > 1 && (path.pointArray.back() - path.pointArray[0]).Length() < eps)
+	{
+		path.pointArray.pop_back();
+		path.radiusArray.pop_back();
+		if (path.tangentArray.size() > 0)
+			path.tangentArray.pop_back();
+	}
+
+	int numPoints = (int)path.pointArray.size();
+	if (numPoints < (closed ? 3 : 2))
+		return false;
+
+	// Where a tangent wasn't given, or is too small to say which way it points, we go by the neighboring points instead.
+	for (int i = 0; i < (signed)path.tangentArray.size(); i++)
+	{
+		Vector3& tangent = path.tangentArray[i];
+		if (tangent.Normalize())
+			continue;
+
+		int j = closed ? (i + 1) % numPoints : MESH_NINJA_MIN(i + 1, numPoints - 1);
+		int k = closed ? (i + numPoints - 1) % numPoints : MESH_NINJA_MAX(i - 1, 0);
+		tangent = path.pointArray[j] - path.pointArray[k];
+		tangent.Normalize();
+	}
+
+	this->pathArray->push_back(path);
+	return true;
+}
+
+// Each path's rings are found on their own, and then each ring writes its vertices, the quads joining it to the
+// next ring, and any cap it has.  The first ring, vertex and facet of each path are known ahead of time from the
+// counts of those before it, so none of this has to wait on anything else.
+bool TubeSweeper::GenerateMesh(ConvexPolygonMesh& mesh, int threadCount /*= 0*/) const
+{
+	mesh.Clear();
+
+	int numPaths = (int)this->pathArray->size();
+	if (numPaths == 0)
+		return false;
+
+	std::vector<int> ringOffsetArray(numPaths + 1), vertexOffsetArray(numPaths + 1), facetOffsetArray(numPaths + 1);
+	ringOffsetArray[0] = 0;
+	vertexOffsetArray[0] = 0;
+	facetOffsetArray[0] = 0;
+
+	for (int i = 0; i < numPaths; i++)
+	{
+		const Path& path = (*this->pathArray)[i];
+		int numRings = (int)path.pointArray.size();
+		int numSegments = path.closed ? numRings : (numRings - 1);
+		int numCaps = (this->capEnds && !path.closed && path.numSides >= 3) ? 2 : 0;
+
+		ringOffsetArray[i + 1] = ringOffsetArray[i] + numRings;
+		vertexOffsetArray[i + 1] = vertexOffsetArray[i] + numRings * path.numSides;
+		facetOffsetArray[i + 1] = facetOffsetArray[i] + numSegments * path.numSides + numCaps;
+	}
+
+	std::vector<Ring> ringArray(ringOffsetArray[numPaths]);
+
+	TaskScheduler::ParallelFor(0, numPaths, 1, [this, &ringArray, &ringOffsetArray](int start, int stop)
+		{
+			for (int i = start; i < stop; i++)
+				this->CalcRings((*this->pathArray)[i], &ringArray[ringOffsetArray[i]]);
+		}, threadCount);
+
+	mesh.vertexArray->resize(vertexOffsetArray[numPaths]);
+	mesh.facetArray->resize(facetOffsetArray[numPaths]);
+
+	TaskScheduler::ParallelFor(0, ringOffsetArray[numPaths], 64, [this, &mesh, &ringArray, &ringOffsetArray, &vertexOffsetArray, &facetOffsetArray](int start, int stop)
+		{
+			for (int g = start; g < stop; g++)
+			{
+				int i = int(std::upper_bound(ringOffsetArray.begin(), ringOffsetArray.end(), g) - ringOffsetArray.begin()) - 1;
+				const Path& path = (*this->pathArray)[i];
+				int numRings = ringOffsetArray[i + 1] - ringOffsetArray[i];
+				int numSides = path.numSides;
+				int j = g - ringOffsetArray[i];
+
+				const Ring& ring = ringArray[g];
+				int vertexOffset = vertexOffsetArray[i] + j * numSides;
+				for (int k = 0; k < numSides; k++)
+				{
+					double angle = MESH_NINJA_TWO_PI * double(k) / double(numSides);
+					(*mesh.vertexArray)[vertexOffset + k] = ring.center + ring.axisA * ::cos(angle) + ring.axisB * ::sin(angle);
+				}
+
+				int numSegments = path.closed ? numRings : (numRings - 1);
+				if (j < numSegments)
+				{
+					int nextVertexOffset = vertexOffsetArray[i] + ((j + 1) % numRings) * numSides;
+					for (int k = 0; k < numSides; k++)
+					{
+						int l = (k + 1) % numSides;
+						ConvexPolygonMesh::Facet& facet = (*mesh.facetArray)[facetOffsetArray[i] + j * numSides + k];
+						facet.vertexArray->push_back(vertexOffset + k);
+						facet.vertexArray->push_back(vertexOffset + l);
+						facet.vertexArray->push_back(nextVertexOffset + l);
+						facet.vertexArray->push_back(nextVertexOffset + k);
+					}
+				}
+
+				if (this->capEnds && !path.closed && numSides >= 3 && (j == 0 || j == numRings - 1))
+				{
+					ConvexPolygonMesh::Facet& cap = (*mesh.facetArray)[facetOffsetArray[i] + numSegments * numSides + ((j == 0) ? 0 : 1)];
+					for (int k = 0; k < numSides; k++)
+						cap.vertexArray->push_back(vertexOffset + ((j == 0) ? (numSides - 1 - k) : k));
+				}
+			}
+		}, threadCount);
+
+	return true;
+}
+
+// The frames are carried from one station of the path to the next, a station being a point of a sampled curve, or
+// the start of a segment of a polyline, whose direction is then that of the segment.
+void TubeSweeper::CalcFrames(const Path& path, std::vector<Vector3>& directionArray, std::vector<Vector3>& frameArray) const
+{
+	int numPoints = (int)path.pointArray.size();
+	bool polyline = (path.tangentArray.size() == 0);
+	int numStations = (polyline && !path.closed) ? (numPoints - 1) : numPoints;
+
+	directionArray.resize(numStations);
+	frameArray.resize(numStations);
+
+	for (int i = 0; i < numStations; i++)
+	{
+		if (polyline)
+			directionArray[i] = (path.pointArray[(i + 1) % numPoints] - path.pointArray[i]).Normalized();
+		else
+			directionArray[i] = path.tangentArray[i];
+	}
+
+	frameArray[0].MakeOrthogonalTo(directionArray[0]);
+	frameArray[0].Normalize();
+
+	for (int i = 0; i < numStations - 1; i++)
+		frameArray[i + 1] = TransportFrame(frameArray[i], path.pointArray[i], directionArray[i], path.pointArray[i + 1], directionArray[i + 1]);
+
+	if (!path.closed)
+		return;
+
+	// Going all the way around brings the frame back to the start turned by some angle about the direction there, and
+	// we turn each frame back by its share of that angle, going by the length of path up to it.
+	Vector3 frame = TransportFrame(frameArray[numStations - 1], path.pointArray[numStations - 1], directionArray[numStations - 1], path.pointArray[0], directionArray[0]);
+	double twistAngle = ::atan2(directionArray[0].Dot(frameArray[0].Cross(frame)), frameArray[0].Dot(frame));
+
+	std::vector<double> lengthArray(numStations + 1);
+	lengthArray[0] = 0.0;
+	for (int i = 0; i < numStations; i++)
+		lengthArray[i + 1] = lengthArray[i] + (path.pointArray[(i + 1) % numPoints] - path.pointArray[i]).Length();
+
+	for (int i = 1; i < numStations; i++)
+		frameArray[i].RotateAbout(directionArray[i], -twistAngle * lengthArray[i] / lengthArray[numStations]);
+}
+
+void TubeSweeper::CalcRings(const Path& path, Ring* ringArray) const
+{
+	std::vector<Vector3> directionArray, frameArray;
+	this->CalcFrames(path, directionArray, frameArray);
+
+	int numPoints = (int)path.pointArray.size();
+	int numStations = (int)directionArray.size();
+
+	if (path.tangentArray.size() > 0)
+	{
+		for (int i = 0; i < numPoints; i++)
+		{
+			Ring& ring = ringArray[i];
+			double radius = path.radiusArray[i];
+			ring.center = path.pointArray[i];
+			ring.axisA = frameArray[i] * radius;
+			ring.axisB = directionArray[i].Cross(frameArray[i]) * radius;
+		}
+
+		return;
+	}
+
+	// Past this, the stretch of a mitered ring, which is one over this cosine, is more than we want to allow.
+	const double minMiterCosine = 0.25;
+
+	for (int i = 0; i < numPoints; i++)
+	{
+		int segmentIn = (path.closed || i > 0) ? (i + numStations - 1) % numStations : -1;
+		int segmentOut = (path.closed || i < numPoints - 1) ? i : -1;
+
+		Ring& ring = ringArray[i];
+		double radius = path.radiusArray[i];
+		ring.center = path.pointArray[i];
+
+		// At the ends of an open path, the ring just goes at right angles to the segment there.
+		if (segmentIn < 0 || segmentOut < 0)
+		{
+			int j = (segmentIn < 0) ? segmentOut : segmentIn;
+			ring.axisA = frameArray[j] * radius;
+			ring.axisB = directionArray[j].Cross(frameArray[j]) * radius;
+			continue;
+		}
+
+		const Vector3& direction = directionArray[segmentOut];
+		const Vector3& frame = frameArray[segmentOut];
+
+		Vector3 normal = directionArray[segmentIn] + direction;
+		if (!normal.Normalize())
+			normal = direction;
+
+		Vector3 axisA = frame * radius;
+		Vector3 axisB = direction.Cross(frame) * radius;
+		double cosine = direction.Dot(normal);
+
+		if (this->miterJoints && cosine >= minMiterCosine)
+		{
+			// Each axis is slid along the outgoing segment until it meets the plane halfway between the segments.  The
+			// frames of the two segments differ by a rotation that takes one to the other, so sliding along the incoming
+			// segment with its frame would land in the same place.
+			ring.axisA = axisA - direction * (axisA.Dot(normal) / cosine);
+			ring.axisB = axisB - direction * (axisB.Dot(normal) / cosine);
+		}
+		else
+		{
+			Vector3 frameHalfway(frame);
+			frameHalfway.RejectFrom(normal);
+			if (!frameHalfway.Normalize())
+				frameHalfway.MakeOrthogonalTo(normal);
+
+			ring.axisA = frameHalfway * radius;
+			ring.axisB = normal.Cross(frameHalfway) * radius;
+		}
+	}
+}
+
+// This is the double reflection method of Wang, Juttler, Zheng and Liu.  The frame is reflected through the plane
+// between the two points, and then through the plane that takes the reflected direction to the next direction.
+// For the segments of a polyline, this comes down to the smallest rotation taking one segment's direction to the next.
+/*static*/ Vector3 TubeSweeper::TransportFrame(const Vector3& frame, const Vector3& pointA, const Vector3& directionA, const Vector3& pointB, const Vector3& directionB)
+{
+	Vector3 reflectedFrame(frame);
+	Vector3 reflectedDirection(directionA);
+
+	Vector3 vectorA = pointB - pointA;
+	double lengthSquaredA = vectorA.Dot(vectorA);
+	if (lengthSquaredA > 0.0)
+	{
+		reflectedFrame -= vectorA * (2.0 * vectorA.Dot(frame) / lengthSquaredA);
+		reflectedDirection -= vectorA * (2.0 * vectorA.Dot(directionA) / lengthSquaredA);
+	}
+
+	Vector3 vectorB = directionB - reflectedDirection;
+	double lengthSquaredB = vectorB.Dot(vectorB);
+	if (lengthSquaredB > 0.0)
+		reflectedFrame -= vectorB * (2.0 * vectorB.Dot(reflectedFrame) / lengthSquaredB);
+
+	// This keeps round-off from building up along long paths.
+	reflectedFrame.RejectFrom(directionB);
+	if (!reflectedFrame.Normalize())
+		reflectedFrame.MakeOrthogonalTo(directionB);
+
+	reflectedFrame.Normalize();
+	return reflectedFrame;
+}
\ No newline at end of file
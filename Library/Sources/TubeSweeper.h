@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Common.h"
+#include "Math/Vector3.h"
+
+namespace MeshNinja
+{
+	class ConvexPolygonMesh;
+	class Polyline;
+
+	// This sweeps a circle along each of any number of paths to make tubes, all of them going into the one mesh.
+	// The circles are carried along their paths by rotation-minimizing frames, found by the double reflection
+	// method, so the tubes don't twist the way they do with Frenet frames, and neighboring rings of a tube line up
+	// vertex for vertex.  A closed path has whatever twist is left over when its frame comes back around spread
+	// out evenly along its length.
+	//
+	// Everything about the mesh is known from the paths before any of it is made, so its vertex and facet arrays
+	// are sized once, each path and ring is given its place in them, and the rings and quads are written there in
+	// parallel, with no welding needed afterward.
+	class MESH_NINJA_API TubeSweeper
+	{
+	public:
+		TubeSweeper();
+		virtual ~TubeSweeper();
+
+		void Clear();
+
+		// A path is a polyline if it's given no tangents, and its rings are then either mitered or just turned halfway
+		// at its corners.  Otherwise, each ring is made at right angles to the tangent given for it, as for a sampled
+		// curve.  Points closer together than the given tolerance are taken as one, as is the last point with the
+		// first of a closed path.  A path needs at least two distinct points, three if it's closed.
+		bool AddPath(const std::vector<Vector3>& pointArray, double radius, int numSides, bool closed = false, double eps = MESH_NINJA_EPS);
+		bool AddPath(const std::vector<Vector3>& pointArray, const std::vector<Vector3>& tangentArray, const std::vector<double>& radiusArray, int numSides, bool closed = false, double eps = MESH_NINJA_EPS);
+		bool AddPath(const Polyline& polyline, double radius, int numSides, double eps = MESH_NINJA_EPS);
+
+		int GetPathCount() const;
+
+		bool GenerateMesh(ConvexPolygonMesh& mesh, int threadCount = 0) const;
+
+		// Each end of a path that isn't closed is capped with a polygon if this is set.
+		bool capEnds;
+
+		// If this is set, the ring at each corner of a polyline lies in the plane halfway between the two segments
+		// meeting there, and is stretched so that each segment's tube keeps its full radius right up to that plane.
+		// Corners too sharp for this, where the stretch would get out of hand, are just turned halfway instead.
+		bool miterJoints;
+
+	protected:
+
+		struct Path
+		{
+			std::vector<Vector3> pointArray;
+			std::vector<Vector3> tangentArray;
+			std::vector<double> radiusArray;
+			int numSides;
+			bool closed;
+		};
+
+		// The vertices of a ring are at its center plus the cosine and sine of their angle times its two axes.
+		struct Ring
+		{
+			Vector3 center;
+			Vector3 axisA;
+			Vector3 axisB;
+		};
+
+		void CalcFrames(const Path& path, std::vector<Vector3>& directionArray, std::vector<Vector3>& frameArray) const;
+		void CalcRings(const Path& path, Ring* ringArray) const;
+
+		static Vector3 TransportFrame(const Vector3& frame, const Vector3& pointA, const Vector3& directionA, const Vector3& pointB, const Vector3& directionB);
+
+		std::vector<Path>* pathArray;
+	};
+}
\ No newline at end of file
@@ -8,11 +8,128 @@
 #include "AxisAlignedBoundingBox.h"
 #include "JSON/JsonValue.h"
 #include "FileFormats/ObjFileFormat.h"
+#include "BoundingBoxTree.h"
+#include "PointCloud.h"
+#include <thread>
+#include <chrono>
+#include <random>
+
+// Every thread queries the same tree and cloud with stacks of its own, for a fixed amount of time.
+// The queries per second with one thread are the baseline for the efficiency of those with more.
+static void BenchmarkQueries()
+{
+	using namespace MeshNinja;
+
+	ConvexPolygonMesh mesh;
+	mesh.GenerateSphere(10.0, 400, 300);
+
+	std::vector<BoundingBoxTree::Object*> objectArray;
+	for (int i = 0; i < (signed)mesh.facetArray->size(); i++)
+	{
+		const ConvexPolygonMesh::Facet& facet = (*mesh.facetArray)[i];
+
+		AxisAlignedBoundingBox box((*mesh.vertexArray)[facet[0]]);
+		for (int j = 1; j < (signed)facet.vertexArray->size(); j++)
+			box.ExpandToIncludePoint((*mesh.vertexArray)[facet[j]]);
+
+		objectArray.push_back(new BoundingBoxTree::IndexedObject(i, box));
+	}
+
+	// The tree takes ownership of the objects, and deletes them along with itself.
+	BoundingBoxTree tree;
+	tree.Rebuild(objectArray);
+
+	PointCloud pointCloud;
+	pointCloud.FromPointArray(*mesh.vertexArray, 10, 0);
+
+	int maxThreads = std::max(1, (int)std::thread::hardware_concurrency());
+	double durationSeconds = 1.0;
+
+	// The thread counts double each time, with all of the cores always the last, even if that's no power of two.
+	std::vector<int> threadCountArray;
+	for (int numThreads = 1; numThreads < maxThreads; numThreads *= 2)
+		threadCountArray.push_back(numThreads);
+	threadCountArray.push_back(maxThreads);
+
+	for (int test = 0; test < 2; test++)
+	{
+		double baseQueriesPerSecond = 0.0;
+
+		for (int numThreads : threadCountArray)
+		{
+			std::atomic<long long> totalQueries = 0;
+			std::atomic<long long> totalFound = 0;
+			std::vector<std::thread> threadArray;
+
+			for (int i = 0; i < numThreads; i++)
+			{
+				threadArray.push_back(std::thread([&tree, &pointCloud, &totalQueries, &totalFound, test, i, durationSeconds]()
+					{
+						std::mt19937 generator(i);
+						std::uniform_real_distribution<double> distribution(-10.0, 10.0);
+
+						BoundingBoxTree::TraversalStack treeStack;
+						PointCloud::QueryStack cloudStack;
+						std::vector<int> foundIndexArray;
+						long long numQueries = 0, numFound = 0;
+
+						auto startTime = std::chrono::steady_clock::now();
+						while (std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count() < durationSeconds)
+						{
+							for (int j = 0; j < 256; j++)
+							{
+								Vector3 point(distribution(generator), distribution(generator), distribution(generator));
+
+								if (test == 0)
+								{
+									AxisAlignedBoundingBox box(point);
+									box.min -= Vector3(0.5, 0.5, 0.5);
+									box.max += Vector3(0.5, 0.5, 0.5);
+
+									tree.ForOverlappingObjects(box, [&numFound](BoundingBoxTree::Object* /*object*/) -> bool
+										{
+											numFound++;
+											return true;
+										}, treeStack);
+								}
+								else
+									numFound += pointCloud.FindNearestPoints(point, 8, foundIndexArray, nullptr, cloudStack);
+							}
+
+							numQueries += 256;
+						}
+
+						totalQueries += numQueries;
+						totalFound += numFound;
+					}));
+			}
+
+			for (std::thread& thread : threadArray)
+				thread.join();
+
+			double queriesPerSecond = totalQueries / durationSeconds;
+			if (numThreads == 1)
+				baseQueriesPerSecond = queriesPerSecond;
+
+			double efficiency = queriesPerSecond / (numThreads * baseQueriesPerSecond);
+
+			printf("%s: %2d thread(s), %12.0f queries/sec, %5.1f%% efficiency, %lld found\n",
+				(test == 0) ? "BoundingBoxTree::ForOverlappingObjects" : "PointCloud::FindNearestPoints",
+				numThreads, queriesPerSecond, 100.0 * efficiency, (long long)totalFound);
+		}
+	}
+}
 
 int main(int argc, char** argv)
 {
 	using namespace MeshNinja;
 
+	if (argc > 1 && std::string(argv[1]) == "--bench-queries")
+	{
+		BenchmarkQueries();
+		return 0;
+	}
+
 	ObjFileFormat fileFormat;
 
 #if 0